@@ -0,0 +1,1249 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <bsp/bsp.h>
+#include <console/console.h>
+#include <shell/shell.h>
+#include <config/config.h>
+#include <hal/flash_map.h>
+#include <fs/fs.h>
+#include <nffs/nffs.h>
+#include <stats/stats.h>
+#include <bsp/uart_dma.h>
+#include <bsp/bsp_usec.h>
+#include <arduino_test/arduino_test.h>
+#include <arduino_test/arduino_codec.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARCH_sim
+#include <mcu/mcu_sim.h>
+#endif
+#ifdef SODAQ_AUTONOMO_SIM
+#include <bsp/sim_periph.h>
+#endif
+
+#define SHELL_TASK_PRIO (3)
+#define SHELL_MAX_INPUT_LEN     (256)
+#define SHELL_TASK_STACK_SIZE (OS_STACK_ALIGN(384))
+os_stack_t shell_stack[SHELL_TASK_STACK_SIZE];
+
+/* runs the pin operations, above every task that issues them */
+#define ARDUINO_TASK_PRIO (1)
+#define ARDUINO_TASK_STACK_SIZE (OS_STACK_ALIGN(256))
+os_stack_t arduino_stack[ARDUINO_TASK_STACK_SIZE];
+
+/* the commands run in the bench task, so its stack usage is the
+ * stack usage of the arduino command path */
+#define BENCH_TASK_PRIO (4)
+#define BENCH_TASK_STACK_SIZE (OS_STACK_ALIGN(512))
+static struct os_task bench_task;
+static os_stack_t bench_stack[BENCH_TASK_STACK_SIZE];
+
+/* a second client that preempts the bench task every tick to read
+ * either a pin the workload uses or one it does not */
+#define BENCH_CONTEND_PRIO (2)
+#define BENCH_CONTEND_STACK_SIZE (OS_STACK_ALIGN(256))
+#define BENCH_CONTEND_BURST     (8)
+static struct os_task bench_contend_task;
+static os_stack_t bench_contend_stack[BENCH_CONTEND_STACK_SIZE];
+
+enum bench_contend_mode {
+    BENCH_CONTEND_NONE,
+    BENCH_CONTEND_SAME,
+    BENCH_CONTEND_OTHER,
+};
+
+static const char * const bench_contend_names[] = 
+{
+    "none",
+    "same",
+    "other",
+};
+
+/* the pin the contender reads in each mode */
+static const char * const bench_contend_pins[] = 
+{
+    NULL,
+    "A1",
+    "A2",
+};
+
+#define BENCH_STACK_PATTERN     (0xa5a5a5a5)
+#define BENCH_DEFAULT_ITERS     (100)
+#define BENCH_MAX_ARGS          (4)
+
+/* configures one pin of every interface type */
+static const char *bench_setup[] = 
+{
+    "arduino set D4 gpio_out",
+    "arduino set D5 gpio_in",
+    "arduino set A1 adc",
+    "arduino set A2 adc",
+    "arduino set A0 dac",
+    "arduino set D8 pwm_duty",
+    "arduino set D9 pwm_freq",
+    "arduino set SPI0 spi",
+    "arduino set I2C i2c",
+};
+
+/* the workload repeated for every iteration */
+static const char *bench_loop[] = 
+{
+    "arduino write D4 1",
+    "arduino write D4 0",
+    "arduino read D4",
+    "arduino read D5",
+    "arduino read A1",
+    "arduino write A0 512",
+    "arduino read A0",
+    "arduino write D8 32768",
+    "arduino read D8",
+    "arduino write D9 440",
+    "arduino read D9",
+    "arduino write SPI0 165",
+    "arduino read SPI0",
+    "arduino write I2C 72",
+    "arduino read I2C",
+    "arduino show A1",
+    "arduino show",
+};
+
+static const char *bench_teardown[] = 
+{
+    "arduino set D4 none",
+    "arduino set D5 none",
+    "arduino set A1 none",
+    "arduino set A2 none",
+    "arduino set A0 none",
+    "arduino set D8 none",
+    "arduino set D9 none",
+    "arduino set SPI0 none",
+    "arduino set I2C none",
+};
+
+#define BENCH_NUM(x)    (sizeof(x) / sizeof((x)[0]))
+
+static const char * const bench_phase_names[ARDUINO_PHASE_MAX] = 
+{
+    "other",
+    "parse",
+    "lookup",
+    "lock",
+    "hal",
+    "format",
+    "console",
+};
+
+/* 
+ * The uart run loops the Bee UART back onto itself, on the board TX has
+ * to be wired to RX.  Several times the receive ring is sent, so the 
+ * reader has to keep up with the DMA for the data to come back intact.
+ */
+#define BENCH_UART_BYTES        (4096)
+#define BENCH_UART_CHUNK        (64)
+#define BENCH_UART_TIMEOUT_US   (100000)
+
+/* the rates "bench uart" runs at without an argument */
+static const uint32_t bench_uart_bauds[] = 
+{
+    115200,
+    460800,
+    1000000,
+};
+
+/* the macro run compiles the loop, lines that are not a pin command
+ * like show are left out of both sides */
+#define BENCH_MACRO_MAX_LEN     (256)
+
+static uint8_t bench_macro_steps[BENCH_MACRO_MAX_LEN];
+static const char *bench_macro_lines[BENCH_NUM(bench_loop)];
+
+/* the filter run pushes blocks of noisy Q15 samples through each of
+ * these, the cycle counts assume the 48 MHz core clock of the board */
+#define BENCH_FILTER_BLOCK      (64)
+#define BENCH_FILTER_BLOCKS     (256)
+#define BENCH_CPU_MHZ           (48)
+
+struct bench_filter
+{
+    const char *name;
+    int kind;
+    int param;
+    int decim;
+};
+
+static const struct bench_filter bench_filters[] =
+{
+    {"none",        ARDUINO_FILTER_NONE,    0,    1},
+    {"avg:8",       ARDUINO_FILTER_AVG,     8,    1},
+    {"avg:16:16",   ARDUINO_FILTER_AVG,     16,   16},
+    {"iir:3277",    ARDUINO_FILTER_IIR,     3277, 1},
+    {"median:5",    ARDUINO_FILTER_MEDIAN,  5,    1},
+    {"median:15",   ARDUINO_FILTER_MEDIAN,  15,   1},
+};
+
+static int16_t bench_filter_in[BENCH_FILTER_BLOCK];
+static int16_t bench_filter_out[BENCH_FILTER_BLOCK];
+static struct arduino_test_filter bench_filter_state;
+
+/* the spectrum run computes these bins over one block per iteration */
+#define BENCH_SPEC_CNT          (256)
+#define BENCH_SPEC_RATE         (8000)
+#define BENCH_SPEC_BLOCKS       (16)
+
+static const uint32_t bench_spec_freqs[] = 
+{
+    50,
+    120,
+    500,
+    2000,
+};
+
+static int16_t bench_spec_in[BENCH_SPEC_CNT];
+
+/* the scan run reads this pin as adc and as adc_scan */
+#define BENCH_SCAN_PIN          "A5"
+#define BENCH_SCAN_READS        (1000)
+
+/* the log run writes records of a sample block to the sample log and to
+ * a file in NFFS, the log is erased first */
+#define BENCH_LOG_REC           (128)
+#define BENCH_LOG_KBYTES        (4)
+#define BENCH_LOG_FILE          "/bench.log"
+
+static uint8_t bench_log_rec[BENCH_LOG_REC];
+
+/* the snapshot run: all pins read one after the other, then at once */
+#define BENCH_SNAP_READS        (100)
+
+static const struct {
+    const char *pin;
+    const char *func;
+} bench_snap_pins[] = 
+{
+    { "D2", "gpio_in" },
+    { "D3", "gpio_in" },
+    { "D4", "gpio_in" },
+    { "D5", "gpio_in" },
+    { "A1", "adc" },
+    { "A2", "adc" },
+    { "A3", "adc" },
+};
+
+/* the codec run encodes blocks of 10 bit signals and decodes them again,
+ * and compares the size with 16 bit binary and with decimal lines */
+#define BENCH_CODEC_CNT         (256)
+#define BENCH_CODEC_BLOCKS      (16)
+
+enum bench_codec_signal
+{
+    BENCH_CODEC_CONST,
+    BENCH_CODEC_SLOW,
+    BENCH_CODEC_RAMP,
+    BENCH_CODEC_NOISE,
+    BENCH_CODEC_MAX,
+};
+
+static const char * const bench_codec_names[BENCH_CODEC_MAX] = 
+{
+    "const",
+    "slow",
+    "ramp",
+    "noise",
+};
+
+static int16_t bench_codec_in[BENCH_CODEC_CNT];
+static int16_t bench_codec_out[BENCH_CODEC_CNT];
+static uint8_t bench_codec_buf[ARDUINO_CODEC_MAX_LEN(BENCH_CODEC_CNT)];
+
+static struct os_sem bench_sem;
+static int bench_iters = BENCH_DEFAULT_ITERS;
+static int bench_macro;
+static int bench_filter;
+static int bench_spectrum;
+static int bench_scan;
+static int bench_log;
+static int bench_codec;
+static int bench_snap;
+static int bench_uart;
+static uint32_t bench_uart_baud;        /* 0 runs all of bench_uart_bauds */
+static int bench_contend = BENCH_CONTEND_NONE;
+static volatile int bench_contend_pin = -1;
+static uint32_t bench_contend_ops;
+
+static int bench_cli_cmd(int argc, char **argv);
+
+static struct shell_cmd bench_cmd_struct =
+{
+    .sc_cmd = "bench",
+    .sc_cmd_func = bench_cli_cmd
+};
+
+/* splits a command like the shell does, buf holds the pieces */
+static int
+bench_split_line(const char *line, char *buf, int len, char **argv)
+{
+    char *tok;
+    int argc = 0;
+
+    strncpy(buf, line, len - 1);
+    buf[len - 1] = '\0';
+    for (tok = strtok(buf, " "); tok && argc < BENCH_MAX_ARGS; 
+         tok = strtok(NULL, " ")) {
+        argv[argc++] = tok;
+    }
+    return argc;
+}
+
+static int
+bench_run_line(const char *line)
+{
+    char buf[32];
+    char *argv[BENCH_MAX_ARGS];
+    int argc;
+
+    argc = bench_split_line(line, buf, sizeof(buf), argv);
+    return arduino_test_cmd(argc, argv);
+}
+
+static void
+bench_run_lines(const char **lines, int cnt)
+{
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        bench_run_line(lines[i]);
+    }
+}
+
+static void
+bench_stack_fill(void)
+{
+    uint32_t *sp = (uint32_t *) &sp;
+    uint32_t *end = (uint32_t *) &bench_stack[BENCH_TASK_STACK_SIZE];
+    uint32_t *p;
+
+    /* leave some room below the current frame */
+    if (sp - 32 < end) {
+        end = sp - 32;
+    }
+    for (p = (uint32_t *) bench_stack; p < end; p++) {
+        *p = BENCH_STACK_PATTERN;
+    }
+}
+
+static int
+bench_stack_used(void)
+{
+    uint32_t *p = (uint32_t *) bench_stack;
+    uint32_t *end = (uint32_t *) &bench_stack[BENCH_TASK_STACK_SIZE];
+
+    while (p < end && *p == BENCH_STACK_PATTERN) {
+        p++;
+    }
+    return (end - p) * sizeof(uint32_t);
+}
+
+static void
+bench_run(int iters)
+{
+    uint32_t start;
+    uint32_t usecs;
+    uint32_t phase_usecs;
+    uint32_t ops;
+    int i;
+
+#ifdef SODAQ_AUTONOMO_SIM
+    sim_periph_reset();
+    sim_adc_set_ramp(SODAQ_AUTONOMO_A1, 0, 7);
+    sim_i2c_add_dev(72, 0x17);
+#endif
+
+    bench_stack_fill();
+    bench_run_lines(bench_setup, BENCH_NUM(bench_setup));
+
+    arduino_test_prof_reset();
+    bench_contend_ops = 0;
+    if (bench_contend != BENCH_CONTEND_NONE) {
+        bench_contend_pin = 
+            arduino_test_pin_lookup(bench_contend_pins[bench_contend]);
+    }
+    start = bsp_usec_get32();
+    for (i = 0; i < iters; i++) {
+        bench_run_lines(bench_loop, BENCH_NUM(bench_loop));
+    }
+    usecs = bsp_usec_get32() - start;
+    bench_contend_pin = -1;
+    ops = iters * BENCH_NUM(bench_loop);
+
+    bench_run_lines(bench_teardown, BENCH_NUM(bench_teardown));
+
+    console_printf("\narduino bench: %d iterations, %lu ops in %lu usecs\n",
+                   iters, (unsigned long) ops, (unsigned long) usecs);
+    if (usecs) {
+        console_printf("  %lu ops/sec\n", 
+                       (unsigned long) ((uint64_t) ops * 1000000 / usecs));
+    }
+    console_printf("  %8s %10s %8s %6s\n", "phase", "usecs", "ns/op", "%");
+    for (i = 0; i < ARDUINO_PHASE_MAX; i++) {
+        phase_usecs = arduino_test_prof_usecs(i);
+        console_printf("  %8s %10lu %8lu %6lu\n", bench_phase_names[i],
+                (unsigned long) phase_usecs,
+                (unsigned long) ((uint64_t) phase_usecs * 1000 / ops),
+                (unsigned long) (usecs ? 
+                    (uint64_t) phase_usecs * 100 / usecs : 0));
+    }
+    console_printf("  peak stack %d of %d bytes\n", bench_stack_used(),
+                   (int) sizeof(bench_stack));
+    if (bench_contend != BENCH_CONTEND_NONE) {
+        console_printf("  contender on %s pin (%s): %lu reads\n",
+                       bench_contend_names[bench_contend],
+                       bench_contend_pins[bench_contend],
+                       (unsigned long) bench_contend_ops);
+    }
+}
+
+static void
+bench_uart_run(uint32_t baud)
+{
+    struct uart_dma *pu;
+    uint8_t buf[BENCH_UART_CHUNK];
+    uint32_t start;
+    uint32_t last;
+    uint32_t now;
+    uint32_t usecs;
+    int sent = 0;
+    int recv = 0;
+    int errors = 0;
+    int cnt;
+    int rc;
+    int i;
+
+    pu = bsp_get_uart_dma(SODAQ_AUTONOMO_BEE_UART);
+    if (pu == NULL) {
+        console_printf("\nuart bench: no DMA UART\n");
+        return;
+    }
+#ifdef SODAQ_AUTONOMO_SIM
+    sim_periph_reset();
+    sim_uart_set_loopback(1);
+#endif
+    rc = uart_dma_start(pu, baud, NULL, NULL);
+    if (rc) {
+        console_printf("\nuart bench: unable to start at %lu baud, err=%d\n",
+                       (unsigned long) baud, rc);
+        return;
+    }
+
+    start = last = bsp_usec_get32();
+    while (recv < BENCH_UART_BYTES) {
+        if (sent < BENCH_UART_BYTES) {
+            cnt = BENCH_UART_BYTES - sent;
+            if (cnt > BENCH_UART_CHUNK) {
+                cnt = BENCH_UART_CHUNK;
+            }
+            for (i = 0; i < cnt; i++) {
+                buf[i] = sent + i;
+            }
+            sent += uart_dma_write(pu, buf, cnt);
+        }
+
+        now = bsp_usec_get32();
+        cnt = uart_dma_read(pu, buf, sizeof(buf));
+        if (cnt < 0) {
+            /* the ring overran, what follows does not line up */
+            break;
+        }
+        if (cnt) {
+            for (i = 0; i < cnt; i++) {
+                if (buf[i] != (uint8_t) (recv + i)) {
+                    errors++;
+                }
+            }
+            recv += cnt;
+            last = now;
+        } else if (now - last > BENCH_UART_TIMEOUT_US) {
+            /* nothing is coming back, TX is probably not wired to RX */
+            break;
+        }
+    }
+    usecs = last - start;
+    uart_dma_stop(pu);
+
+    console_printf("\nuart bench: %lu baud, %d of %d bytes back in %lu usecs"
+                   ", %d wrong, %lu overruns\n", (unsigned long) baud, recv, 
+                   BENCH_UART_BYTES, (unsigned long) usecs, errors,
+                   (unsigned long) uart_dma_rx_overruns(pu));
+    if (usecs) {
+        /* 8N1 takes 10 bits per byte on the line */
+        console_printf("  %lu bytes/sec, line rate %lu bytes/sec\n",
+                       (unsigned long) ((uint64_t) recv * 1000000 / usecs),
+                       (unsigned long) (baud / 10));
+    }
+}
+
+static void
+bench_macro_run(int iters)
+{
+    char buf[32];
+    char *argv[BENCH_MAX_ARGS];
+    uint32_t start;
+    uint32_t line_usecs;
+    uint32_t macro_usecs;
+    uint32_t ops;
+    int nlines = 0;
+    int len = 0;
+    int argc;
+    int rc;
+    int i;
+    int j;
+
+#ifdef SODAQ_AUTONOMO_SIM
+    sim_periph_reset();
+    sim_adc_set_ramp(SODAQ_AUTONOMO_A1, 0, 7);
+    sim_i2c_add_dev(72, 0x17);
+#endif
+
+    bench_run_lines(bench_setup, BENCH_NUM(bench_setup));
+
+    for (i = 0; i < (int) BENCH_NUM(bench_loop); i++) {
+        /* without the leading "arduino" */
+        argc = bench_split_line(bench_loop[i], buf, sizeof(buf), argv);
+        rc = arduino_test_macro_compile(argc - 1, argv + 1, 
+                                        bench_macro_steps, len, 
+                                        sizeof(bench_macro_steps));
+        if (rc > 0) {
+            len = rc;
+            bench_macro_lines[nlines++] = bench_loop[i];
+        }
+    }
+
+    start = bsp_usec_get32();
+    for (i = 0; i < iters; i++) {
+        bench_run_lines(bench_macro_lines, nlines);
+    }
+    line_usecs = bsp_usec_get32() - start;
+
+    rc = 0;
+    start = bsp_usec_get32();
+    for (i = 0; i < iters && rc == 0; i++) {
+        rc = arduino_test_macro_exec(bench_macro_steps, len, &j);
+    }
+    macro_usecs = bsp_usec_get32() - start;
+
+    bench_run_lines(bench_teardown, BENCH_NUM(bench_teardown));
+
+    ops = iters * nlines;
+    console_printf("\nmacro bench: %d iterations of %d steps, %d bytes\n",
+                   iters, nlines, len);
+    if (rc) {
+        console_printf("  step %d failed, err=%d\n", j, rc);
+        return;
+    }
+    console_printf("  %8s %10s %8s\n", "", "usecs", "ops/sec");
+    console_printf("  %8s %10lu %8lu\n", "lines", (unsigned long) line_usecs,
+                   (unsigned long) (line_usecs ? 
+                       (uint64_t) ops * 1000000 / line_usecs : 0));
+    console_printf("  %8s %10lu %8lu\n", "macro", (unsigned long) macro_usecs,
+                   (unsigned long) (macro_usecs ? 
+                       (uint64_t) ops * 1000000 / macro_usecs : 0));
+}
+
+static void
+bench_filter_run(int blocks)
+{
+    const struct bench_filter *pbf;
+    uint32_t seed = 1;
+    uint32_t start;
+    uint32_t usecs;
+    uint32_t samples = (uint32_t) blocks * BENCH_FILTER_BLOCK;
+    int outs;
+    int i;
+    int j;
+
+    /* a mid scale level with noise from a linear congruential generator */
+    for (i = 0; i < BENCH_FILTER_BLOCK; i++) {
+        seed = seed * 1103515245 + 12345;
+        bench_filter_in[i] = 16384 + (int16_t) ((seed >> 16) & 0xfff) - 2048;
+    }
+
+    console_printf("\nfilter bench: %lu samples each\n", 
+                   (unsigned long) samples);
+    console_printf("  %10s %8s %8s %8s %8s\n", "filter", "usecs", "ns/smp", 
+                   "cyc/smp", "outputs");
+    for (i = 0; i < (int) BENCH_NUM(bench_filters); i++) {
+        pbf = &bench_filters[i];
+        arduino_test_filter_init(&bench_filter_state, pbf->kind, pbf->param,
+                                 pbf->decim);
+        outs = 0;
+        start = bsp_usec_get32();
+        for (j = 0; j < blocks; j++) {
+            outs += arduino_test_filter_run(&bench_filter_state, 
+                                            bench_filter_in, 
+                                            BENCH_FILTER_BLOCK,
+                                            bench_filter_out);
+        }
+        usecs = bsp_usec_get32() - start;
+        console_printf("  %10s %8lu %8lu %8lu %8d\n", pbf->name, 
+                (unsigned long) usecs,
+                (unsigned long) ((uint64_t) usecs * 1000 / samples),
+                (unsigned long) ((uint64_t) usecs * BENCH_CPU_MHZ / samples),
+                outs);
+    }
+}
+
+static void
+bench_spectrum_run(int blocks)
+{
+    uint32_t start;
+    uint32_t usecs;
+    int32_t amp[BENCH_NUM(bench_spec_freqs)];
+    int i;
+    int j;
+
+    /* a square wave at 500 Hz, it has lines at the odd harmonics */
+    for (i = 0; i < BENCH_SPEC_CNT; i++) {
+        bench_spec_in[i] = (i & 8) ? 1000 : -1000;
+    }
+
+    start = bsp_usec_get32();
+    for (i = 0; i < blocks; i++) {
+        for (j = 0; j < (int) BENCH_NUM(bench_spec_freqs); j++) {
+            amp[j] = arduino_test_goertzel(bench_spec_in, BENCH_SPEC_CNT, 
+                                        bench_spec_freqs[j], BENCH_SPEC_RATE);
+        }
+    }
+    usecs = bsp_usec_get32() - start;
+
+    console_printf("\nspectrum bench: %d blocks of %d samples, %d bins\n",
+                   blocks, BENCH_SPEC_CNT, (int) BENCH_NUM(bench_spec_freqs));
+    console_printf("  %lu usecs, %lu usecs and %lu cycles per block\n",
+                   (unsigned long) usecs, (unsigned long) (usecs / blocks),
+                   (unsigned long) ((uint64_t) usecs * BENCH_CPU_MHZ / blocks));
+    for (j = 0; j < (int) BENCH_NUM(bench_spec_freqs); j++) {
+        console_printf("  %6lu Hz %6ld\n", 
+                       (unsigned long) bench_spec_freqs[j], (long) amp[j]);
+    }
+}
+
+/* times reads of one pin, returns the usecs they took and the sum of 
+ * the ages of the values in ages */
+static uint32_t
+bench_scan_reads(int entry_id, int reads, uint64_t *ages)
+{
+    uint32_t start;
+    uint32_t stamp;
+    int value;
+    int i;
+
+    *ages = 0;
+    start = bsp_usec_get32();
+    for (i = 0; i < reads; i++) {
+        if (arduino_test_read_stamped(entry_id, &value, &stamp)) {
+            return 0;
+        }
+        *ages += bsp_usec_get32() - stamp;
+    }
+    return bsp_usec_get32() - start;
+}
+
+static void
+bench_scan_run(int reads)
+{
+    int entry_id = arduino_test_pin_lookup(BENCH_SCAN_PIN);
+    uint32_t conv_usecs;
+    uint32_t scan_usecs;
+    uint64_t ages;
+    uint64_t scan_ages;
+    int value;
+    uint32_t stamp;
+    int i;
+
+#ifdef SODAQ_AUTONOMO_SIM
+    sim_periph_reset();
+    sim_adc_set_ramp(SODAQ_AUTONOMO_A5, 0, 3);
+#endif
+    bench_run_line("arduino set " BENCH_SCAN_PIN " adc");
+    conv_usecs = bench_scan_reads(entry_id, reads, &ages);
+    bench_run_line("arduino set " BENCH_SCAN_PIN " none");
+
+    bench_run_line("arduino set " BENCH_SCAN_PIN " adc_scan");
+    /* the first pass has to end before there is a value */
+    for (i = 0; i < 100; i++) {
+#ifdef SODAQ_AUTONOMO_SIM
+        sim_adc_convert(1);
+#endif
+        if (!arduino_test_read_stamped(entry_id, &value, &stamp)) {
+            break;
+        }
+        os_time_delay(1);
+    }
+    scan_usecs = bench_scan_reads(entry_id, reads, &scan_ages);
+    bench_run_line("arduino set " BENCH_SCAN_PIN " none");
+
+    console_printf("\nscan bench: %d reads of %s\n", reads, BENCH_SCAN_PIN);
+    console_printf("  %10s %8s %8s %8s\n", "function", "usecs", "ns/read", 
+                   "age us");
+    console_printf("  %10s %8lu %8lu %8lu\n", "adc", 
+                   (unsigned long) conv_usecs, 
+                   (unsigned long) (conv_usecs * 1000 / reads),
+                   (unsigned long) (ages / reads));
+    console_printf("  %10s %8lu %8lu %8lu\n", "adc_scan", 
+                   (unsigned long) scan_usecs, 
+                   (unsigned long) (scan_usecs * 1000 / reads),
+                   (unsigned long) (scan_ages / reads));
+}
+
+/* 
+ * The spread is from the first to the last read of a pass over the pins.
+ * For the snapshot it is from the port read to the start of the ADC 
+ * pass, which itself takes a few usecs per input.
+ */
+static void
+bench_snap_set(const char *func)
+{
+    char line[32];
+    int i;
+
+    for (i = 0; i < (int) BENCH_NUM(bench_snap_pins); i++) {
+        snprintf(line, sizeof(line), "arduino set %s %s", 
+                 bench_snap_pins[i].pin, func ? func : 
+                 bench_snap_pins[i].func);
+        bench_run_line(line);
+    }
+}
+
+static void
+bench_snap_run(int reads)
+{
+    uint8_t rec[ARDUINO_CODEC_SNAPSHOT_MAX];
+    struct arduino_codec_snapshot snap;
+    int entries[BENCH_NUM(bench_snap_pins)];
+    int after[BENCH_NUM(bench_snap_pins)];
+    uint32_t seq_usecs;
+    uint32_t snap_usecs;
+    uint32_t seq_max = 0;
+    uint32_t snap_max = 0;
+    uint64_t seq_sum = 0;
+    uint64_t snap_sum = 0;
+    uint32_t first = 0;
+    uint32_t stamp = 0;
+    uint32_t start;
+    uint32_t spread;
+    int value;
+    int len = 0;
+    int rc = 0;
+    int i;
+    int j;
+
+#ifdef SODAQ_AUTONOMO_SIM
+    sim_periph_reset();
+    sim_adc_set_ramp(SODAQ_AUTONOMO_A1, 0, 1);
+    sim_adc_set_ramp(SODAQ_AUTONOMO_A2, 100, 3);
+    sim_adc_set_const(SODAQ_AUTONOMO_A3, 512);
+#endif
+    bench_snap_set(NULL);
+    for (i = 0; i < (int) BENCH_NUM(bench_snap_pins); i++) {
+        entries[i] = arduino_test_pin_lookup(bench_snap_pins[i].pin);
+    }
+
+    start = bsp_usec_get32();
+    for (i = 0; i < reads && !rc; i++) {
+        for (j = 0; j < (int) BENCH_NUM(entries) && !rc; j++) {
+            rc = arduino_test_read_stamped(entries[j], &value, &stamp);
+            if (j == 0) {
+                first = stamp;
+            }
+        }
+        spread = stamp - first;
+        seq_sum += spread;
+        if (spread > seq_max) {
+            seq_max = spread;
+        }
+    }
+    seq_usecs = bsp_usec_get32() - start;
+
+    start = bsp_usec_get32();
+    for (i = 0; i < reads && !rc; i++) {
+        len = arduino_test_snapshot(rec, sizeof(rec));
+        if (len < 0 || arduino_codec_decode_snapshot(rec, len, &snap) < 0) {
+            rc = -1;
+            break;
+        }
+        spread = snap.adc_delta < 0 ? -snap.adc_delta : snap.adc_delta;
+        snap_sum += spread;
+        if (spread > snap_max) {
+            snap_max = spread;
+        }
+    }
+    snap_usecs = bsp_usec_get32() - start;
+
+    /* the snapshot borrows the ADC, the pins must read as it did */
+    for (j = 0; j < (int) BENCH_NUM(entries) && !rc; j++) {
+        rc = arduino_test_read_stamped(entries[j], &after[j], &stamp);
+    }
+    bench_snap_set("none");
+
+    if (rc) {
+        console_printf("snap bench: a read failed, err=%d\n", rc);
+        return;
+    }
+    console_printf("\nsnap bench: %d reads of %d pins, record %d bytes\n", 
+                   reads, (int) BENCH_NUM(bench_snap_pins), len);
+    console_printf("  %10s %8s %8s %10s %8s\n", "method", "usecs", 
+                   "us/pass", "spread us", "max us");
+    console_printf("  %10s %8lu %8lu %10lu %8lu\n", "one by one", 
+                   (unsigned long) seq_usecs, 
+                   (unsigned long) (seq_usecs / reads),
+                   (unsigned long) (seq_sum / reads), 
+                   (unsigned long) seq_max);
+    console_printf("  %10s %8lu %8lu %10lu %8lu\n", "snapshot", 
+                   (unsigned long) snap_usecs, 
+                   (unsigned long) (snap_usecs / reads),
+                   (unsigned long) (snap_sum / reads), 
+                   (unsigned long) snap_max);
+    /* the adc pins come in entry order in the snapshot, as in the 
+     * table, at 12 bits against the 10 of a read */
+    for (i = 0, j = 0; j < (int) BENCH_NUM(entries); j++) {
+        if (strcmp(bench_snap_pins[j].func, "adc")) {
+            continue;
+        }
+        value = after[j] - (snap.adc[i] >> 2);
+        if (value < 0) {
+            value = -value;
+        }
+        console_printf("  %s reads %d after the last snapshot, which had "
+                       "%d%s\n", bench_snap_pins[j].pin, after[j], 
+                       snap.adc[i] >> 2, 
+                       value > after[j] / 8 + 8 ? ", DIFFERENT" : "");
+        i++;
+    }
+}
+
+static void
+bench_log_report(const char *name, int bytes, uint32_t usecs, 
+                 uint32_t worst)
+{
+    console_printf("  %8s %8d %10lu %10lu %8lu\n", name, bytes, 
+                   (unsigned long) usecs, 
+                   (unsigned long) (usecs ? (uint64_t) bytes * 1000000 / 
+                                            usecs : 0),
+                   (unsigned long) worst);
+}
+
+static void
+bench_log_run(int kbytes)
+{
+    struct fs_file *file;
+    uint32_t start;
+    uint32_t rec_start;
+    uint32_t usecs;
+    uint32_t worst;
+    int recs = kbytes * 1024 / BENCH_LOG_REC;
+    int bytes;
+    int rc;
+    int i;
+
+    for (i = 0; i < BENCH_LOG_REC; i++) {
+        bench_log_rec[i] = i * 7;
+    }
+
+    console_printf("\nlog bench: %d records of %d bytes\n", recs, 
+                   BENCH_LOG_REC);
+    console_printf("  %8s %8s %10s %10s %8s\n", "target", "bytes", "usecs", 
+                   "bytes/s", "worst us");
+
+    rc = arduino_test_log_erase();
+    if (rc) {
+        console_printf("  no sample log, err=%d\n", rc);
+    } else {
+        worst = 0;
+        bytes = 0;
+        start = bsp_usec_get32();
+        for (i = 0; i < recs; i++) {
+            rec_start = bsp_usec_get32();
+            rc = arduino_test_log_append(bench_log_rec, BENCH_LOG_REC);
+            if (rc) {
+                break;
+            }
+            bytes += BENCH_LOG_REC;
+            usecs = bsp_usec_get32() - rec_start;
+            if (usecs > worst) {
+                worst = usecs;
+            }
+        }
+        arduino_test_log_flush();
+        usecs = bsp_usec_get32() - start;
+        bench_log_report("log", bytes, usecs, worst);
+    }
+
+    fs_unlink(BENCH_LOG_FILE);
+    rc = fs_open(BENCH_LOG_FILE, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, 
+                 &file);
+    if (rc) {
+        console_printf("  no NFFS, err=%d\n", rc);
+        return;
+    }
+    worst = 0;
+    bytes = 0;
+    start = bsp_usec_get32();
+    for (i = 0; i < recs; i++) {
+        rec_start = bsp_usec_get32();
+        rc = fs_write(file, bench_log_rec, BENCH_LOG_REC);
+        if (rc) {
+            break;
+        }
+        bytes += BENCH_LOG_REC;
+        usecs = bsp_usec_get32() - rec_start;
+        if (usecs > worst) {
+            worst = usecs;
+        }
+    }
+    fs_close(file);
+    usecs = bsp_usec_get32() - start;
+    bench_log_report("nffs", bytes, usecs, worst);
+    if (rc) {
+        console_printf("  NFFS stopped after %d bytes, err=%d\n", bytes, rc);
+    }
+    fs_unlink(BENCH_LOG_FILE);
+}
+
+static void
+bench_codec_fill(int signal)
+{
+    uint32_t seed = 12345;
+    int tri;
+    int i;
+
+    for (i = 0; i < BENCH_CODEC_CNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        switch (signal) {
+            case BENCH_CODEC_CONST:
+                bench_codec_in[i] = 512;
+                break;
+            case BENCH_CODEC_SLOW:
+                /* a triangle over 64 samples with 2 bits of noise */
+                tri = i & 63;
+                tri = tri < 32 ? tri : 64 - tri;
+                bench_codec_in[i] = 400 + tri * 6 + ((seed >> 16) & 3);
+                break;
+            case BENCH_CODEC_RAMP:
+                bench_codec_in[i] = (i * 37) & 1023;
+                break;
+            default:
+                bench_codec_in[i] = (seed >> 16) & 1023;
+                break;
+        }
+    }
+}
+
+/* the bytes of the samples as "%d\n" lines */
+static int
+bench_codec_text_len(void)
+{
+    int len = 0;
+    int v;
+    int i;
+
+    for (i = 0; i < BENCH_CODEC_CNT; i++) {
+        v = bench_codec_in[i];
+        len += 2;
+        while (v >= 10) {
+            len++;
+            v /= 10;
+        }
+    }
+    return len;
+}
+
+static void
+bench_codec_run(int blocks)
+{
+    struct arduino_codec_hdr hdr;
+    uint32_t start;
+    uint32_t enc_usecs;
+    uint32_t dec_usecs;
+    uint32_t raw_x100;
+    uint32_t text_x100;
+    int text_len;
+    int len = 0;
+    int ok;
+    int signal;
+    int i;
+
+    hdr.entry_id = arduino_test_pin_lookup("A1");
+    hdr.cnt = BENCH_CODEC_CNT;
+    hdr.stamp = 0x12345678;
+    hdr.period = 125;
+
+    console_printf("\ncodec bench: %d blocks of %d samples\n", blocks, 
+                   BENCH_CODEC_CNT);
+    console_printf("  %6s %6s %8s %8s %8s %8s %4s\n", "signal", "bytes", 
+                   "vs bin", "vs text", "enc ns", "dec ns", "rt");
+    for (signal = 0; signal < BENCH_CODEC_MAX; signal++) {
+        bench_codec_fill(signal);
+
+        start = bsp_usec_get32();
+        for (i = 0; i < blocks; i++) {
+            len = arduino_codec_encode(&hdr, bench_codec_in, bench_codec_buf,
+                                       sizeof(bench_codec_buf));
+        }
+        enc_usecs = bsp_usec_get32() - start;
+
+        ok = len > 0;
+        start = bsp_usec_get32();
+        for (i = 0; i < blocks && ok; i++) {
+            ok = arduino_codec_decode(bench_codec_buf, len, &hdr, 
+                                      bench_codec_out, BENCH_CODEC_CNT) == len;
+        }
+        dec_usecs = bsp_usec_get32() - start;
+        /* the round trip gives back every sample */
+        if (ok) {
+            ok = !memcmp(bench_codec_in, bench_codec_out, 
+                         sizeof(bench_codec_in));
+        }
+        if (len <= 0) {
+            len = 1;
+        }
+
+        text_len = bench_codec_text_len();
+        raw_x100 = BENCH_CODEC_CNT * 2 * 100 / len;
+        text_x100 = text_len * 100 / len;
+        console_printf("  %6s %6d %5lu.%02lu %5lu.%02lu %8lu %8lu %4s\n", 
+                       bench_codec_names[signal], len, 
+                       (unsigned long) (raw_x100 / 100), 
+                       (unsigned long) (raw_x100 % 100),
+                       (unsigned long) (text_x100 / 100), 
+                       (unsigned long) (text_x100 % 100),
+                       (unsigned long) ((uint64_t) enc_usecs * 1000 / 
+                                        (blocks * BENCH_CODEC_CNT)),
+                       (unsigned long) ((uint64_t) dec_usecs * 1000 / 
+                                        (blocks * BENCH_CODEC_CNT)),
+                       ok ? "ok" : "FAIL");
+    }
+}
+
+/* 
+ * wakes up every tick while a run is in progress and reads its pin
+ * a few times. Reading the same pin as the bench loop makes the two 
+ * tasks meet on that pin's lock, which shows up in the "lock" phase.
+ */
+static void
+bench_contend_handler(void *arg)
+{
+    int pin;
+    int mv;
+    int i;
+
+    while (1) {
+        pin = bench_contend_pin;
+        if (pin >= 0) {
+            for (i = 0; i < BENCH_CONTEND_BURST; i++) {
+                arduino_test_read_mv(pin, &mv);
+            }
+            bench_contend_ops += BENCH_CONTEND_BURST;
+        }
+        os_time_delay(1);
+    }
+}
+
+static void
+bench_task_handler(void *arg)
+{
+    int i;
+
+    while (1) {
+        os_sem_pend(&bench_sem, OS_WAIT_FOREVER);
+        if (bench_snap) {
+            bench_snap_run(bench_iters);
+        } else if (bench_codec) {
+            bench_codec_run(bench_iters);
+        } else if (bench_log) {
+            bench_log_run(bench_iters);
+        } else if (bench_scan) {
+            bench_scan_run(bench_iters);
+        } else if (bench_spectrum) {
+            bench_spectrum_run(bench_iters);
+        } else if (bench_filter) {
+            bench_filter_run(bench_iters);
+        } else if (bench_macro) {
+            bench_macro_run(bench_iters);
+        } else if (!bench_uart) {
+            bench_run(bench_iters);
+        } else if (bench_uart_baud) {
+            bench_uart_run(bench_uart_baud);
+        } else {
+            for (i = 0; i < (int) BENCH_NUM(bench_uart_bauds); i++) {
+                bench_uart_run(bench_uart_bauds[i]);
+            }
+        }
+    }
+}
+
+static int
+bench_cli_cmd(int argc, char **argv)
+{
+    int i;
+
+    bench_uart = argc > 1 && !strcmp(argv[1], "uart");
+    if (bench_uart) {
+        bench_uart_baud = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+        os_sem_release(&bench_sem);
+        return 0;
+    }
+    bench_macro = argc > 1 && !strcmp(argv[1], "macro");
+    bench_filter = argc > 1 && !strcmp(argv[1], "filter");
+    bench_spectrum = argc > 1 && !strcmp(argv[1], "spectrum");
+    bench_scan = argc > 1 && !strcmp(argv[1], "scan");
+    bench_log = argc > 1 && !strcmp(argv[1], "log");
+    bench_codec = argc > 1 && !strcmp(argv[1], "codec");
+    bench_snap = argc > 1 && !strcmp(argv[1], "snap");
+    if (bench_macro || bench_filter || bench_spectrum || bench_scan || 
+        bench_log || bench_codec || bench_snap) {
+        argc--;
+        argv++;
+    }
+    if (argc > 1) {
+        bench_iters = atoi(argv[1]);
+        if (bench_iters <= 0) {
+            bench_iters = BENCH_DEFAULT_ITERS;
+        }
+    } else if (bench_filter) {
+        bench_iters = BENCH_FILTER_BLOCKS;
+    } else if (bench_spectrum) {
+        bench_iters = BENCH_SPEC_BLOCKS;
+    } else if (bench_scan) {
+        bench_iters = BENCH_SCAN_READS;
+    } else if (bench_log) {
+        bench_iters = BENCH_LOG_KBYTES;
+    } else if (bench_codec) {
+        bench_iters = BENCH_CODEC_BLOCKS;
+    } else if (bench_snap) {
+        bench_iters = BENCH_SNAP_READS;
+    }
+    bench_contend = BENCH_CONTEND_NONE;
+    if (argc > 2) {
+        for (i = 0; i < (int) BENCH_NUM(bench_contend_names); i++) {
+            if (!strcmp(argv[2], bench_contend_names[i])) {
+                bench_contend = i;
+            }
+        }
+    }
+    os_sem_release(&bench_sem);
+    return 0;
+}
+
+/**
+ * bench_setup_nffs
+ *
+ * Mounts NFFS on the BSP's NFFS flash area for the log run, formatting
+ * it if there is no valid file system yet.
+ */
+static void
+bench_setup_nffs(void)
+{
+    /* NFFS_AREA_MAX is defined in the BSP-specified bsp.h header file. */
+    struct nffs_area_desc descs[NFFS_AREA_MAX + 1];
+    int cnt;
+    int rc;
+
+    rc = nffs_init();
+    assert(rc == 0);
+
+    cnt = NFFS_AREA_MAX;
+    rc = flash_area_to_nffs_desc(FLASH_AREA_NFFS, &cnt, descs);
+    assert(rc == 0);
+
+    if (nffs_detect(descs) == FS_ECORRUPT) {
+        rc = nffs_format(descs);
+        assert(rc == 0);
+    }
+}
+
+/**
+ * main
+ *
+ * Runs the arduino command benchmark once at startup. The 
+ * "bench [iters] [none|same|other]" shell command runs it again, 
+ * optionally with a second task reading the same or another pin.
+ * "bench uart [baud]" measures the DMA UART looped back on itself.
+ * "bench macro [iters]" compares the loop sent as command lines with
+ * the same commands compiled into a macro, "bench filter [blocks]" 
+ * times the pin filters per sample and "bench spectrum [blocks]" the
+ * Goertzel bins per block. "bench scan [reads]" compares reads of an 
+ * adc pin with those of the same pin in the background scan, and
+ * "bench log [kbytes]" the write rate of the sample log with NFFS.
+ * "bench codec [blocks]" checks the sample encoding round trip and 
+ * reports its size and speed. "bench snap [reads]" compares reading 
+ * all pins one by one with one snapshot of them.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    int rc;
+
+#ifdef ARCH_sim
+    mcu_sim_parse_args(argc, argv);
+#endif
+
+    os_init();
+
+    rc = conf_init();
+    assert(rc == 0);
+
+    shell_task_init(SHELL_TASK_PRIO, shell_stack, SHELL_TASK_STACK_SIZE,
+                    SHELL_MAX_INPUT_LEN);
+
+    (void) console_init(shell_console_rx_cb);
+
+    rc = stats_module_init();
+    assert(rc == 0);
+
+    bench_setup_nffs();
+
+    rc = arduino_test_init();
+    assert(rc == 0);
+
+    rc = arduino_test_task_init(ARDUINO_TASK_PRIO, arduino_stack,
+                                ARDUINO_TASK_STACK_SIZE);
+    assert(rc == 0);
+
+    shell_cmd_register(&bench_cmd_struct);
+
+    /* start with one run */
+    os_sem_init(&bench_sem, 1);
+    os_task_init(&bench_task, "bench", bench_task_handler, NULL,
+                 BENCH_TASK_PRIO, OS_WAIT_FOREVER, bench_stack, 
+                 BENCH_TASK_STACK_SIZE);
+    os_task_init(&bench_contend_task, "contend", bench_contend_handler, NULL,
+                 BENCH_CONTEND_PRIO, OS_WAIT_FOREVER, bench_contend_stack,
+                 BENCH_CONTEND_STACK_SIZE);
+
+    os_start();
+
+    /* os start should never return. If it does, this should be an error */
+    assert(0);
+
+    return rc;
+}
@@ -22,6 +22,11 @@
 #include <shell/shell.h>
 #include <log/log.h>
 #include <config/config.h>
+#include <config/config_file.h>
+#include <hal/flash_map.h>
+#include <fs/fs.h>
+#include <nffs/nffs.h>
+#include <stats/stats.h>
 #include <newtmgr/newtmgr.h>
 #include <arduino_test/arduino_test.h>
 #include <assert.h>
@@ -44,6 +49,56 @@ os_stack_t shell_stack[SHELL_TASK_STACK_SIZE];
 #define NEWTMGR_TASK_STACK_SIZE (OS_STACK_ALIGN(512))
 os_stack_t newtmgr_stack[NEWTMGR_TASK_STACK_SIZE];
 
+/* runs the pin operations, above every task that issues them */
+#define ARDUINO_TASK_PRIO (1)
+#define ARDUINO_TASK_STACK_SIZE (OS_STACK_ALIGN(256))
+os_stack_t arduino_stack[ARDUINO_TASK_STACK_SIZE];
+
+/* reads the aggregated pins, below the shell and newtmgr */
+#define ARDUINO_AGG_TASK_PRIO (5)
+#define ARDUINO_AGG_TASK_STACK_SIZE (OS_STACK_ALIGN(256))
+os_stack_t arduino_agg_stack[ARDUINO_AGG_TASK_STACK_SIZE];
+
+#define ARDUINO_TEST_CONF_FILE  "/cfg/run"
+
+static struct conf_file arduino_test_conf_file = {
+    .cf_name = ARDUINO_TEST_CONF_FILE,
+    .cf_maxlines = 32
+};
+
+/**
+ * setup_for_nffs
+ *
+ * Mounts NFFS on the BSP's NFFS flash area, formatting it if there is no
+ * valid file system yet, and keeps the config in a file there.
+ */
+static void
+setup_for_nffs(void)
+{
+    /* NFFS_AREA_MAX is defined in the BSP-specified bsp.h header file. */
+    struct nffs_area_desc descs[NFFS_AREA_MAX + 1];
+    int cnt;
+    int rc;
+
+    rc = nffs_init();
+    assert(rc == 0);
+
+    cnt = NFFS_AREA_MAX;
+    rc = flash_area_to_nffs_desc(FLASH_AREA_NFFS, &cnt, descs);
+    assert(rc == 0);
+
+    if (nffs_detect(descs) == FS_ECORRUPT) {
+        rc = nffs_format(descs);
+        assert(rc == 0);
+    }
+
+    fs_mkdir("/cfg");
+    rc = conf_file_src(&arduino_test_conf_file);
+    assert(rc == 0);
+    rc = conf_file_dst(&arduino_test_conf_file);
+    assert(rc == 0);
+}
+
 /**
  * init_tasks
  *
@@ -79,6 +134,9 @@ main(int argc, char **argv)
     
     os_init();
 
+    rc = conf_init();
+    assert(rc == 0);
+
     shell_task_init(SHELL_TASK_PRIO, shell_stack, SHELL_TASK_STACK_SIZE,
                     SHELL_MAX_INPUT_LEN);
 
@@ -86,9 +144,24 @@ main(int argc, char **argv)
 
     nmgr_task_init(NEWTMGR_TASK_PRIO, newtmgr_stack, NEWTMGR_TASK_STACK_SIZE);
 
+    /* makes the arduino pin statistics visible in shell and newtmgr */
+    rc = stats_module_init();
+    assert(rc == 0);
+
+    setup_for_nffs();
+
+    /* also restores the pin setup saved in the config */
     rc = arduino_test_init();
     assert(rc == 0);
 
+    rc = arduino_test_task_init(ARDUINO_TASK_PRIO, arduino_stack,
+                                ARDUINO_TASK_STACK_SIZE);
+    assert(rc == 0);
+
+    rc = arduino_test_agg_task_init(ARDUINO_AGG_TASK_PRIO, arduino_agg_stack,
+                                    ARDUINO_AGG_TASK_STACK_SIZE);
+    assert(rc == 0);
+
     rc = init_tasks();
     os_start();
 
@@ -0,0 +1,90 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ACMP_H__
+#define __ACMP_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Analog comparators.  There are two, each compares a pin against a
+ * reference continuously and its output follows the input within a
+ * microsecond, there are no conversions involved.  The comparator 
+ * inputs are on A3, A4, D8 and D9.
+ *
+ * The output either interrupts the CPU on every change or drives an 
+ * EVSYS event, for example to start a triggered ADC conversion.
+ */
+
+enum acmp_ref
+{
+    ACMP_REF_SCALE = 0,     /* VDDANA * (scale + 1) / 64 */
+    ACMP_REF_BANDGAP,       /* the 1.1 V bandgap */
+    ACMP_REF_DAC,           /* the DAC output */
+};
+
+enum acmp_out
+{
+    ACMP_OUT_IRQ = 0,       /* cb is called on every change */
+    ACMP_OUT_EVENT,         /* every change is an EVSYS event, no irq */
+};
+
+#define ACMP_SCALE_MAX      (63)
+#define ACMP_VDD_MV         (3300)
+#define ACMP_BANDGAP_MV     (1100)
+
+/* called in interrupt context with the new output, 1 when the pin is
+ * above the reference */
+typedef void (*acmp_cb)(void *arg, int state);
+
+struct acmp_cfg
+{
+    enum acmp_ref ref;
+    uint8_t scale;          /* 0..ACMP_SCALE_MAX for ACMP_REF_SCALE */
+    uint8_t hyst;           /* 1 enables about 50 mV of hysteresis */
+    enum acmp_out out;
+    acmp_cb cb;
+    void *arg;
+};
+
+/* returns the comparator open on a pin, or -1 */
+int acmp_of(enum system_device_id pin);
+
+/* starts comparing the pin, returns the comparator, -1 for a bad pin 
+ * or config and -2 if both comparators are in use */
+int acmp_open(enum system_device_id pin, const struct acmp_cfg *cfg);
+
+/* changes the reference, hysteresis or output of a running comparator */
+int acmp_config(int comp, const struct acmp_cfg *cfg);
+
+/* returns the output of the comparator */
+int acmp_state(int comp);
+
+int acmp_close(int comp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ACMP_H__ */
@@ -0,0 +1,75 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ADC_CAL_H__
+#define __ADC_CAL_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * ADC calibration.  The linearity and bias values the factory wrote to
+ * the NVM calibration row are loaded whenever the ADC is set up.  On top
+ * of that a gain and offset correction, usually found by measuring two
+ * known voltages, is programmed into the OFFSETCORR and GAINCORR 
+ * registers.  The ADC applies it to every conversion itself, so 
+ * corrected samples cost no CPU, also for the triggered and window 
+ * drivers.
+ *
+ * The correction works on 12 bit counts whatever the resolution of the
+ * channel: result = (raw - offset) * gain.
+ */
+
+/* a gain of 1.0, the gain is unsigned 1.11 fixed point */
+#define ADC_CAL_GAIN_ONE    (2048)
+#define ADC_CAL_GAIN_MIN    (1024)
+#define ADC_CAL_GAIN_MAX    (4095)
+#define ADC_CAL_OFFSET_MIN  (-2048)
+#define ADC_CAL_OFFSET_MAX  (2047)
+
+struct adc_cal
+{
+    int16_t  offset;        /* in 12 bit counts, subtracted first */
+    uint16_t gain;          /* then multiplied by gain / 2048 */
+};
+
+/* finds the correction that turns the raw counts raw1 and raw2 into 
+ * want1 and want2, all 12 bit counts.  Returns -1 if the points are too
+ * close or the correction is out of range of the registers */
+int adc_cal_from_points(int raw1, int want1, int raw2, int want2,
+                        struct adc_cal *cal);
+
+/* programs the correction, NULL or a gain of one and no offset turns it
+ * off.  Returns -2 if the ADC is owned by a running driver */
+int adc_cal_set(const struct adc_cal *cal);
+
+/* the correction in use, a gain of one and no offset when it is off */
+void adc_cal_get(struct adc_cal *cal);
+
+/* the factory linearity and bias values from the NVM calibration row */
+void adc_cal_factory(int *linearity, int *bias);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_CAL_H__ */
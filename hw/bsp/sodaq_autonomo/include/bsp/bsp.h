@@ -46,8 +46,16 @@ extern "C" {
  * your max is less than the number of sectors then the NFFS will combine
  * multiple sectors into an NFFS area */
 #define NFFS_AREA_MAX    (8)
+
+/* the flash area of the raw sample log, after the Mynewt ones */
+#define FLASH_AREA_SAMPLE_LOG   (5)
     
 int bsp_imgr_current_slot(void);
+
+/* returns 1 while adc_scan, adc_window, adc_tick, adc_trig or a pin 
+ * snapshot owns the ADC.  The HAL adc channels must not be created or 
+ * read then, both program the ADC */
+int bsp_adc_busy(void);
 #ifdef __cplusplus
 }
 #endif
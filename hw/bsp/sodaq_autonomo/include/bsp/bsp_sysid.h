@@ -61,6 +61,9 @@ enum system_device_id
     /* a I2c port on SCLK and SDA */
     SODAQ_AUTONOMO_I2C      = 202,
 
+    /* the UART of the Bee socket */
+    SODAQ_AUTONOMO_BEE_UART = 203,
+
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,74 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BSP_USEC_H__
+#define __BSP_USEC_H__
+
+#include <stdint.h>
+#include "mcu/samd21.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Free running microsecond clock on TC6 and TC7 chained as one 32 bit 
+ * counter. The count is continuously synchronized, so reading it is a
+ * single register read.  It wraps after about 71 minutes; the 64 bit 
+ * version adds a software count of the wraps.
+ */
+
+/* started by os_bsp_init() */
+int bsp_usec_init(void);
+
+static inline uint32_t
+bsp_usec_get32(void)
+{
+    return TC6->COUNT32.COUNT.reg;
+}
+
+uint64_t bsp_usec_get64(void);
+
+/* one alarm on the clock for the BSP drivers, func is called in 
+ * interrupt context once the count reaches at.  Setting it again 
+ * replaces the previous alarm */
+typedef void (*bsp_usec_alarm_func)(void *arg);
+
+void bsp_usec_alarm_set(uint32_t at, bsp_usec_alarm_func func, void *arg);
+void bsp_usec_alarm_stop(void);
+
+/* a periodic interrupt on the second compare channel, apart from the 
+ * alarm.  func is called in interrupt context every period usecs with 
+ * the count the tick was due at, so it can tell how late it runs.  The
+ * ticks are kept on the clock and do not drift, ticks the interrupt was
+ * held off past are skipped and counted.  Every tick is also an event
+ * on the EVSYS generator of the TC6 second compare */
+#define BSP_USEC_TICK_MIN   (50)
+
+typedef void (*bsp_usec_tick_func)(void *arg, uint32_t due);
+
+int bsp_usec_tick_start(uint32_t period, bsp_usec_tick_func func, void *arg);
+void bsp_usec_tick_stop(void);
+uint32_t bsp_usec_tick_missed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BSP_USEC_H__ */
@@ -0,0 +1,57 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __PIN_SNAP_H__
+#define __PIN_SNAP_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Reads of many pins taken at one instant.  The digital levels come from
+ * one read of the IN register of each port, PORTA only unless an analog
+ * pin on PORTB is among them.  The analog pins are converted in one scan
+ * of the ADC over the inputs from the lowest to the highest, one 
+ * conversion each with interrupts off, about 70 us for all six.  Values
+ * are raw 12 bit counts as from bsp/adc_scan.h.
+ */
+
+#define PIN_SNAP_ADC_BITS   (12)
+#define PIN_SNAP_ADC_MAX    (6)
+
+/* reads the level of cnt gpio pins, bit i of *levels is pins[i], and the
+ * bsp_usec_get32() time of the read.  Returns -1 for a bad pin */
+int pin_snap_gpio(const int *pins, int cnt, uint32_t *levels, 
+                  uint32_t *stamp);
+
+/* converts cnt analog pins in one pass into values, in the order of 
+ * pins, stamp gets the bsp_usec_get32() time the pass started.  Returns
+ * -1 for a bad pin and -2 if the ADC is in use by another driver */
+int pin_snap_adc(const enum system_device_id *pins, int cnt, int *values,
+                 uint32_t *stamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PIN_SNAP_H__ */
@@ -0,0 +1,89 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __UART_DMA_H__
+#define __UART_DMA_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * UART with DMA on both directions.  Received bytes are written by the 
+ * DMA into a circular buffer without interrupts, the reader has to take
+ * them out before UART_DMA_RX_SIZE more bytes arrive.  Written bytes are
+ * copied into a transmit ring and sent by the DMA in the background.
+ *
+ * When the line has been idle for UART_DMA_IDLE_CHARS characters after
+ * receiving, the idle callback gets the number of bytes waiting, so a 
+ * reader can take a whole message at once.
+ *
+ * If the DMA laps the reader, the next uart_dma_rx_avail() or 
+ * uart_dma_read() returns -1 and drops everything waiting, the reader 
+ * starts again with the bytes that come after.  The idle callback gets 
+ * -1 as well until then.
+ */
+
+#define UART_DMA_RX_SIZE        (256)
+#define UART_DMA_TX_SIZE        (256)
+#define UART_DMA_IDLE_CHARS     (4)
+
+struct uart_dma;
+
+/* called in interrupt context, avail is -1 after an overrun */
+typedef void (*uart_dma_idle_cb)(void *arg, int avail);
+
+/* returns the DMA UART of a port, or NULL */
+struct uart_dma *bsp_get_uart_dma(enum system_device_id sysid);
+
+/* starts the port at baud with 8N1, returns -1 for a bad baud rate and
+ * -2 if it is already running */
+int uart_dma_start(struct uart_dma *pu, uint32_t baud, 
+                   uart_dma_idle_cb cb, void *arg);
+
+int uart_dma_stop(struct uart_dma *pu);
+
+/* queues up to len bytes for sending, returns the number queued */
+int uart_dma_write(struct uart_dma *pu, const uint8_t *data, int len);
+
+/* takes up to len received bytes, returns the number taken or -1 after
+ * an overrun */
+int uart_dma_read(struct uart_dma *pu, uint8_t *data, int len);
+
+/* returns the next received byte without taking it, or -1 */
+int uart_dma_peek(struct uart_dma *pu);
+
+/* returns the number of received bytes waiting, or -1 once after an 
+ * overrun */
+int uart_dma_rx_avail(struct uart_dma *pu);
+
+/* returns the number of overruns since the port was started */
+uint32_t uart_dma_rx_overruns(struct uart_dma *pu);
+
+/* returns the number of bytes not sent yet */
+int uart_dma_tx_pending(struct uart_dma *pu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_DMA_H__ */
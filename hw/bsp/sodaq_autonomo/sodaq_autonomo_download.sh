@@ -52,7 +52,7 @@ if [ $IS_BOOTLOADER -eq 1 ]; then
     PROTECT_FLASH="at91samd bootloader 16384"
 else
     # this number is to offset the bootloader size 
-    FLASH_OFFSET=0x0000C000
+    FLASH_OFFSET=0x00008000
     FILE_NAME=$BASENAME.img
 fi
 echo "Downloading" $FILE_NAME "to" $FLASH_OFFSET
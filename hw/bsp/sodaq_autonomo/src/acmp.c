@@ -0,0 +1,225 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/cmsis_nvic.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/acmp.h>
+#include "bsp_adc_priv.h"
+
+#define ACMP_NUM            (2)
+
+/* 
+ * The analog clock of the AC is 64 kHz at most, it gets a generator of 
+ * its own fed from the 32 kHz ultra low power oscillator, which always 
+ * runs.  GCLK4 is the microsecond clock.
+ */
+#define ACMP_GCLK_GEN       (5)
+
+/* the comparator input pins, AIN0..AIN3 of the AC */
+static const uint8_t acmp_pins[] = {
+    SODAQ_AUTONOMO_A3, SODAQ_AUTONOMO_A4, 
+    SODAQ_AUTONOMO_D8, SODAQ_AUTONOMO_D9,
+};
+
+/* MUXNEG values of the references */
+static const uint8_t acmp_muxneg[] = {
+    [ACMP_REF_SCALE] = AC_COMPCTRL_MUXNEG_VSCALE_Val,
+    [ACMP_REF_BANDGAP] = AC_COMPCTRL_MUXNEG_BANDGAP_Val,
+    [ACMP_REF_DAC] = AC_COMPCTRL_MUXNEG_DAC_Val,
+};
+
+static struct {
+    int8_t pin;             /* -1 when the comparator is free */
+    acmp_cb cb;
+    void *arg;
+} acmp_cur[ACMP_NUM] = { { -1 }, { -1 } };
+
+static void
+acmp_sync(void)
+{
+    while (AC->STATUSB.bit.SYNCBUSY);
+}
+
+static int
+acmp_ain(enum system_device_id pin)
+{
+    int i;
+
+    for (i = 0; i < (int) sizeof(acmp_pins); i++) {
+        if (acmp_pins[i] == pin) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void
+acmp_irq(void)
+{
+    uint8_t flags = AC->INTFLAG.reg;
+    int comp;
+
+    AC->INTFLAG.reg = flags;
+    for (comp = 0; comp < ACMP_NUM; comp++) {
+        if ((flags & (AC_INTFLAG_COMP0 << comp)) && acmp_cur[comp].cb) {
+            acmp_cur[comp].cb(acmp_cur[comp].arg, 
+                              (AC->STATUSA.reg >> comp) & 1);
+        }
+    }
+}
+
+static int
+acmp_valid(const struct acmp_cfg *cfg)
+{
+    return cfg->ref <= ACMP_REF_DAC && cfg->scale <= ACMP_SCALE_MAX &&
+           cfg->out <= ACMP_OUT_EVENT;
+}
+
+/* COMPCTRL can only be written while the comparator is disabled, so
+ * the output holds its last state for the couple of clocks this takes */
+static void
+acmp_apply(int comp, const struct acmp_cfg *cfg)
+{
+    uint32_t ctrl;
+
+    AC->INTENCLR.reg = AC_INTENCLR_COMP0 << comp;
+    AC->COMPCTRL[comp].bit.ENABLE = 0;
+    acmp_sync();
+
+    AC->SCALER[comp].reg = AC_SCALER_VALUE(cfg->scale);
+    ctrl = AC_COMPCTRL_MUXPOS(acmp_ain(acmp_cur[comp].pin)) |
+           AC_COMPCTRL_MUXNEG(acmp_muxneg[cfg->ref]) |
+           AC_COMPCTRL_INTSEL_TOGGLE | AC_COMPCTRL_SPEED_HIGH |
+           AC_COMPCTRL_FLEN_OFF | AC_COMPCTRL_OUT_OFF;
+    if (cfg->hyst) {
+        ctrl |= AC_COMPCTRL_HYST;
+    }
+    AC->COMPCTRL[comp].reg = ctrl;
+    acmp_sync();
+
+    acmp_cur[comp].cb = cfg->cb;
+    acmp_cur[comp].arg = cfg->arg;
+    if (cfg->out == ACMP_OUT_EVENT) {
+        AC->EVCTRL.reg |= AC_EVCTRL_COMPEO0 << comp;
+    } else {
+        AC->EVCTRL.reg &= ~(AC_EVCTRL_COMPEO0 << comp);
+    }
+
+    AC->COMPCTRL[comp].bit.ENABLE = 1;
+    acmp_sync();
+    AC->INTFLAG.reg = AC_INTFLAG_COMP0 << comp;
+    if (cfg->out == ACMP_OUT_IRQ) {
+        AC->INTENSET.reg = AC_INTENSET_COMP0 << comp;
+    }
+}
+
+int
+acmp_of(enum system_device_id pin)
+{
+    int comp;
+
+    for (comp = 0; comp < ACMP_NUM; comp++) {
+        if (acmp_cur[comp].pin == pin) {
+            return comp;
+        }
+    }
+    return -1;
+}
+
+int
+acmp_open(enum system_device_id pin, const struct acmp_cfg *cfg)
+{
+    os_sr_t sr;
+    int comp;
+
+    if (acmp_ain(pin) < 0 || !acmp_valid(cfg) || acmp_of(pin) >= 0) {
+        return -1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    for (comp = 0; comp < ACMP_NUM; comp++) {
+        if (acmp_cur[comp].pin < 0) {
+            acmp_cur[comp].pin = pin;
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+    if (comp == ACMP_NUM) {
+        return -2;
+    }
+
+    if (!AC->CTRLA.bit.ENABLE) {
+        PM->APBCMASK.reg |= PM_APBCMASK_AC;
+        GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_AC_DIG | GCLK_CLKCTRL_GEN_GCLK0 |
+                            GCLK_CLKCTRL_CLKEN;
+        GCLK->GENDIV.reg = GCLK_GENDIV_ID(ACMP_GCLK_GEN) | GCLK_GENDIV_DIV(1);
+        GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(ACMP_GCLK_GEN) |
+                            GCLK_GENCTRL_SRC_OSCULP32K | GCLK_GENCTRL_GENEN;
+        while (GCLK->STATUS.bit.SYNCBUSY);
+        GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_AC_ANA | 
+                            GCLK_CLKCTRL_GEN(ACMP_GCLK_GEN) |
+                            GCLK_CLKCTRL_CLKEN;
+        NVIC_SetVector(AC_IRQn, (uint32_t) acmp_irq);
+        NVIC_EnableIRQ(AC_IRQn);
+        AC->CTRLA.reg = AC_CTRLA_ENABLE;
+        acmp_sync();
+    }
+
+    /* the comparator inputs are function B, like the ADC */
+    bsp_pinmux(pin, 1, 0);
+    acmp_apply(comp, cfg);
+    return comp;
+}
+
+int
+acmp_config(int comp, const struct acmp_cfg *cfg)
+{
+    if (comp < 0 || comp >= ACMP_NUM || acmp_cur[comp].pin < 0 || 
+        !acmp_valid(cfg)) {
+        return -1;
+    }
+    acmp_apply(comp, cfg);
+    return 0;
+}
+
+int
+acmp_state(int comp)
+{
+    if (comp < 0 || comp >= ACMP_NUM || acmp_cur[comp].pin < 0) {
+        return -1;
+    }
+    return (AC->STATUSA.reg >> comp) & 1;
+}
+
+int
+acmp_close(int comp)
+{
+    if (comp < 0 || comp >= ACMP_NUM || acmp_cur[comp].pin < 0) {
+        return -1;
+    }
+    AC->INTENCLR.reg = AC_INTENCLR_COMP0 << comp;
+    AC->EVCTRL.reg &= ~(AC_EVCTRL_COMPEO0 << comp);
+    AC->COMPCTRL[comp].bit.ENABLE = 0;
+    acmp_sync();
+    acmp_cur[comp].cb = NULL;
+    acmp_cur[comp].pin = -1;
+    return 0;
+}
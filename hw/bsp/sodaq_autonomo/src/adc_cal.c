@@ -0,0 +1,135 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/adc_cal.h>
+#include "bsp_adc_priv.h"
+
+/* two points closer than this give a gain that is mostly noise */
+#define ADC_CAL_MIN_SPAN    (64)
+
+static struct adc_cal adc_cal_cur = { 0, ADC_CAL_GAIN_ONE };
+
+static int
+adc_cal_is_off(const struct adc_cal *cal)
+{
+    return cal->offset == 0 && cal->gain == ADC_CAL_GAIN_ONE;
+}
+
+void
+adc_cal_factory(int *linearity, int *bias)
+{
+    uint32_t lin0 = *(uint32_t *) ADC_FUSES_LINEARITY_0_ADDR;
+    uint32_t lin1 = *(uint32_t *) ADC_FUSES_LINEARITY_1_ADDR;
+    uint32_t bcal = *(uint32_t *) ADC_FUSES_BIASCAL_ADDR;
+
+    /* the linearity value straddles two words of the row */
+    *linearity = ((lin0 & ADC_FUSES_LINEARITY_0_Msk) >> 
+                  ADC_FUSES_LINEARITY_0_Pos) |
+                 (((lin1 & ADC_FUSES_LINEARITY_1_Msk) >> 
+                   ADC_FUSES_LINEARITY_1_Pos) << 5);
+    *bias = (bcal & ADC_FUSES_BIASCAL_Msk) >> ADC_FUSES_BIASCAL_Pos;
+}
+
+void
+bsp_adc_calibrate(void)
+{
+    int linearity;
+    int bias;
+
+    /* nothing to write to while the ADC has no clock */
+    if (!(PM->APBCMASK.reg & PM_APBCMASK_ADC)) {
+        return;
+    }
+
+    adc_cal_factory(&linearity, &bias);
+    ADC->CALIB.reg = ADC_CALIB_BIAS_CAL(bias) | 
+                     ADC_CALIB_LINEARITY_CAL(linearity);
+    ADC->OFFSETCORR.reg = ADC_OFFSETCORR_OFFSETCORR(adc_cal_cur.offset);
+    ADC->GAINCORR.reg = ADC_GAINCORR_GAINCORR(adc_cal_cur.gain);
+    bsp_adc_sync();
+    ADC->CTRLB.bit.CORREN = !adc_cal_is_off(&adc_cal_cur);
+    bsp_adc_sync();
+}
+
+int
+adc_cal_from_points(int raw1, int want1, int raw2, int want2,
+                    struct adc_cal *cal)
+{
+    int gain;
+    int offset;
+    int tmp;
+
+    if (raw2 < raw1) {
+        tmp = raw1;
+        raw1 = raw2;
+        raw2 = tmp;
+        tmp = want1;
+        want1 = want2;
+        want2 = tmp;
+    }
+    if (raw1 < 0 || want1 < 0 || raw2 - raw1 < ADC_CAL_MIN_SPAN || 
+        want2 <= want1) {
+        return -1;
+    }
+
+    /* the only divisions, done once here and never per sample */
+    gain = (ADC_CAL_GAIN_ONE * (want2 - want1) + (raw2 - raw1) / 2) / 
+           (raw2 - raw1);
+    if (gain < ADC_CAL_GAIN_MIN || gain > ADC_CAL_GAIN_MAX) {
+        return -1;
+    }
+    offset = raw1 - (want1 * ADC_CAL_GAIN_ONE + gain / 2) / gain;
+    if (offset < ADC_CAL_OFFSET_MIN || offset > ADC_CAL_OFFSET_MAX) {
+        return -1;
+    }
+    cal->offset = offset;
+    cal->gain = gain;
+    return 0;
+}
+
+int
+adc_cal_set(const struct adc_cal *cal)
+{
+    static const struct adc_cal off = { 0, ADC_CAL_GAIN_ONE };
+
+    if (!cal) {
+        cal = &off;
+    }
+    if (cal->offset < ADC_CAL_OFFSET_MIN || 
+        cal->offset > ADC_CAL_OFFSET_MAX ||
+        cal->gain < ADC_CAL_GAIN_MIN || cal->gain > ADC_CAL_GAIN_MAX) {
+        return -1;
+    }
+    /* a running driver set the ADC up with the old values */
+    if (bsp_adc_claim()) {
+        return -2;
+    }
+    adc_cal_cur = *cal;
+    bsp_adc_calibrate();
+    bsp_adc_release();
+    return 0;
+}
+
+void
+adc_cal_get(struct adc_cal *cal)
+{
+    *cal = adc_cal_cur;
+}
@@ -0,0 +1,211 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/bsp_sysid.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_scan.h>
+#include "bsp_adc_priv.h"
+#include "bsp_dma_priv.h"
+
+#define ADC_SCAN_DMA_CH         (BSP_DMA_CH_ADC_SCAN)
+/* the inputs a scan can cover, AIN0 to AIN19 */
+#define ADC_SCAN_INPUTS         (20)
+
+/* 
+ * The ADC can only scan a range of inputs, so a pass covers every input
+ * from the lowest to the highest pin added, also those between that no 
+ * pin uses.  With the clock divided by 512 and 16 conversions averaged
+ * per result, a pass over all six analog pins (AIN0..AIN10) takes about
+ * 15 ms.
+ */
+
+/* the DMA writes here, a slot per input, so a restart with another 
+ * first input leaves the values of the others where they are */
+static volatile uint16_t adc_scan_buf[ADC_SCAN_INPUTS];
+static volatile uint32_t adc_scan_stamp;
+static volatile uint32_t adc_scan_cnt;
+/* the pass count when each input was added, its slot is only good once
+ * a pass has ended after that */
+static uint32_t adc_scan_since[ADC_SCAN_INPUTS];
+static uint32_t adc_scan_mask;
+
+static void
+adc_scan_dmac_irq(int ch, uint8_t flags)
+{
+    if (flags & DMAC_CHINTFLAG_TCMPL) {
+        adc_scan_stamp = bsp_usec_get32();
+        adc_scan_cnt++;
+    }
+}
+
+static void
+adc_scan_stop_hw(void)
+{
+    ADC->CTRLA.bit.ENABLE = 0;
+    bsp_adc_sync();
+    bsp_dma_stop(ADC_SCAN_DMA_CH);
+}
+
+/* (re)starts the scan over the inputs in adc_scan_mask */
+static void
+adc_scan_start_hw(enum system_device_id first_pin)
+{
+    DmacDescriptor *pdesc = bsp_dma_desc(ADC_SCAN_DMA_CH);
+    int first = bsp_adc_ain(first_pin);
+    int last = first;
+    int cnt;
+    int ain;
+
+    for (ain = first; ain < ADC_SCAN_INPUTS; ain++) {
+        if (adc_scan_mask & (1UL << ain)) {
+            last = ain;
+        }
+    }
+    cnt = last - first + 1;
+
+    /* one descriptor linked to itself, every pass overwrites the slots */
+    bsp_dma_setup(ADC_SCAN_DMA_CH, DMAC_CHCTRLB_LVL(0) | 
+                  DMAC_CHCTRLB_TRIGSRC(ADC_DMAC_ID_RESRDY) |
+                  DMAC_CHCTRLB_TRIGACT_BEAT, DMAC_CHINTENSET_TCMPL,
+                  adc_scan_dmac_irq);
+    pdesc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD |
+                        DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_INT;
+    pdesc->BTCNT.reg = cnt;
+    pdesc->SRCADDR.reg = (uint32_t) &ADC->RESULT.reg;
+    pdesc->DSTADDR.reg = (uint32_t) (adc_scan_buf + first + cnt);
+    pdesc->DESCADDR.reg = (uint32_t) pdesc;
+    bsp_dma_start(ADC_SCAN_DMA_CH);
+
+    /* muxes the first pin and sets reference, gain and calibration */
+    bsp_adc_setup(first_pin);
+    ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV512 | ADC_CTRLB_RESSEL_16BIT |
+                     ADC_CTRLB_FREERUN;
+    bsp_adc_sync();
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_16 | ADC_AVGCTRL_ADJRES(4);
+    ADC->INPUTCTRL.reg = ADC_INPUTCTRL_MUXPOS(first) | 
+                         ADC_INPUTCTRL_MUXNEG_GND | 
+                         ADC_INPUTCTRL_GAIN_DIV2 |
+                         ADC_INPUTCTRL_INPUTSCAN(cnt - 1) |
+                         ADC_INPUTCTRL_INPUTOFFSET(0);
+    bsp_adc_sync();
+    ADC->CTRLA.reg |= ADC_CTRLA_RUNSTDBY | ADC_CTRLA_ENABLE;
+    bsp_adc_sync();
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+    bsp_adc_sync();
+}
+
+static enum system_device_id
+adc_scan_lowest(void)
+{
+    enum system_device_id pin = SODAQ_AUTONOMO_A0;
+    int lowest = ADC_SCAN_INPUTS;
+    int ain;
+    int i;
+
+    /* the analog sysids are not in AIN order, look each one up */
+    for (i = SODAQ_AUTONOMO_A0; i <= SODAQ_AUTONOMO_A5; i++) {
+        ain = bsp_adc_ain(i);
+        if (ain >= 0 && (adc_scan_mask & (1UL << ain)) && ain < lowest) {
+            lowest = ain;
+            pin = i;
+        }
+    }
+    return pin;
+}
+
+int
+adc_scan_add(enum system_device_id adc_pin)
+{
+    int ain = bsp_adc_ain(adc_pin);
+
+    if (ain < 0) {
+        return -1;
+    }
+    if (adc_scan_mask & (1UL << ain)) {
+        return 0;
+    }
+    if (!adc_scan_mask) {
+        if (bsp_adc_claim()) {
+            return -2;
+        }
+        adc_scan_cnt = 0;
+    } else {
+        adc_scan_stop_hw();
+    }
+    bsp_pinmux(adc_pin, 1, 0);
+    adc_scan_mask |= (1UL << ain);
+    adc_scan_since[ain] = adc_scan_cnt;
+    adc_scan_start_hw(adc_scan_lowest());
+    return 0;
+}
+
+int
+adc_scan_remove(enum system_device_id adc_pin)
+{
+    int ain = bsp_adc_ain(adc_pin);
+
+    if (ain < 0 || !(adc_scan_mask & (1UL << ain))) {
+        return -1;
+    }
+    adc_scan_stop_hw();
+    adc_scan_mask &= ~(1UL << ain);
+    if (adc_scan_mask) {
+        adc_scan_start_hw(adc_scan_lowest());
+        return 0;
+    }
+    ADC->CTRLA.reg &= ~ADC_CTRLA_RUNSTDBY;
+    ADC->CTRLB.reg &= ~ADC_CTRLB_FREERUN;
+    ADC->AVGCTRL.reg = 0;
+    ADC->INPUTCTRL.reg &= ~ADC_INPUTCTRL_INPUTSCAN_Msk;
+    bsp_adc_sync();
+    bsp_adc_release();
+    return 0;
+}
+
+int
+adc_scan_read(enum system_device_id adc_pin, int *value, uint32_t *stamp)
+{
+    int ain = bsp_adc_ain(adc_pin);
+    uint32_t cnt;
+    os_sr_t sr;
+
+    if (ain < 0 || !(adc_scan_mask & (1UL << ain))) {
+        return -1;
+    }
+    /* the stamp is that of the last whole pass, the value can be from
+     * the pass after it but is never older */
+    OS_ENTER_CRITICAL(sr);
+    cnt = adc_scan_cnt;
+    *value = adc_scan_buf[ain];
+    *stamp = adc_scan_stamp;
+    OS_EXIT_CRITICAL(sr);
+
+    if (cnt == adc_scan_since[ain]) {
+        return -2;
+    }
+    return 0;
+}
+
+uint32_t
+adc_scan_passes(void)
+{
+    return adc_scan_cnt;
+}
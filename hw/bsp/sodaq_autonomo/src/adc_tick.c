@@ -0,0 +1,95 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include "mcu/samd21.h"
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_tick.h>
+#include "bsp_adc_priv.h"
+
+static adc_tick_cb adc_tick_func;
+static void *adc_tick_arg;
+static uint8_t adc_tick_running;
+
+static void
+adc_tick_irq(void *arg, uint32_t due)
+{
+    int value = -1;
+
+    if (ADC->INTFLAG.reg & ADC_INTFLAG_RESRDY) {
+        value = ADC->RESULT.reg;
+    }
+    /* converts while the loop runs and until the next tick */
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+    adc_tick_func(adc_tick_arg, value, due);
+}
+
+int
+adc_tick_start(enum system_device_id adc_pin, uint32_t period,
+               adc_tick_cb cb, void *arg)
+{
+    int rc;
+
+    if (bsp_adc_ain(adc_pin) < 0 || period < ADC_TICK_MIN_PERIOD || !cb) {
+        return -1;
+    }
+    if (bsp_adc_claim()) {
+        return -2;
+    }
+
+    adc_tick_func = cb;
+    adc_tick_arg = arg;
+
+    bsp_adc_setup(adc_pin);
+    ADC->CTRLA.reg |= ADC_CTRLA_ENABLE;
+    bsp_adc_sync();
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+
+    rc = bsp_usec_tick_start(period, adc_tick_irq, NULL);
+    if (rc) {
+        ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+        bsp_adc_sync();
+        bsp_adc_release();
+        return -1;
+    }
+    adc_tick_running = 1;
+    return 0;
+}
+
+int
+adc_tick_stop(void)
+{
+    if (!adc_tick_running) {
+        return 0;
+    }
+    bsp_usec_tick_stop();
+    ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+    bsp_adc_sync();
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+
+    adc_tick_running = 0;
+    bsp_adc_release();
+    return 0;
+}
+
+uint32_t
+adc_tick_missed(void)
+{
+    return bsp_usec_tick_missed();
+}
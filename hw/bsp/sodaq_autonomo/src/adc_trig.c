@@ -0,0 +1,388 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "mcu/samd21.h"
+#include <bsp/cmsis_nvic.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/adc_trig.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/acmp.h>
+#include "bsp_adc_priv.h"
+#include "bsp_dma_priv.h"
+
+/* resources this driver takes for itself */
+#define ADC_TRIG_EVSYS_CH       (0)
+#define ADC_TRIG_DMA_CH         (BSP_DMA_CH_ADC_TRIG)
+
+/* the pwm pins and the timer channel driving them, as in 
+ * bsp_get_hal_pwm_driver() */
+static const struct {
+    uint8_t sysid;
+    uint8_t is_tc;
+    uint8_t dev;
+    uint8_t channel;
+} adc_trig_pwm[] = {
+    { SODAQ_AUTONOMO_D0,  0, 0, 3 },
+    { SODAQ_AUTONOMO_D1,  0, 0, 2 },
+    { SODAQ_AUTONOMO_D2,  0, 0, 0 },
+    { SODAQ_AUTONOMO_D3,  0, 0, 1 },
+    { SODAQ_AUTONOMO_D8,  0, 1, 0 },
+    { SODAQ_AUTONOMO_D9,  0, 1, 1 },
+    { SODAQ_AUTONOMO_D10, 1, 3, 0 },
+    { SODAQ_AUTONOMO_D11, 0, 2, 0 },
+    { SODAQ_AUTONOMO_D12, 1, 3, 1 },
+    { SODAQ_AUTONOMO_D13, 0, 2, 1 },
+    { SODAQ_AUTONOMO_A1,  1, 4, 0 },
+    { SODAQ_AUTONOMO_A2,  1, 4, 1 },
+    { SODAQ_AUTONOMO_A3,  0, 0, 0 },
+    { SODAQ_AUTONOMO_A4,  0, 0, 1 },
+};
+
+static Tcc * const adc_trig_tcc[] = { TCC0, TCC1, TCC2 };
+static const uint8_t adc_trig_tcc_gen[] = {
+    EVSYS_ID_GEN_TCC0_OVF, EVSYS_ID_GEN_TCC1_OVF, EVSYS_ID_GEN_TCC2_OVF
+};
+static const uint8_t adc_trig_tcc_mc_gen[] = {
+    EVSYS_ID_GEN_TCC0_MCX_0, EVSYS_ID_GEN_TCC1_MCX_0, EVSYS_ID_GEN_TCC2_MCX_0
+};
+
+/* the first DMA descriptor lives in the table the DMAC indexes by 
+ * channel, the second one is linked from it and links back, which makes
+ * the buffer circular.  Descriptors have to be 16 byte aligned */
+static DmacDescriptor adc_trig_desc_second __attribute__((aligned(16)));
+
+static struct adc_trig_cfg adc_trig_cur;
+static volatile uint32_t adc_trig_cnt;
+static uint8_t adc_trig_half;
+static uint8_t adc_trig_running;
+
+static int
+adc_trig_pwm_of(enum system_device_id sysid)
+{
+    int i;
+
+    for (i = 0; i < (int) (sizeof(adc_trig_pwm) / sizeof(adc_trig_pwm[0])); 
+         i++) {
+        if (adc_trig_pwm[i].sysid == sysid) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* the timer event outputs are enable-protected, so a running timer is
+ * stopped for a moment.  That stretches one pwm period slightly */
+static void
+adc_trig_tcc_evctrl(Tcc *tcc, uint32_t set, uint32_t clr)
+{
+    int enabled = tcc->CTRLA.bit.ENABLE;
+
+    if (enabled) {
+        tcc->CTRLA.bit.ENABLE = 0;
+        while (tcc->SYNCBUSY.bit.ENABLE);
+    }
+    tcc->EVCTRL.reg = (tcc->EVCTRL.reg & ~clr) | set;
+    if (enabled) {
+        tcc->CTRLA.bit.ENABLE = 1;
+        while (tcc->SYNCBUSY.bit.ENABLE);
+    }
+}
+
+static void
+adc_trig_tc_evctrl(Tc *tc, uint16_t set, uint16_t clr)
+{
+    int enabled = tc->COUNT16.CTRLA.bit.ENABLE;
+
+    if (enabled) {
+        tc->COUNT16.CTRLA.bit.ENABLE = 0;
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    }
+    tc->COUNT16.EVCTRL.reg = (tc->COUNT16.EVCTRL.reg & ~clr) | set;
+    if (enabled) {
+        tc->COUNT16.CTRLA.bit.ENABLE = 1;
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    }
+}
+
+static Tc *
+adc_trig_tc(int dev)
+{
+    return dev == 3 ? TC3 : TC4;
+}
+
+/* sets up the trigger event generator, returns the EVSYS generator id 
+ * or -1 */
+static int
+adc_trig_gen_setup(const struct adc_trig_cfg *cfg)
+{
+    int idx;
+    int line;
+    int dev;
+    int ch;
+    uint32_t sense;
+
+    switch (cfg->src) {
+        case ADC_TRIG_PWM_PERIOD:
+        case ADC_TRIG_PWM_COMPARE:
+            idx = adc_trig_pwm_of(cfg->trig_pin);
+            if (idx < 0) {
+                return -1;
+            }
+            dev = adc_trig_pwm[idx].dev;
+            ch = adc_trig_pwm[idx].channel;
+            if (adc_trig_pwm[idx].is_tc) {
+                Tc *tc = adc_trig_tc(dev);
+
+                if (cfg->src == ADC_TRIG_PWM_PERIOD) {
+                    adc_trig_tc_evctrl(tc, TC_EVCTRL_OVFEO, 0);
+                    return dev == 3 ? EVSYS_ID_GEN_TC3_OVF : 
+                                      EVSYS_ID_GEN_TC4_OVF;
+                }
+                adc_trig_tc_evctrl(tc, TC_EVCTRL_MCEO0 << ch, 0);
+                return (dev == 3 ? EVSYS_ID_GEN_TC3_MCX_0 : 
+                                   EVSYS_ID_GEN_TC4_MCX_0) + ch;
+            }
+            if (cfg->src == ADC_TRIG_PWM_PERIOD) {
+                adc_trig_tcc_evctrl(adc_trig_tcc[dev], TCC_EVCTRL_OVFEO, 0);
+                return adc_trig_tcc_gen[dev];
+            }
+            adc_trig_tcc_evctrl(adc_trig_tcc[dev], TCC_EVCTRL_MCEO0 << ch, 0);
+            return adc_trig_tcc_mc_gen[dev] + ch;
+
+        case ADC_TRIG_PIN_RISE:
+        case ADC_TRIG_PIN_FALL:
+            /* the digital sysids are pin numbers, EXTINT[n] is on the
+             * pins numbered n modulo 16.  PA08 is the NMI */
+            if (cfg->trig_pin >= 64 || cfg->trig_pin == 8) {
+                return -1;
+            }
+            line = cfg->trig_pin % 16;
+            sense = (cfg->src == ADC_TRIG_PIN_RISE) ? 
+                        EIC_CONFIG_SENSE0_RISE_Val : EIC_CONFIG_SENSE0_FALL_Val;
+
+            GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_EIC | GCLK_CLKCTRL_GEN_GCLK0 |
+                                GCLK_CLKCTRL_CLKEN;
+            bsp_pinmux(cfg->trig_pin, 0, 1);
+
+            EIC->CONFIG[line / 8].reg = 
+                (EIC->CONFIG[line / 8].reg & ~(0xfUL << ((line % 8) * 4))) |
+                (sense << ((line % 8) * 4));
+            EIC->EVCTRL.reg |= (1UL << line);
+            if (!EIC->CTRL.bit.ENABLE) {
+                EIC->CTRL.bit.ENABLE = 1;
+                while (EIC->STATUS.bit.SYNCBUSY);
+            }
+            return EVSYS_ID_GEN_EIC_EXTINT_0 + line;
+
+        case ADC_TRIG_ACMP:
+            ch = acmp_of(cfg->trig_pin);
+            if (ch < 0) {
+                return -1;
+            }
+            return EVSYS_ID_GEN_AC_COMP_0 + ch;
+
+        case ADC_TRIG_TIMER:
+            /* the clock always sends its compare events, the tick is 
+             * started once the channel is connected */
+            if (cfg->period < ADC_TRIG_MIN_PERIOD) {
+                return -1;
+            }
+            return EVSYS_ID_GEN_TC6_MCX_1;
+
+        default:
+            return -1;
+    }
+}
+
+static void
+adc_trig_gen_teardown(const struct adc_trig_cfg *cfg)
+{
+    int idx;
+    int line;
+    int dev;
+
+    switch (cfg->src) {
+        case ADC_TRIG_PWM_PERIOD:
+        case ADC_TRIG_PWM_COMPARE:
+            idx = adc_trig_pwm_of(cfg->trig_pin);
+            dev = adc_trig_pwm[idx].dev;
+            if (adc_trig_pwm[idx].is_tc) {
+                adc_trig_tc_evctrl(adc_trig_tc(dev), 0, 
+                    TC_EVCTRL_OVFEO | TC_EVCTRL_MCEO0 | TC_EVCTRL_MCEO1);
+            } else {
+                adc_trig_tcc_evctrl(adc_trig_tcc[dev], 0, TCC_EVCTRL_OVFEO |
+                    TCC_EVCTRL_MCEO0 | TCC_EVCTRL_MCEO1 | 
+                    TCC_EVCTRL_MCEO2 | TCC_EVCTRL_MCEO3);
+            }
+            break;
+        case ADC_TRIG_PIN_RISE:
+        case ADC_TRIG_PIN_FALL:
+            line = cfg->trig_pin % 16;
+            EIC->EVCTRL.reg &= ~(1UL << line);
+            break;
+        case ADC_TRIG_TIMER:
+            bsp_usec_tick_stop();
+            break;
+        default:
+            /* the comparator's event output is its owner's to turn off */
+            break;
+    }
+}
+
+/* the tick moves the compare to the next period, the compare match 
+ * itself starts the conversion */
+static void
+adc_trig_tick(void *arg, uint32_t due)
+{
+}
+
+static void
+adc_trig_desc_setup(DmacDescriptor *pdesc, DmacDescriptor *pnext, 
+                    uint16_t *dst, uint16_t cnt)
+{
+    pdesc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD |
+                        DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_INT;
+    pdesc->BTCNT.reg = cnt;
+    pdesc->SRCADDR.reg = (uint32_t) &ADC->RESULT.reg;
+    /* with an incrementing address the DMAC wants the end of the block */
+    pdesc->DSTADDR.reg = (uint32_t) (dst + cnt);
+    pdesc->DESCADDR.reg = (uint32_t) pnext;
+}
+
+static void
+adc_trig_dmac_irq(int ch, uint8_t flags)
+{
+    uint16_t half = adc_trig_cur.buf_cnt / 2;
+
+    if (flags & DMAC_CHINTFLAG_TCMPL) {
+        adc_trig_cnt += half;
+        if (adc_trig_cur.cb) {
+            adc_trig_cur.cb(adc_trig_cur.arg, 
+                            &adc_trig_cur.buf[adc_trig_half * half], half);
+        }
+        adc_trig_half ^= 1;
+    }
+}
+
+static void
+adc_trig_dma_setup(void)
+{
+    uint16_t half = adc_trig_cur.buf_cnt / 2;
+    uint16_t *buf = adc_trig_cur.buf;
+    DmacDescriptor *pfirst = bsp_dma_desc(ADC_TRIG_DMA_CH);
+
+    bsp_dma_setup(ADC_TRIG_DMA_CH, DMAC_CHCTRLB_LVL(0) | 
+                  DMAC_CHCTRLB_TRIGSRC(ADC_DMAC_ID_RESRDY) |
+                  DMAC_CHCTRLB_TRIGACT_BEAT, DMAC_CHINTENSET_TCMPL,
+                  adc_trig_dmac_irq);
+    adc_trig_desc_setup(pfirst, &adc_trig_desc_second, buf, half);
+    adc_trig_desc_setup(&adc_trig_desc_second, pfirst, buf + half, half);
+    bsp_dma_start(ADC_TRIG_DMA_CH);
+}
+
+int
+adc_trig_start(const struct adc_trig_cfg *cfg)
+{
+    int gen;
+    int rc;
+
+    if (bsp_adc_ain(cfg->adc_pin) < 0 || !cfg->buf || cfg->buf_cnt < 2 || 
+        (cfg->buf_cnt & 1)) {
+        return -1;
+    }
+    if (bsp_adc_claim()) {
+        return -2;
+    }
+
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+    gen = adc_trig_gen_setup(cfg);
+    if (gen < 0) {
+        bsp_adc_release();
+        return -1;
+    }
+
+    adc_trig_cur = *cfg;
+    adc_trig_cnt = 0;
+    adc_trig_half = 0;
+
+    adc_trig_dma_setup();
+    bsp_adc_setup(cfg->adc_pin);
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI;
+    ADC->CTRLA.bit.ENABLE = 1;
+    bsp_adc_sync();
+
+    /* the asynchronous path needs no clock and adds no latency */
+    EVSYS->USER.reg = EVSYS_USER_USER(EVSYS_ID_USER_ADC_START) |
+                      EVSYS_USER_CHANNEL(ADC_TRIG_EVSYS_CH + 1);
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(ADC_TRIG_EVSYS_CH) |
+                         EVSYS_CHANNEL_EVGEN(gen) |
+                         EVSYS_CHANNEL_PATH_ASYNCHRONOUS;
+    if (cfg->src == ADC_TRIG_TIMER) {
+        /* the ADC owns the tick as well, adc_tick cannot run now */
+        rc = bsp_usec_tick_start(cfg->period, adc_trig_tick, NULL);
+        if (rc) {
+            EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(ADC_TRIG_EVSYS_CH);
+            EVSYS->USER.reg = EVSYS_USER_USER(EVSYS_ID_USER_ADC_START);
+            ADC->EVCTRL.reg = 0;
+            ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+            bsp_adc_sync();
+            bsp_dma_stop(ADC_TRIG_DMA_CH);
+            bsp_adc_release();
+            return -1;
+        }
+    }
+    adc_trig_running = 1;
+    return 0;
+}
+
+int
+adc_trig_stop(void)
+{
+    if (!adc_trig_running) {
+        return 0;
+    }
+
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(ADC_TRIG_EVSYS_CH);
+    EVSYS->USER.reg = EVSYS_USER_USER(EVSYS_ID_USER_ADC_START);
+    adc_trig_gen_teardown(&adc_trig_cur);
+
+    ADC->EVCTRL.reg = 0;
+
+    bsp_dma_stop(ADC_TRIG_DMA_CH);
+
+    adc_trig_running = 0;
+    bsp_adc_release();
+    return 0;
+}
+
+uint32_t
+adc_trig_samples(void)
+{
+    return adc_trig_cnt;
+}
+
+uint32_t
+adc_trig_missed(void)
+{
+    if (adc_trig_cur.src != ADC_TRIG_TIMER) {
+        return 0;
+    }
+    return bsp_usec_tick_missed();
+}
@@ -0,0 +1,145 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include "mcu/samd21.h"
+#include <bsp/cmsis_nvic.h>
+#include <bsp/adc_window.h>
+#include "bsp_adc_priv.h"
+
+static adc_window_cb adc_window_func;
+static void *adc_window_arg;
+static uint8_t adc_window_inside;
+static uint8_t adc_window_running;
+
+/* 
+ * The window monitor flags every result that matches the mode, not just
+ * the first one.  So the mode is flipped on each crossing: outside the 
+ * band while the value is in it, inside the band while it is out.
+ */
+static void
+adc_window_mode(int inside)
+{
+    ADC->WINCTRL.reg = inside ? ADC_WINCTRL_WINMODE_MODE4 : 
+                                ADC_WINCTRL_WINMODE_MODE3;
+    bsp_adc_sync();
+}
+
+static void
+adc_window_irq(void)
+{
+    int value;
+
+    if (!(ADC->INTFLAG.reg & ADC_INTFLAG_WINMON)) {
+        return;
+    }
+    value = ADC->RESULT.reg;
+    ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
+
+    adc_window_inside ^= 1;
+    adc_window_mode(adc_window_inside);
+    if (adc_window_func) {
+        adc_window_func(adc_window_arg, value, adc_window_inside);
+    }
+}
+
+static int
+adc_window_band(int lower, int upper)
+{
+    if (lower < 0 || upper > ADC_WINDOW_MAX || lower >= upper) {
+        return -1;
+    }
+    ADC->WINLT.reg = lower;
+    bsp_adc_sync();
+    ADC->WINUT.reg = upper;
+    bsp_adc_sync();
+    return 0;
+}
+
+int
+adc_window_start(enum system_device_id adc_pin, int lower, int upper,
+                 adc_window_cb cb, void *arg)
+{
+    if (bsp_adc_ain(adc_pin) < 0 || lower < 0 || upper > ADC_WINDOW_MAX ||
+        lower >= upper) {
+        return -1;
+    }
+    if (bsp_adc_claim()) {
+        return -2;
+    }
+
+    adc_window_func = cb;
+    adc_window_arg = arg;
+    adc_window_inside = 1;
+
+    bsp_adc_setup(adc_pin);
+    ADC->CTRLB.reg |= ADC_CTRLB_FREERUN;
+    bsp_adc_sync();
+    adc_window_band(lower, upper);
+    adc_window_mode(adc_window_inside);
+
+    ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
+    ADC->INTENSET.reg = ADC_INTENSET_WINMON;
+    NVIC_SetVector(ADC_IRQn, (uint32_t) adc_window_irq);
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    ADC->CTRLA.reg |= ADC_CTRLA_RUNSTDBY | ADC_CTRLA_ENABLE;
+    bsp_adc_sync();
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+    bsp_adc_sync();
+
+    adc_window_running = 1;
+    return 0;
+}
+
+int
+adc_window_set(int lower, int upper)
+{
+    if (!adc_window_running) {
+        return -1;
+    }
+    return adc_window_band(lower, upper);
+}
+
+int
+adc_window_value(void)
+{
+    if (!adc_window_running) {
+        return -1;
+    }
+    return ADC->RESULT.reg;
+}
+
+int
+adc_window_stop(void)
+{
+    if (!adc_window_running) {
+        return 0;
+    }
+    NVIC_DisableIRQ(ADC_IRQn);
+    ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+    ADC->CTRLA.reg &= ~(ADC_CTRLA_RUNSTDBY | ADC_CTRLA_ENABLE);
+    bsp_adc_sync();
+    ADC->CTRLB.reg &= ~ADC_CTRLB_FREERUN;
+    ADC->WINCTRL.reg = ADC_WINCTRL_WINMODE_DISABLE;
+    bsp_adc_sync();
+
+    adc_window_running = 0;
+    bsp_adc_release();
+    return 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/bsp.h>
+#include <bsp/bsp_sysid.h>
+#include "bsp_adc_priv.h"
+
+/* the analog pins and their ADC inputs, as in bsp_get_hal_adc() */
+static const struct {
+    uint8_t sysid;
+    uint8_t ain;
+} bsp_adc_ains[] = {
+    { SODAQ_AUTONOMO_A0, 0 },
+    { SODAQ_AUTONOMO_A1, 2 },
+    { SODAQ_AUTONOMO_A2, 3 },
+    { SODAQ_AUTONOMO_A3, 4 },
+    { SODAQ_AUTONOMO_A4, 5 },
+    { SODAQ_AUTONOMO_A5, 10 },
+};
+
+static uint8_t bsp_adc_owned;
+
+/* 
+ * The setup the HAL channels left in the ADC when a driver claimed it,
+ * put back on release.  samd21_adc_create() runs the ADC enabled at the
+ * resolution of the channel config, the drivers leave it disabled at 12
+ * bits, so a HAL read in between would get nothing or the wrong scale.
+ */
+static struct {
+    uint8_t valid;
+    uint8_t ctrla;
+    uint8_t refctrl;
+    uint8_t avgctrl;
+    uint8_t sampctrl;
+    uint16_t ctrlb;
+    uint8_t winctrl;
+    uint8_t intenset;
+    uint16_t evctrl;
+    uint32_t inputctrl;
+} bsp_adc_saved;
+
+static void
+bsp_adc_save(void)
+{
+    /* the registers cannot be read without the clock, and with no clock
+     * the HAL has not set anything up */
+    bsp_adc_saved.valid = !!(PM->APBCMASK.reg & PM_APBCMASK_ADC);
+    if (!bsp_adc_saved.valid) {
+        return;
+    }
+    bsp_adc_saved.ctrla = ADC->CTRLA.reg;
+    bsp_adc_saved.refctrl = ADC->REFCTRL.reg;
+    bsp_adc_saved.avgctrl = ADC->AVGCTRL.reg;
+    bsp_adc_saved.sampctrl = ADC->SAMPCTRL.reg;
+    bsp_adc_saved.ctrlb = ADC->CTRLB.reg;
+    bsp_adc_saved.winctrl = ADC->WINCTRL.reg;
+    bsp_adc_saved.intenset = ADC->INTENSET.reg;
+    bsp_adc_saved.evctrl = ADC->EVCTRL.reg;
+    bsp_adc_saved.inputctrl = ADC->INPUTCTRL.reg;
+}
+
+static void
+bsp_adc_restore(void)
+{
+    if (!(PM->APBCMASK.reg & PM_APBCMASK_ADC)) {
+        return;
+    }
+    ADC->CTRLA.bit.ENABLE = 0;
+    bsp_adc_sync();
+    ADC->INTENCLR.reg = ADC_INTENCLR_MASK;
+    ADC->INTFLAG.reg = ADC_INTFLAG_MASK;
+    if (!bsp_adc_saved.valid) {
+        return;
+    }
+    ADC->REFCTRL.reg = bsp_adc_saved.refctrl;
+    ADC->AVGCTRL.reg = bsp_adc_saved.avgctrl;
+    ADC->SAMPCTRL.reg = bsp_adc_saved.sampctrl;
+    ADC->CTRLB.reg = bsp_adc_saved.ctrlb;
+    bsp_adc_sync();
+    ADC->WINCTRL.reg = bsp_adc_saved.winctrl;
+    ADC->EVCTRL.reg = bsp_adc_saved.evctrl;
+    ADC->INPUTCTRL.reg = bsp_adc_saved.inputctrl;
+    bsp_adc_sync();
+    /* the correction may have changed while the ADC was claimed */
+    bsp_adc_calibrate();
+    ADC->INTENSET.reg = bsp_adc_saved.intenset;
+    ADC->CTRLA.reg = bsp_adc_saved.ctrla;
+    bsp_adc_sync();
+}
+
+int
+bsp_adc_claim(void)
+{
+    os_sr_t sr;
+    int rc = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    if (bsp_adc_owned) {
+        rc = -2;
+    } else {
+        bsp_adc_owned = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+    if (rc == 0) {
+        bsp_adc_save();
+    }
+    return rc;
+}
+
+void
+bsp_adc_release(void)
+{
+    bsp_adc_restore();
+    bsp_adc_owned = 0;
+}
+
+int
+bsp_adc_busy(void)
+{
+    return bsp_adc_owned;
+}
+
+int
+bsp_adc_ain(enum system_device_id sysid)
+{
+    int i;
+
+    for (i = 0; i < (int) (sizeof(bsp_adc_ains) / sizeof(bsp_adc_ains[0])); 
+         i++) {
+        if (bsp_adc_ains[i].sysid == sysid) {
+            return bsp_adc_ains[i].ain;
+        }
+    }
+    return -1;
+}
+
+void
+bsp_pinmux(int pin, int func, int input)
+{
+    PortGroup *port = &PORT->Group[pin / 32];
+    int bit = pin % 32;
+
+    if (bit & 1) {
+        port->PMUX[bit / 2].bit.PMUXO = func;
+    } else {
+        port->PMUX[bit / 2].bit.PMUXE = func;
+    }
+    port->PINCFG[bit].reg = PORT_PINCFG_PMUXEN | 
+                            (input ? PORT_PINCFG_INEN : 0);
+}
+
+void
+bsp_adc_sync(void)
+{
+    while (ADC->STATUS.bit.SYNCBUSY);
+}
+
+int
+bsp_adc_setup(enum system_device_id sysid)
+{
+    int ain = bsp_adc_ain(sysid);
+
+    if (ain < 0) {
+        return -1;
+    }
+
+    /* the analog sysids are pin numbers too, the ADC is function B */
+    bsp_pinmux(sysid, 1, 0);
+
+    PM->APBCMASK.reg |= PM_APBCMASK_ADC;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_ADC | GCLK_CLKCTRL_GEN_GCLK0 |
+                        GCLK_CLKCTRL_CLKEN;
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    bsp_adc_sync();
+    ADC->INTENCLR.reg = ADC_INTENCLR_MASK;
+    ADC->INTFLAG.reg = ADC_INTFLAG_MASK;
+    ADC->EVCTRL.reg = 0;
+    ADC->WINCTRL.reg = ADC_WINCTRL_WINMODE_DISABLE;
+    bsp_adc_sync();
+    ADC->REFCTRL.reg = ADC_REFCTRL_REFSEL_INTVCC1;
+    ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV32 | ADC_CTRLB_RESSEL_12BIT;
+    bsp_adc_sync();
+    ADC->SAMPCTRL.reg = 0;
+    ADC->INPUTCTRL.reg = ADC_INPUTCTRL_MUXPOS(ain) | 
+                         ADC_INPUTCTRL_MUXNEG_GND | 
+                         ADC_INPUTCTRL_GAIN_DIV2;
+    bsp_adc_sync();
+    bsp_adc_calibrate();
+    return 0;
+}
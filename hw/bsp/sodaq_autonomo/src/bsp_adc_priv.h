@@ -0,0 +1,53 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BSP_ADC_PRIV_H__
+#define __BSP_ADC_PRIV_H__
+
+#include <bsp/bsp_sysid.h>
+
+/* 
+ * The ADC is a single peripheral shared by the triggered, window and
+ * background drivers.  Only one of them can own it at a time.
+ */
+
+/* returns 0 if the caller now owns the ADC, -2 if someone else does. 
+ * Release puts back the setup the ADC had at the claim, so the HAL 
+ * channels read as before */
+int bsp_adc_claim(void);
+void bsp_adc_release(void);
+
+/* returns the ADC input of an analog pin or -1 */
+int bsp_adc_ain(enum system_device_id sysid);
+
+/* muxes the pin to the ADC and sets up a 12 bit single ended 
+ * conversion of it, with the reference and gain of the default config
+ * in hal_bsp.c.  The ADC is left disabled */
+int bsp_adc_setup(enum system_device_id sysid);
+
+void bsp_adc_sync(void);
+
+/* loads the factory calibration and programs the correction of 
+ * bsp/adc_cal.h, done by every setup of the ADC */
+void bsp_adc_calibrate(void);
+
+/* sets the function of a port pin, input enables the input buffer */
+void bsp_pinmux(int pin, int func, int input);
+
+#endif /* __BSP_ADC_PRIV_H__ */
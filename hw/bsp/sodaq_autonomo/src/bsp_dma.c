@@ -0,0 +1,118 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/cmsis_nvic.h>
+#include "bsp_dma_priv.h"
+
+/* the descriptors have to be 16 byte aligned */
+static DmacDescriptor bsp_dma_descs[BSP_DMA_CHANNELS] 
+    __attribute__((aligned(16)));
+static DmacDescriptor bsp_dma_descs_wb[BSP_DMA_CHANNELS] 
+    __attribute__((aligned(16)));
+static bsp_dma_irq_func bsp_dma_funcs[BSP_DMA_CHANNELS];
+
+/* 
+ * The channel registers are reached through CHID, which the interrupt
+ * changes too.  Everything that selects a channel does so with 
+ * interrupts off.
+ */
+
+static void
+bsp_dma_irq(void)
+{
+    uint8_t flags;
+    int ch;
+
+    /* INTPEND shows the lowest channel with an interrupt pending */
+    while (DMAC->INTSTATUS.reg) {
+        ch = DMAC->INTPEND.bit.ID;
+        DMAC->CHID.reg = DMAC_CHID_ID(ch);
+        flags = DMAC->CHINTFLAG.reg;
+        DMAC->CHINTFLAG.reg = flags;
+        if (ch < BSP_DMA_CHANNELS && bsp_dma_funcs[ch]) {
+            bsp_dma_funcs[ch](ch, flags);
+        }
+    }
+}
+
+DmacDescriptor *
+bsp_dma_desc(int ch)
+{
+    return &bsp_dma_descs[ch];
+}
+
+volatile DmacDescriptor *
+bsp_dma_wb(int ch)
+{
+    return &bsp_dma_descs_wb[ch];
+}
+
+void
+bsp_dma_setup(int ch, uint32_t chctrlb, uint8_t inten, 
+              bsp_dma_irq_func func)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!DMAC->CTRL.bit.DMAENABLE) {
+        PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+        PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+        DMAC->BASEADDR.reg = (uint32_t) bsp_dma_descs;
+        DMAC->WRBADDR.reg = (uint32_t) bsp_dma_descs_wb;
+        DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+        NVIC_SetVector(DMAC_IRQn, (uint32_t) bsp_dma_irq);
+        NVIC_EnableIRQ(DMAC_IRQn);
+    }
+
+    bsp_dma_funcs[ch] = func;
+    DMAC->CHID.reg = DMAC_CHID_ID(ch);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+    DMAC->CHCTRLB.reg = chctrlb;
+    DMAC->CHINTENSET.reg = inten;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+bsp_dma_start(int ch)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    DMAC->CHID.reg = DMAC_CHID_ID(ch);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+bsp_dma_stop(int ch)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    DMAC->CHID.reg = DMAC_CHID_ID(ch);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+    bsp_dma_funcs[ch] = NULL;
+    OS_EXIT_CRITICAL(sr);
+}
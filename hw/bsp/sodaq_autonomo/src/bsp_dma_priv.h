@@ -0,0 +1,58 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BSP_DMA_PRIV_H__
+#define __BSP_DMA_PRIV_H__
+
+#include <stdint.h>
+#include "mcu/samd21.h"
+
+/* 
+ * The DMAC has one descriptor table and one interrupt for all channels,
+ * so the drivers using it share these.  Each driver has fixed channels.
+ */
+
+#define BSP_DMA_CH_ADC_TRIG     (0)
+/* the scan owns the ADC too, it never runs with the triggered ADC */
+#define BSP_DMA_CH_ADC_SCAN     (0)
+#define BSP_DMA_CH_UART_RX      (1)
+#define BSP_DMA_CH_UART_TX      (2)
+#define BSP_DMA_CHANNELS        (3)
+
+/* called in interrupt context with the flags of the channel, which are
+ * already cleared */
+typedef void (*bsp_dma_irq_func)(int ch, uint8_t flags);
+
+/* returns the first descriptor of a channel */
+DmacDescriptor *bsp_dma_desc(int ch);
+
+/* returns the write back descriptor of a channel, where the DMAC saves
+ * the state of a channel whenever it stops being the active one */
+volatile DmacDescriptor *bsp_dma_wb(int ch);
+
+/* turns the DMAC on if it isn't yet, resets the channel and sets its
+ * trigger and interrupts. It is started with bsp_dma_start() once the
+ * descriptor is filled in */
+void bsp_dma_setup(int ch, uint32_t chctrlb, uint8_t inten, 
+                   bsp_dma_irq_func func);
+
+void bsp_dma_start(int ch);
+void bsp_dma_stop(int ch);
+
+#endif /* __BSP_DMA_PRIV_H__ */
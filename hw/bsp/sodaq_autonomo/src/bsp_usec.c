@@ -0,0 +1,223 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdint.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/cmsis_nvic.h>
+#include <bsp/bsp_usec.h>
+
+/* a generator nobody else uses, divided down to 1 MHz from OSC8M */
+#define BSP_USEC_GCLK_GEN       (4)
+
+static volatile uint32_t bsp_usec_wraps;
+
+static bsp_usec_alarm_func bsp_usec_alarm_cb;
+static void *bsp_usec_alarm_arg;
+static uint32_t bsp_usec_alarm_at;
+
+static bsp_usec_tick_func bsp_usec_tick_cb;
+static void *bsp_usec_tick_arg;
+static uint32_t bsp_usec_tick_period;
+static uint32_t bsp_usec_tick_due;
+static uint32_t bsp_usec_tick_missed_cnt;
+
+/* a tick closer than this to the count may be passed before CC1 has 
+ * synchronized, so it is skipped too */
+#define BSP_USEC_TICK_MARGIN    (4)
+
+static void
+bsp_usec_tick_irq(void)
+{
+    bsp_usec_tick_func func = bsp_usec_tick_cb;
+    uint32_t due = bsp_usec_tick_due;
+    uint32_t next = due + bsp_usec_tick_period;
+
+    if (!func) {
+        return;
+    }
+    while ((int32_t) (next - bsp_usec_get32()) <= BSP_USEC_TICK_MARGIN) {
+        next += bsp_usec_tick_period;
+        bsp_usec_tick_missed_cnt++;
+    }
+    bsp_usec_tick_due = next;
+    /* no wait for the synchronization, that is well within a period */
+    TC6->COUNT32.CC[1].reg = next;
+    func(bsp_usec_tick_arg, due);
+}
+
+static void
+bsp_usec_irq(void)
+{
+    bsp_usec_alarm_func func;
+
+    if (TC6->COUNT32.INTFLAG.bit.OVF) {
+        TC6->COUNT32.INTFLAG.reg = TC_INTFLAG_OVF;
+        bsp_usec_wraps++;
+    }
+
+    if (TC6->COUNT32.INTFLAG.bit.MC1) {
+        TC6->COUNT32.INTFLAG.reg = TC_INTFLAG_MC1;
+        bsp_usec_tick_irq();
+    }
+
+    /* also runs when set pended the interrupt for an alarm in the past */
+    TC6->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+    func = bsp_usec_alarm_cb;
+    if (func && (int32_t) (bsp_usec_alarm_at - bsp_usec_get32()) <= 0) {
+        TC6->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+        bsp_usec_alarm_cb = NULL;
+        func(bsp_usec_alarm_arg);
+    }
+}
+
+static void
+bsp_usec_sync(void)
+{
+    while (TC6->COUNT32.STATUS.bit.SYNCBUSY);
+}
+
+int
+bsp_usec_init(void)
+{
+    /* OSC8M runs at 8 MHz divided by its prescaler */
+    uint32_t div = 8 >> SYSCTRL->OSC8M.bit.PRESC;
+
+    GCLK->GENDIV.reg = GCLK_GENDIV_ID(BSP_USEC_GCLK_GEN) | 
+                       GCLK_GENDIV_DIV(div);
+    GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(BSP_USEC_GCLK_GEN) |
+                        GCLK_GENCTRL_SRC_OSC8M | GCLK_GENCTRL_GENEN;
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TC6_TC7 | 
+                        GCLK_CLKCTRL_GEN(BSP_USEC_GCLK_GEN) |
+                        GCLK_CLKCTRL_CLKEN;
+
+    /* TC7 is the upper half of the counter, it only needs its clock */
+    PM->APBCMASK.reg |= PM_APBCMASK_TC6 | PM_APBCMASK_TC7;
+
+    TC6->COUNT32.CTRLA.reg = TC_CTRLA_SWRST;
+    bsp_usec_sync();
+    while (TC6->COUNT32.CTRLA.bit.SWRST);
+    TC6->COUNT32.CTRLA.reg = TC_CTRLA_MODE_COUNT32 | TC_CTRLA_WAVEGEN_NFRQ |
+                             TC_CTRLA_PRESCALER_DIV1;
+    /* keep COUNT synchronized so it can be read without a request */
+    TC6->COUNT32.READREQ.reg = TC_READREQ_RCONT | 
+                               TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+    bsp_usec_sync();
+    /* the event output is enable-protected, it is on for good so that 
+     * adc_trig can start conversions on the tick */
+    TC6->COUNT32.EVCTRL.reg = TC_EVCTRL_MCEO1;
+
+    bsp_usec_wraps = 0;
+    TC6->COUNT32.INTENSET.reg = TC_INTENSET_OVF;
+    NVIC_SetVector(TC6_IRQn, (uint32_t) bsp_usec_irq);
+    NVIC_EnableIRQ(TC6_IRQn);
+
+    TC6->COUNT32.CTRLA.bit.ENABLE = 1;
+    bsp_usec_sync();
+    return 0;
+}
+
+void
+bsp_usec_alarm_set(uint32_t at, bsp_usec_alarm_func func, void *arg)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    bsp_usec_alarm_at = at;
+    bsp_usec_alarm_cb = func;
+    bsp_usec_alarm_arg = arg;
+    TC6->COUNT32.CC[0].reg = at;
+    bsp_usec_sync();
+    TC6->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+    TC6->COUNT32.INTENSET.reg = TC_INTENSET_MC0;
+    /* the count may have passed at while CC0 was synchronizing */
+    if ((int32_t) (at - bsp_usec_get32()) <= 0) {
+        NVIC_SetPendingIRQ(TC6_IRQn);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+bsp_usec_alarm_stop(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    TC6->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+    bsp_usec_alarm_cb = NULL;
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+bsp_usec_tick_start(uint32_t period, bsp_usec_tick_func func, void *arg)
+{
+    os_sr_t sr;
+
+    if (period < BSP_USEC_TICK_MIN || !func) {
+        return -1;
+    }
+    OS_ENTER_CRITICAL(sr);
+    bsp_usec_tick_cb = func;
+    bsp_usec_tick_arg = arg;
+    bsp_usec_tick_period = period;
+    bsp_usec_tick_missed_cnt = 0;
+    bsp_usec_tick_due = bsp_usec_get32() + period;
+    TC6->COUNT32.CC[1].reg = bsp_usec_tick_due;
+    bsp_usec_sync();
+    TC6->COUNT32.INTFLAG.reg = TC_INTFLAG_MC1;
+    TC6->COUNT32.INTENSET.reg = TC_INTENSET_MC1;
+    OS_EXIT_CRITICAL(sr);
+    return 0;
+}
+
+void
+bsp_usec_tick_stop(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    TC6->COUNT32.INTENCLR.reg = TC_INTENCLR_MC1;
+    bsp_usec_tick_cb = NULL;
+    OS_EXIT_CRITICAL(sr);
+}
+
+uint32_t
+bsp_usec_tick_missed(void)
+{
+    return bsp_usec_tick_missed_cnt;
+}
+
+uint64_t
+bsp_usec_get64(void)
+{
+    uint32_t wraps;
+    uint32_t count;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    wraps = bsp_usec_wraps;
+    count = bsp_usec_get32();
+    /* a wrap that happened after we disabled interrupts */
+    if (TC6->COUNT32.INTFLAG.bit.OVF && count < 0x80000000UL) {
+        wraps++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return ((uint64_t) wraps << 32) | count;
+}
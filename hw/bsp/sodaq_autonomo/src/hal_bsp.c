@@ -28,6 +28,9 @@
 #include <mcu/hal_dac.h>
 #include <mcu/hal_spi.h>
 #include <mcu/hal_i2c.h>
+#include <bsp/uart_dma.h>
+#include "uart_dma_priv.h"
+#include "bsp_adc_priv.h"
 
 const struct hal_flash *
 bsp_flash_dev(uint8_t id)
@@ -66,23 +69,35 @@ static const struct samd21_adc_config aref_cfg =
 #warning "TODO"
 extern struct hal_adc *
 bsp_get_hal_adc(enum system_device_id sysid) {       
+    struct hal_adc *padc;
+
     switch(sysid) {
         case SODAQ_AUTONOMO_A0: 
-            return samd21_adc_create(SAMD21_ANALOG_0, &default_cfg);
+            padc = samd21_adc_create(SAMD21_ANALOG_0, &default_cfg);
+            break;
         case SODAQ_AUTONOMO_A1:
-            return samd21_adc_create(SAMD21_ANALOG_2, &default_cfg);
+            padc = samd21_adc_create(SAMD21_ANALOG_2, &default_cfg);
+            break;
         case SODAQ_AUTONOMO_A2: 
-            return samd21_adc_create(SAMD21_ANALOG_3, &default_cfg);
+            padc = samd21_adc_create(SAMD21_ANALOG_3, &default_cfg);
+            break;
         case SODAQ_AUTONOMO_A3:
-            return samd21_adc_create(SAMD21_ANALOG_4, &default_cfg);
+            padc = samd21_adc_create(SAMD21_ANALOG_4, &default_cfg);
+            break;
         case SODAQ_AUTONOMO_A4: 
-            return samd21_adc_create(SAMD21_ANALOG_5, &default_cfg);
+            padc = samd21_adc_create(SAMD21_ANALOG_5, &default_cfg);
+            break;
         case SODAQ_AUTONOMO_A5: 
-            return samd21_adc_create(SAMD21_ANALOG_10, &default_cfg);
-        default:
+            padc = samd21_adc_create(SAMD21_ANALOG_10, &default_cfg);
             break;
+        default:
+            return NULL;
     }
-    return NULL;    
+    /* creating the channel resets the ADC, put the correction back */
+    if (padc) {
+        bsp_adc_calibrate();
+    }
+    return padc;    
 }
 
 /* the GCLK going to the TCs on arduino is 8 Mhz.
@@ -248,3 +263,29 @@ bsp_get_hal_i2c_driver(enum system_device_id sysid)
     }
     return pi2c;
 }
+
+/* the Bee socket UART, SERCOM2 with TX on PA14 (PAD2) and RX on PA15 
+ * (PAD3), both port function C */
+static const struct uart_dma_config bee_uart_config = {
+    .sercom = 2,
+    .tx_pin = 14,
+    .rx_pin = 15,
+    .pin_func = 2,
+    .txpo = 1,
+    .rxpo = 3,
+};
+
+struct uart_dma *
+bsp_get_uart_dma(enum system_device_id sysid)
+{
+    struct uart_dma *pu = NULL;
+
+    switch (sysid) {
+        case SODAQ_AUTONOMO_BEE_UART:
+            pu = uart_dma_create(&bee_uart_config);
+            break;
+        default:
+            break;
+    }
+    return pu;
+}
@@ -19,6 +19,8 @@
  */
 #include <sys/types.h>
 #include <hal/flash_map.h>
+#include <bsp/bsp.h>
+#include <bsp/bsp_usec.h>
 
 void *_sbrk(int incr);
 void _close(int fd);
@@ -27,28 +29,33 @@ static struct flash_area sodaq_autonomo_flash_areas[] = {
     [FLASH_AREA_BOOTLOADER] = {
         .fa_flash_id = 0,       /* internal flash */
         .fa_off = 0x00000000,   /* beginning */
-        .fa_size = (48 * 1024)
+        .fa_size = (32 * 1024)
     },
     [FLASH_AREA_IMAGE_0] = {
         .fa_flash_id = 0,
-        .fa_off = 0x0000c000,
+        .fa_off = 0x00008000,
         .fa_size = (96 * 1024)
     },
     [FLASH_AREA_IMAGE_1] = {
         .fa_flash_id = 0,
-        .fa_off = 0x00024000,
+        .fa_off = 0x00020000,
         .fa_size = (96 * 1024)
     },
     [FLASH_AREA_IMAGE_SCRATCH] = {
         .fa_flash_id = 0,
-        .fa_off = 0x0003c000,
+        .fa_off = 0x00038000,
         .fa_size = (8 * 1024)
     },
+    [FLASH_AREA_SAMPLE_LOG] = {
+        .fa_flash_id = 0,
+        .fa_off = 0x0003a000,
+        .fa_size = (16 * 1024)
+    },
     [FLASH_AREA_NFFS] = {
         .fa_flash_id = 0,
         .fa_off = 0x0003e000,
         .fa_size = (8 * 1024)
-    }
+    },
 };
 
 int
@@ -67,4 +74,6 @@ os_bsp_init(void)
     _close(0);
     flash_area_init(sodaq_autonomo_flash_areas,
       sizeof(sodaq_autonomo_flash_areas) / sizeof(sodaq_autonomo_flash_areas[0]));    
+
+    bsp_usec_init();
 }
@@ -0,0 +1,144 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/bsp_sysid.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/pin_snap.h>
+#include "bsp_adc_priv.h"
+
+/* the inputs a scan can cover, AIN0 to AIN19 */
+#define PIN_SNAP_INPUTS     (20)
+
+int
+pin_snap_gpio(const int *pins, int cnt, uint32_t *levels, uint32_t *stamp)
+{
+    uint32_t in[2] = { 0, 0 };
+    uint32_t bits = 0;
+    int ports = 0;
+    os_sr_t sr;
+    int i;
+
+    if (cnt > 32) {
+        return -1;
+    }
+    for (i = 0; i < cnt; i++) {
+        if (pins[i] < 0 || pins[i] >= 64) {
+            return -1;
+        }
+        ports |= 1 << (pins[i] / 32);
+    }
+
+    /* back to back, nothing can come between the two ports */
+    OS_ENTER_CRITICAL(sr);
+    *stamp = bsp_usec_get32();
+    if (ports & 1) {
+        in[0] = PORT->Group[0].IN.reg;
+    }
+    if (ports & 2) {
+        in[1] = PORT->Group[1].IN.reg;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    for (i = 0; i < cnt; i++) {
+        if (in[pins[i] / 32] & (1UL << (pins[i] % 32))) {
+            bits |= 1UL << i;
+        }
+    }
+    *levels = bits;
+    return 0;
+}
+
+int
+pin_snap_adc(const enum system_device_id *pins, int cnt, int *values,
+             uint32_t *stamp)
+{
+    uint16_t buf[PIN_SNAP_INPUTS];
+    enum system_device_id first_pin;
+    int first = PIN_SNAP_INPUTS;
+    int last = 0;
+    int ain;
+    os_sr_t sr;
+    int i;
+
+    if (cnt <= 0 || cnt > PIN_SNAP_ADC_MAX) {
+        return -1;
+    }
+    first_pin = pins[0];
+    for (i = 0; i < cnt; i++) {
+        ain = bsp_adc_ain(pins[i]);
+        if (ain < 0) {
+            return -1;
+        }
+        if (ain < first) {
+            first = ain;
+            first_pin = pins[i];
+        }
+        if (ain > last) {
+            last = ain;
+        }
+    }
+    if (bsp_adc_claim()) {
+        return -2;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        bsp_pinmux(pins[i], 1, 0);
+    }
+    bsp_adc_setup(first_pin);
+    ADC->CTRLA.reg |= ADC_CTRLA_ENABLE;
+    bsp_adc_sync();
+
+    /* the first result after the reference is set is not good */
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+    bsp_adc_sync();
+    while (!(ADC->INTFLAG.reg & ADC_INTFLAG_RESRDY));
+    (void) ADC->RESULT.reg;
+
+    /* every start converts the next input of the scan */
+    ADC->INPUTCTRL.reg = ADC_INPUTCTRL_MUXPOS(first) | 
+                         ADC_INPUTCTRL_MUXNEG_GND | 
+                         ADC_INPUTCTRL_GAIN_DIV2 |
+                         ADC_INPUTCTRL_INPUTSCAN(last - first) |
+                         ADC_INPUTCTRL_INPUTOFFSET(0);
+    bsp_adc_sync();
+
+    OS_ENTER_CRITICAL(sr);
+    *stamp = bsp_usec_get32();
+    for (i = 0; i <= last - first; i++) {
+        ADC->SWTRIG.reg = ADC_SWTRIG_START;
+        bsp_adc_sync();
+        while (!(ADC->INTFLAG.reg & ADC_INTFLAG_RESRDY));
+        buf[i] = ADC->RESULT.reg;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    bsp_adc_sync();
+    ADC->INPUTCTRL.reg &= ~(ADC_INPUTCTRL_INPUTSCAN_Msk | 
+                            ADC_INPUTCTRL_INPUTOFFSET_Msk);
+    bsp_adc_sync();
+    bsp_adc_release();
+
+    for (i = 0; i < cnt; i++) {
+        values[i] = buf[bsp_adc_ain(pins[i]) - first];
+    }
+    return 0;
+}
@@ -0,0 +1,385 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <os/os.h>
+#include "mcu/samd21.h"
+#include <bsp/cmsis_nvic.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/uart_dma.h>
+#include "bsp_adc_priv.h"
+#include "bsp_dma_priv.h"
+#include "uart_dma_priv.h"
+
+#define UART_DMA_RX_MASK        (UART_DMA_RX_SIZE - 1)
+#define UART_DMA_TX_MASK        (UART_DMA_TX_SIZE - 1)
+
+/* 
+ * The SAMD21 USART has no idle line interrupt.  Instead the start of 
+ * frame interrupt (RXS) wakes us on the first byte of a burst and is
+ * then turned off. A microsecond alarm checks every few character times
+ * whether the DMA has written anything since, and when it hasn't the 
+ * line is idle and RXS is turned back on.  So a burst costs one RXS 
+ * interrupt plus one alarm per UART_DMA_IDLE_CHARS characters, not one
+ * interrupt per byte.
+ */
+
+struct uart_dma
+{
+    const struct uart_dma_config *cfg;
+    Sercom *sercom;
+    uint8_t rx_buf[UART_DMA_RX_SIZE];
+    uint8_t tx_buf[UART_DMA_TX_SIZE];
+    uint16_t rx_tail;           /* the next byte the reader takes */
+    uint16_t tx_head;           /* where the writer adds */
+    uint16_t tx_tail;           /* start of the block the DMA is sending */
+    uint16_t tx_len;            /* length of that block, 0 when idle */
+    uint16_t idle_pos;          /* rx position at the last idle check */
+    uint32_t rx_written;        /* bytes the DMA wrote up to idle_pos */
+    uint32_t rx_taken;          /* bytes the reader took */
+    uint32_t rx_overruns;
+    uint32_t idle_us;
+    uart_dma_idle_cb cb;
+    void *arg;
+    uint8_t running;
+};
+
+static struct uart_dma uart_dma_port;
+
+/* where the DMA writes the next byte. With beat triggers the channel 
+ * is saved to the write back descriptor after every byte, and reloads
+ * BTCNT to the full size when it wraps */
+static uint16_t
+uart_dma_rx_head(struct uart_dma *pu)
+{
+    return (UART_DMA_RX_SIZE - bsp_dma_wb(BSP_DMA_CH_UART_RX)->BTCNT.reg) &
+           UART_DMA_RX_MASK;
+}
+
+/* 
+ * the number of bytes the DMA wrote that the reader did not take, more
+ * than UART_DMA_RX_SIZE if it lapped the reader.  The idle check runs
+ * every few characters while bytes come in, so the DMA never gets a 
+ * whole ring past idle_pos
+ */
+static uint32_t
+uart_dma_rx_pending(struct uart_dma *pu)
+{
+    uint32_t written;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    written = pu->rx_written + 
+              ((uart_dma_rx_head(pu) - pu->idle_pos) & UART_DMA_RX_MASK);
+    OS_EXIT_CRITICAL(sr);
+    return written - pu->rx_taken;
+}
+
+/* sends the contiguous part of the ring after tx_tail, called with 
+ * interrupts off */
+static void
+uart_dma_tx_kick(struct uart_dma *pu)
+{
+    DmacDescriptor *pdesc = bsp_dma_desc(BSP_DMA_CH_UART_TX);
+    uint16_t len;
+
+    if (pu->tx_head == pu->tx_tail) {
+        pu->tx_len = 0;
+        return;
+    }
+    if (pu->tx_head > pu->tx_tail) {
+        len = pu->tx_head - pu->tx_tail;
+    } else {
+        len = UART_DMA_TX_SIZE - pu->tx_tail;
+    }
+
+    pdesc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+                        DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_INT;
+    pdesc->BTCNT.reg = len;
+    /* with an incrementing address the DMAC wants the end of the block */
+    pdesc->SRCADDR.reg = (uint32_t) &pu->tx_buf[pu->tx_tail + len];
+    pdesc->DSTADDR.reg = (uint32_t) &pu->sercom->USART.DATA.reg;
+    pdesc->DESCADDR.reg = 0;
+    pu->tx_len = len;
+    bsp_dma_start(BSP_DMA_CH_UART_TX);
+}
+
+static void
+uart_dma_tx_irq(int ch, uint8_t flags)
+{
+    struct uart_dma *pu = &uart_dma_port;
+
+    if (flags & DMAC_CHINTFLAG_TCMPL) {
+        pu->tx_tail = (pu->tx_tail + pu->tx_len) & UART_DMA_TX_MASK;
+        uart_dma_tx_kick(pu);
+    }
+}
+
+static void
+uart_dma_idle_check(void *arg)
+{
+    struct uart_dma *pu = arg;
+    uint32_t pending;
+    uint16_t pos;
+
+    /* cleared first, a byte starting from here on interrupts again */
+    pu->sercom->USART.INTFLAG.reg = SERCOM_USART_INTFLAG_RXS;
+    pos = uart_dma_rx_head(pu);
+    if (pos != pu->idle_pos) {
+        pu->rx_written += (pos - pu->idle_pos) & UART_DMA_RX_MASK;
+        pu->idle_pos = pos;
+        bsp_usec_alarm_set(bsp_usec_get32() + pu->idle_us, 
+                           uart_dma_idle_check, pu);
+        return;
+    }
+    pu->sercom->USART.INTENSET.reg = SERCOM_USART_INTENSET_RXS;
+    if (pu->cb) {
+        pending = uart_dma_rx_pending(pu);
+        pu->cb(pu->arg, pending > UART_DMA_RX_SIZE ? -1 : (int) pending);
+    }
+}
+
+static void
+uart_dma_sercom_irq(void)
+{
+    struct uart_dma *pu = &uart_dma_port;
+
+    if (pu->sercom->USART.INTFLAG.reg & SERCOM_USART_INTFLAG_RXS) {
+        pu->sercom->USART.INTENCLR.reg = SERCOM_USART_INTENCLR_RXS;
+        pu->sercom->USART.INTFLAG.reg = SERCOM_USART_INTFLAG_RXS;
+        /* idle_pos stays where the last check left it, the line was 
+         * quiet since */
+        bsp_usec_alarm_set(bsp_usec_get32() + pu->idle_us, 
+                           uart_dma_idle_check, pu);
+    }
+}
+
+static void
+uart_dma_sync(struct uart_dma *pu)
+{
+    while (pu->sercom->USART.SYNCBUSY.reg);
+}
+
+static void
+uart_dma_rx_setup(struct uart_dma *pu)
+{
+    DmacDescriptor *pdesc = bsp_dma_desc(BSP_DMA_CH_UART_RX);
+
+    bsp_dma_setup(BSP_DMA_CH_UART_RX, DMAC_CHCTRLB_LVL(1) |
+                  DMAC_CHCTRLB_TRIGSRC(SERCOM0_DMAC_ID_RX + 
+                                       2 * pu->cfg->sercom) |
+                  DMAC_CHCTRLB_TRIGACT_BEAT, 0, NULL);
+
+    /* links to itself, which makes the buffer circular */
+    pdesc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+                        DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    pdesc->BTCNT.reg = UART_DMA_RX_SIZE;
+    pdesc->SRCADDR.reg = (uint32_t) &pu->sercom->USART.DATA.reg;
+    pdesc->DSTADDR.reg = (uint32_t) &pu->rx_buf[UART_DMA_RX_SIZE];
+    pdesc->DESCADDR.reg = (uint32_t) pdesc;
+    bsp_dma_wb(BSP_DMA_CH_UART_RX)->BTCNT.reg = UART_DMA_RX_SIZE;
+    pu->rx_tail = pu->idle_pos = 0;
+    pu->rx_written = pu->rx_taken = pu->rx_overruns = 0;
+    bsp_dma_start(BSP_DMA_CH_UART_RX);
+}
+
+struct uart_dma *
+uart_dma_create(const struct uart_dma_config *cfg)
+{
+    static Sercom * const sercoms[] = {
+        SERCOM0, SERCOM1, SERCOM2, SERCOM3, SERCOM4, SERCOM5
+    };
+    struct uart_dma *pu = &uart_dma_port;
+
+    if (pu->cfg && pu->cfg != cfg) {
+        return NULL;
+    }
+    pu->cfg = cfg;
+    pu->sercom = sercoms[cfg->sercom];
+    return pu;
+}
+
+int
+uart_dma_start(struct uart_dma *pu, uint32_t baud, uart_dma_idle_cb cb,
+               void *arg)
+{
+    const struct uart_dma_config *cfg = pu->cfg;
+    SercomUsart *usart = &pu->sercom->USART;
+    uint32_t clk = SystemCoreClock;
+
+    /* 16x oversampling */
+    if (baud == 0 || baud > clk / 16) {
+        return -1;
+    }
+    if (pu->running) {
+        return -2;
+    }
+
+    pu->cb = cb;
+    pu->arg = arg;
+    pu->tx_head = pu->tx_tail = pu->tx_len = 0;
+    /* ten bits per character */
+    pu->idle_us = (UART_DMA_IDLE_CHARS * 10 * 1000000UL + baud - 1) / baud;
+
+    PM->APBCMASK.reg |= PM_APBCMASK_SERCOM0 << cfg->sercom;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCLK_CLKCTRL_ID_SERCOM0_CORE_Val + 
+                                        cfg->sercom) | 
+                        GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_CLKEN;
+
+    usart->CTRLA.reg = SERCOM_USART_CTRLA_SWRST;
+    while (usart->CTRLA.bit.SWRST);
+    usart->CTRLA.reg = SERCOM_USART_CTRLA_MODE_USART_INT_CLK | 
+                       SERCOM_USART_CTRLA_DORD |
+                       SERCOM_USART_CTRLA_RXPO(cfg->rxpo) |
+                       SERCOM_USART_CTRLA_TXPO(cfg->txpo);
+    usart->CTRLB.reg = SERCOM_USART_CTRLB_RXEN | SERCOM_USART_CTRLB_TXEN |
+                       SERCOM_USART_CTRLB_SFDE;
+    uart_dma_sync(pu);
+    usart->BAUD.reg = 65536 - (uint16_t) 
+        (((uint64_t) 65536 * 16 * baud + clk / 2) / clk);
+
+    bsp_pinmux(cfg->tx_pin, cfg->pin_func, 0);
+    bsp_pinmux(cfg->rx_pin, cfg->pin_func, 1);
+
+    uart_dma_rx_setup(pu);
+    bsp_dma_setup(BSP_DMA_CH_UART_TX, DMAC_CHCTRLB_LVL(1) |
+                  DMAC_CHCTRLB_TRIGSRC(SERCOM0_DMAC_ID_TX + 
+                                       2 * cfg->sercom) |
+                  DMAC_CHCTRLB_TRIGACT_BEAT, DMAC_CHINTENSET_TCMPL,
+                  uart_dma_tx_irq);
+
+    usart->INTFLAG.reg = SERCOM_USART_INTFLAG_RXS;
+    usart->INTENSET.reg = SERCOM_USART_INTENSET_RXS;
+    NVIC_SetVector(SERCOM0_IRQn + cfg->sercom, 
+                   (uint32_t) uart_dma_sercom_irq);
+    NVIC_EnableIRQ(SERCOM0_IRQn + cfg->sercom);
+
+    usart->CTRLA.bit.ENABLE = 1;
+    uart_dma_sync(pu);
+    pu->running = 1;
+    return 0;
+}
+
+int
+uart_dma_stop(struct uart_dma *pu)
+{
+    SercomUsart *usart = &pu->sercom->USART;
+
+    if (!pu->running) {
+        return 0;
+    }
+    NVIC_DisableIRQ(SERCOM0_IRQn + pu->cfg->sercom);
+    usart->INTENCLR.reg = SERCOM_USART_INTENCLR_MASK;
+    bsp_usec_alarm_stop();
+    bsp_dma_stop(BSP_DMA_CH_UART_RX);
+    bsp_dma_stop(BSP_DMA_CH_UART_TX);
+    usart->CTRLA.bit.ENABLE = 0;
+    uart_dma_sync(pu);
+    pu->running = 0;
+    return 0;
+}
+
+int
+uart_dma_write(struct uart_dma *pu, const uint8_t *data, int len)
+{
+    uint16_t head = pu->tx_head;
+    int space;
+    int cnt;
+    int i;
+    os_sr_t sr;
+
+    if (!pu->running) {
+        return 0;
+    }
+    space = UART_DMA_TX_SIZE - 1 - uart_dma_tx_pending(pu);
+    cnt = len < space ? len : space;
+    for (i = 0; i < cnt; i++) {
+        pu->tx_buf[head] = data[i];
+        head = (head + 1) & UART_DMA_TX_MASK;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    pu->tx_head = head;
+    if (pu->tx_len == 0) {
+        uart_dma_tx_kick(pu);
+    }
+    OS_EXIT_CRITICAL(sr);
+    return cnt;
+}
+
+int
+uart_dma_read(struct uart_dma *pu, uint8_t *data, int len)
+{
+    int avail = uart_dma_rx_avail(pu);
+    int cnt = len < avail ? len : avail;
+    int first;
+
+    if (avail < 0) {
+        return -1;
+    }
+    first = UART_DMA_RX_SIZE - pu->rx_tail;
+    if (first > cnt) {
+        first = cnt;
+    }
+    memcpy(data, &pu->rx_buf[pu->rx_tail], first);
+    memcpy(data + first, pu->rx_buf, cnt - first);
+    pu->rx_tail = (pu->rx_tail + cnt) & UART_DMA_RX_MASK;
+    pu->rx_taken += cnt;
+    return cnt;
+}
+
+int
+uart_dma_peek(struct uart_dma *pu)
+{
+    if (uart_dma_rx_avail(pu) <= 0) {
+        return -1;
+    }
+    return pu->rx_buf[pu->rx_tail];
+}
+
+int
+uart_dma_rx_avail(struct uart_dma *pu)
+{
+    uint32_t pending;
+
+    if (!pu->running) {
+        return 0;
+    }
+    pending = uart_dma_rx_pending(pu);
+    if (pending > UART_DMA_RX_SIZE) {
+        /* what is left may be written over as we read, start afresh */
+        pu->rx_taken += pending;
+        pu->rx_tail = (pu->rx_tail + pending) & UART_DMA_RX_MASK;
+        pu->rx_overruns++;
+        return -1;
+    }
+    return pending;
+}
+
+uint32_t
+uart_dma_rx_overruns(struct uart_dma *pu)
+{
+    return pu->rx_overruns;
+}
+
+int
+uart_dma_tx_pending(struct uart_dma *pu)
+{
+    return (pu->tx_head - pu->tx_tail) & UART_DMA_TX_MASK;
+}
@@ -0,0 +1,43 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __UART_DMA_PRIV_H__
+#define __UART_DMA_PRIV_H__
+
+#include <stdint.h>
+
+/* the SERCOM and pins of a DMA UART, hal_bsp.c has the one for the Bee
+ * socket */
+struct uart_dma_config
+{
+    uint8_t sercom;         /* 0..5 */
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    uint8_t pin_func;       /* the port function giving the SERCOM pads */
+    uint8_t txpo;           /* CTRLA.TXPO, which pad sends */
+    uint8_t rxpo;           /* CTRLA.RXPO, which pad receives */
+};
+
+struct uart_dma;
+
+/* there are DMA channels for a single port, this returns NULL if it 
+ * was already created with another config */
+struct uart_dma *uart_dma_create(const struct uart_dma_config *cfg);
+
+#endif /* __UART_DMA_PRIV_H__ */
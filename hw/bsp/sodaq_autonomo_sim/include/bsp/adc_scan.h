@@ -0,0 +1,66 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ADC_SCAN_H__
+#define __ADC_SCAN_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Background ADC scan.  The ADC free-runs over the analog inputs from the
+ * lowest to the highest pin added, averaging 16 conversions per result,
+ * and DMA writes every result into a slot per input.  Reading a pin is 
+ * then a memory load instead of a conversion.  The CPU is interrupted 
+ * once per pass, only to note the time it ended.  Values are raw 12 bit
+ * counts.
+ *
+ * While pins are added, the ADC belongs to this driver.
+ */
+
+/* the largest raw value, it stands for the reference */
+#define ADC_SCAN_BITS   (12)
+#define ADC_SCAN_MAX    (4095)
+#define ADC_SCAN_REF_MV (3300)
+
+/* adds a pin to the scan, returns -1 for a bad pin and -2 if the ADC is
+ * already in use by another driver */
+int adc_scan_add(enum system_device_id adc_pin);
+
+/* removes a pin, the ADC is released with the last one */
+int adc_scan_remove(enum system_device_id adc_pin);
+
+/* the latest value of a pin and the bsp_usec_get32() time the pass it is
+ * from ended.  Returns -1 if the pin is not scanned and -2 if no pass 
+ * has ended since it was added */
+int adc_scan_read(enum system_device_id adc_pin, int *value, 
+                  uint32_t *stamp);
+
+/* returns the number of passes since the scan started */
+uint32_t adc_scan_passes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_SCAN_H__ */
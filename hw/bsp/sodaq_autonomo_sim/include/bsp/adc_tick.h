@@ -0,0 +1,65 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ADC_TICK_H__
+#define __ADC_TICK_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * One analog pin sampled on a periodic timer tick, for control loops.
+ * The tick is the second compare channel of the microsecond clock.  Its
+ * interrupt takes the result of the conversion started at the tick 
+ * before, starts the next one and calls back with the result, so the
+ * value is one period old but the CPU never waits for the ADC.  Values
+ * are counts of the sim ADC, 10 bits, -1 on the first tick.
+ *
+ * While running, the ADC belongs to this driver.
+ */
+
+#define ADC_TICK_BITS       (10)
+#define ADC_TICK_MAX        (1023)
+/* usecs, leaves time for the conversion and a short loop */
+#define ADC_TICK_MIN_PERIOD (100)
+
+/* called in interrupt context every tick with the value and the 
+ * bsp_usec_get32() time the tick was due at */
+typedef void (*adc_tick_cb)(void *arg, int value, uint32_t due);
+
+/* starts the ticks, returns -1 for a bad pin or period and -2 if the 
+ * ADC is already in use */
+int adc_tick_start(enum system_device_id adc_pin, uint32_t period,
+                   adc_tick_cb cb, void *arg);
+
+int adc_tick_stop(void);
+
+/* returns the ticks skipped since the start because the interrupt was 
+ * held off too long */
+uint32_t adc_tick_missed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_TICK_H__ */
@@ -0,0 +1,92 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ADC_TRIG_H__
+#define __ADC_TRIG_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Hardware triggered ADC conversions.  A timer or pin event is routed 
+ * through EVSYS to the ADC start input and every result is moved to a 
+ * buffer by DMA, so there is no CPU latency between the trigger and the
+ * sample.  The CPU is only interrupted when half of the buffer is full.
+ *
+ * While running, the ADC belongs to this driver. Software reads through
+ * hal_adc will see their settings overwritten.
+ */
+
+enum adc_trig_src
+{
+    ADC_TRIG_PWM_PERIOD = 0,    /* start of every period of a pwm pin */
+    ADC_TRIG_PWM_COMPARE,       /* end of the duty cycle of a pwm pin */
+    ADC_TRIG_PIN_RISE,          /* rising edge on an interrupt pin */
+    ADC_TRIG_PIN_FALL,          /* falling edge on an interrupt pin */
+    ADC_TRIG_ACMP,              /* output change of the comparator open
+                                 * on trig_pin with ACMP_OUT_EVENT */
+    ADC_TRIG_TIMER,             /* every period usecs, on the tick of
+                                 * the microsecond clock */
+};
+
+#define ADC_TRIG_BITS           (10)
+#define ADC_TRIG_MAX            (1023)
+/* usecs, the shortest period of ADC_TRIG_TIMER */
+#define ADC_TRIG_MIN_PERIOD     (50)
+
+/* called in interrupt context with the half of the buffer just filled.
+ * It has to be consumed before the DMA wraps around to it again */
+typedef void (*adc_trig_cb)(void *arg, const uint16_t *samples, int cnt);
+
+struct adc_trig_cfg
+{
+    enum system_device_id adc_pin;      /* analog pin to sample */
+    enum adc_trig_src src;
+    enum system_device_id trig_pin;     /* pwm, interrupt or comparator 
+                                         * pin */
+    uint32_t period;                    /* usecs, for ADC_TRIG_TIMER */
+    uint16_t *buf;
+    uint16_t buf_cnt;                   /* in samples, must be even */
+    adc_trig_cb cb;
+    void *arg;
+};
+
+/* starts sampling, returns -1 for a bad config and -2 if the ADC is
+ * already in use */
+int adc_trig_start(const struct adc_trig_cfg *cfg);
+
+/* stops sampling, a partly filled half buffer is dropped */
+int adc_trig_stop(void);
+
+/* returns the number of samples handed to the callback since start */
+uint32_t adc_trig_samples(void);
+
+/* returns the timer periods skipped since start because the tick 
+ * interrupt was held off, no conversion was started for them */
+uint32_t adc_trig_missed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_TRIG_H__ */
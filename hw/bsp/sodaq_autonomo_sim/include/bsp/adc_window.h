@@ -0,0 +1,64 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ADC_WINDOW_H__
+#define __ADC_WINDOW_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * ADC window monitor.  The ADC free-runs on one analog pin, also in
+ * standby, and the window monitor compares every result against the
+ * band lower..upper in hardware. The CPU is only interrupted when the
+ * value leaves the band and again when it comes back.  Values are raw
+ * counts of the sim ADC, 10 bits.
+ *
+ * While running, the ADC belongs to this driver.
+ */
+
+/* the largest raw value and upper limit of a band */
+#define ADC_WINDOW_MAX  (1023)
+
+/* called in interrupt context on a crossing with the sample that 
+ * crossed, inside is 0 when it left the band and 1 when it came back */
+typedef void (*adc_window_cb)(void *arg, int value, int inside);
+
+/* starts monitoring, returns -1 for a bad pin or band and -2 if the 
+ * ADC is already in use */
+int adc_window_start(enum system_device_id adc_pin, int lower, int upper,
+                     adc_window_cb cb, void *arg);
+
+/* moves the band of the running monitor */
+int adc_window_set(int lower, int upper);
+
+/* returns the latest conversion result */
+int adc_window_value(void);
+
+int adc_window_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_WINDOW_H__ */
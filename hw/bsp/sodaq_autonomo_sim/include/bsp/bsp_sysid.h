@@ -0,0 +1,64 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef BSP_SYSID_H
+#define BSP_SYSID_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The same device names as the SODAQ Autonomo so libraries written for 
+ * the board build unchanged.  The native GPIO HAL only has a few pins, 
+ * so the digital and analog pins are numbered from 0 instead of using 
+ * the SAMD21 port pin numbers */
+enum system_device_id
+{
+    SODAQ_AUTONOMO_D0 =     (0),
+    SODAQ_AUTONOMO_D1 =     (1),
+    SODAQ_AUTONOMO_D2 =     (2),
+    SODAQ_AUTONOMO_D3 =     (3),
+    SODAQ_AUTONOMO_D4 =     (4),
+    SODAQ_AUTONOMO_D5 =     (5),
+    SODAQ_AUTONOMO_D6 =     (6),
+    SODAQ_AUTONOMO_D7 =     (7),
+    SODAQ_AUTONOMO_D8 =     (8),
+    SODAQ_AUTONOMO_D9 =     (9),
+    SODAQ_AUTONOMO_D10 =    (10),
+    SODAQ_AUTONOMO_D11 =    (11),
+    SODAQ_AUTONOMO_D12 =    (12),
+    SODAQ_AUTONOMO_D13 =    (13),
+
+    SODAQ_AUTONOMO_A0 =     (14),
+    SODAQ_AUTONOMO_A1 =     (15),
+    SODAQ_AUTONOMO_A2 =     (16),
+    SODAQ_AUTONOMO_A3 =     (17),
+    SODAQ_AUTONOMO_A4 =     (18),
+    SODAQ_AUTONOMO_A5 =     (19),
+
+    SODAQ_AUTONOMO_SPI_ICSP = 200,
+    SODAQ_AUTONOMO_SPI_ALT  = 201,
+    SODAQ_AUTONOMO_I2C      = 202,
+    SODAQ_AUTONOMO_BEE_UART = 203,
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BSP_SYSID_H */
@@ -0,0 +1,122 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __SIM_PERIPH_H__
+#define __SIM_PERIPH_H__
+
+#include <stdint.h>
+#include <bsp/bsp_sysid.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Deterministic models of the Autonomo peripherals for the sim build.
+ * Everything starts in a known state (ADCs read 0, SPI loops back, no
+ * I2C devices present) and can be scripted from test code through the
+ * functions below.
+ */
+
+#define SIM_ADC_BITS            (10)
+#define SIM_ADC_REF_MV          (3300)
+#define SIM_DAC_BITS            (10)
+#define SIM_DAC_REF_MV          (3300)
+#define SIM_PWM_BITS            (16)
+#define SIM_PWM_CLOCK_HZ        (8000000)
+#define SIM_I2C_MAX_DEVS        (8)
+
+enum sim_adc_source 
+{
+    SIM_ADC_CONST = 0,      /* always returns the same sample */
+    SIM_ADC_RAMP,           /* adds step on every read, wraps at full scale */
+    SIM_ADC_SEQ,            /* plays back a table of samples in a loop */
+    SIM_ADC_DAC,            /* reads back the DAC output, A0 on the board */
+};
+
+/* puts all models back in their reset state */
+void sim_periph_reset(void);
+
+/* ADC sample sources, sysid is one of the analog pins */
+int sim_adc_set_const(enum system_device_id sysid, int value);
+int sim_adc_set_ramp(enum system_device_id sysid, int start, int step);
+int sim_adc_set_seq(enum system_device_id sysid, const uint16_t *samples, 
+                    int cnt);
+int sim_adc_set_dac(enum system_device_id sysid);
+
+/* makes every conversion wrong by a gain and offset, in the form of 
+ * bsp/adc_cal.h, as an uncalibrated part would be.  The correction of 
+ * adc_cal_set() is applied after it */
+int sim_adc_set_error(int offset, int gain);
+
+/* returns the number of conversions done on an analog pin */
+uint32_t sim_adc_reads(enum system_device_id sysid);
+
+/* delivers cnt trigger events to the triggered ADC of bsp/adc_trig.h,
+ * returns the number of conversions started */
+int sim_adc_trig_fire(int cnt);
+
+/* runs cnt ticks of the ADC of bsp/adc_tick.h, returns the number run */
+int sim_adc_tick_fire(int cnt);
+
+/* runs cnt conversions of the free running ADC of bsp/adc_window.h or
+ * bsp/adc_scan.h, whichever owns it, returns the number done */
+int sim_adc_convert(int cnt);
+
+/* sets the voltage on a comparator pin of bsp/acmp.h, a comparator
+ * open on it switches right away */
+int sim_acmp_set_mv(enum system_device_id sysid, int mv);
+
+/* returns the number of output changes a comparator in ACMP_OUT_EVENT
+ * mode has sent to EVSYS */
+uint32_t sim_acmp_events(int comp);
+
+/* bytes arriving on the Bee UART of bsp/uart_dma.h, written to its 
+ * receive ring as the DMA would */
+int sim_uart_rx(const uint8_t *data, int len);
+
+/* the line goes idle, the idle callback runs if bytes came since the 
+ * last time */
+void sim_uart_idle(void);
+
+/* with loopback on, sent bytes are received right away, otherwise they
+ * are kept for sim_uart_tx_take() */
+void sim_uart_set_loopback(int on);
+int sim_uart_tx_take(uint8_t *data, int len);
+
+/* returns the last value written to the DAC */
+int sim_dac_value(void);
+
+/* returns the duty cycle and frequency last set on a pwm pin */
+int sim_pwm_state(enum system_device_id sysid, uint16_t *duty, 
+                  uint32_t *freq_hz);
+
+/* the SPI ports loop MOSI back to MISO, xor_mask is applied to the 
+ * returned byte so tests can tell data was actually transferred */
+int sim_spi_set_loopback(enum system_device_id sysid, uint8_t xor_mask);
+
+/* I2C devices are a single register that reads back what was written */
+int sim_i2c_add_dev(uint8_t address, uint8_t reg);
+int sim_i2c_remove_dev(uint8_t address);
+int sim_i2c_get_reg(uint8_t address, uint8_t *reg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_PERIPH_H__ */
@@ -0,0 +1,51 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdint.h>
+#include <time.h>
+#include <bsp/bsp_usec.h>
+
+static uint64_t bsp_usec_start;
+
+static uint64_t
+bsp_usec_host(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int
+bsp_usec_init(void)
+{
+    bsp_usec_start = bsp_usec_host();
+    return 0;
+}
+
+uint32_t
+bsp_usec_get32(void)
+{
+    return (uint32_t) bsp_usec_get64();
+}
+
+uint64_t
+bsp_usec_get64(void)
+{
+    return bsp_usec_host() - bsp_usec_start;
+}
@@ -0,0 +1,95 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <bsp/bsp.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/sim_periph.h>
+#include <bsp/uart_dma.h>
+#include <hal/hal_flash_int.h>
+#include <hal/hal_adc_int.h>
+#include <hal/hal_dac_int.h>
+#include <hal/hal_pwm_int.h>
+#include <hal/hal_spi_int.h>
+#include <hal/hal_i2c_int.h>
+#include <mcu/native_bsp.h>
+#include "sim_periph_priv.h"
+
+const struct hal_flash *
+bsp_flash_dev(uint8_t id)
+{
+    /*
+     * Just one to start with
+     */
+    if (id != 0) {
+        return NULL;
+    }
+    return &native_flash_dev;
+}
+
+extern struct hal_adc *
+bsp_get_hal_adc(enum system_device_id sysid) 
+{
+    return sim_adc_create(sysid);
+}
+
+extern struct hal_pwm*
+bsp_get_hal_pwm_driver(enum system_device_id sysid) 
+{
+    return sim_pwm_create(sysid);
+}
+
+extern struct hal_dac*
+bsp_get_hal_dac(enum system_device_id sysid) 
+{
+    return sim_dac_create(sysid);
+}
+
+extern struct hal_spi*
+bsp_get_hal_spi(enum system_device_id sysid) 
+{
+    return sim_spi_create(sysid);
+}
+
+extern struct hal_i2c*
+bsp_get_hal_i2c_driver(enum system_device_id sysid)
+{
+    return sim_i2c_create(sysid);
+}
+
+struct uart_dma *
+bsp_get_uart_dma(enum system_device_id sysid)
+{
+    return sim_uart_create(sysid);
+}
+
+void
+sim_periph_reset(void)
+{
+    sim_adc_reset();
+    sim_adc_trig_reset();
+    sim_adc_window_reset();
+    sim_adc_scan_reset();
+    sim_adc_tick_reset();
+    sim_acmp_reset();
+    sim_dac_reset();
+    sim_pwm_reset();
+    sim_spi_reset();
+    sim_i2c_reset();
+    sim_uart_reset();
+}
@@ -0,0 +1,211 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/acmp.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the analog comparators.  Test code sets the voltage on a 
+ * comparator pin with sim_acmp_set_mv() and the outputs are evaluated 
+ * right away, as the hardware would within a microsecond.
+ */
+
+#define SIM_ACMP_NUM        (2)
+#define SIM_ACMP_PINS       (4)
+#define SIM_ACMP_HYST_MV    (50)
+
+static const uint8_t sim_acmp_pins[SIM_ACMP_PINS] = {
+    SODAQ_AUTONOMO_A3, SODAQ_AUTONOMO_A4, 
+    SODAQ_AUTONOMO_D8, SODAQ_AUTONOMO_D9,
+};
+
+static int sim_acmp_mv[SIM_ACMP_PINS];
+
+static struct {
+    int pin;                /* -1 when the comparator is free */
+    struct acmp_cfg cfg;
+    int state;
+    uint32_t events;
+} sim_acmp_cur[SIM_ACMP_NUM];
+
+static int
+sim_acmp_ain(enum system_device_id pin)
+{
+    int i;
+
+    for (i = 0; i < SIM_ACMP_PINS; i++) {
+        if (sim_acmp_pins[i] == pin) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int
+sim_acmp_ref_mv(const struct acmp_cfg *cfg)
+{
+    switch (cfg->ref) {
+        case ACMP_REF_SCALE:
+            return (ACMP_VDD_MV * (cfg->scale + 1)) / 64;
+        case ACMP_REF_BANDGAP:
+            return ACMP_BANDGAP_MV;
+        case ACMP_REF_DAC:
+        default:
+            return (sim_dac_value() * SIM_DAC_REF_MV) >> SIM_DAC_BITS;
+    }
+}
+
+/* the hysteresis moves the switching point away from the current 
+ * output by half its width each way */
+static void
+sim_acmp_eval(int comp)
+{
+    int mv = sim_acmp_mv[sim_acmp_ain(sim_acmp_cur[comp].pin)];
+    int ref = sim_acmp_ref_mv(&sim_acmp_cur[comp].cfg);
+    int state = sim_acmp_cur[comp].state;
+
+    if (sim_acmp_cur[comp].cfg.hyst) {
+        ref += state ? -SIM_ACMP_HYST_MV / 2 : SIM_ACMP_HYST_MV / 2;
+    }
+    if (state ? (mv < ref) : (mv > ref)) {
+        sim_acmp_cur[comp].state = !state;
+        if (sim_acmp_cur[comp].cfg.out == ACMP_OUT_EVENT) {
+            sim_acmp_cur[comp].events++;
+        } else if (sim_acmp_cur[comp].cfg.cb) {
+            sim_acmp_cur[comp].cfg.cb(sim_acmp_cur[comp].cfg.arg, !state);
+        }
+    }
+}
+
+static int
+sim_acmp_valid(const struct acmp_cfg *cfg)
+{
+    return cfg->ref <= ACMP_REF_DAC && cfg->scale <= ACMP_SCALE_MAX &&
+           cfg->out <= ACMP_OUT_EVENT;
+}
+
+int
+acmp_of(enum system_device_id pin)
+{
+    int comp;
+
+    for (comp = 0; comp < SIM_ACMP_NUM; comp++) {
+        if (sim_acmp_cur[comp].pin == pin) {
+            return comp;
+        }
+    }
+    return -1;
+}
+
+int
+acmp_open(enum system_device_id pin, const struct acmp_cfg *cfg)
+{
+    int comp;
+
+    if (sim_acmp_ain(pin) < 0 || !sim_acmp_valid(cfg) || acmp_of(pin) >= 0) {
+        return -1;
+    }
+    for (comp = 0; comp < SIM_ACMP_NUM; comp++) {
+        if (sim_acmp_cur[comp].pin < 0) {
+            break;
+        }
+    }
+    if (comp == SIM_ACMP_NUM) {
+        return -2;
+    }
+    sim_acmp_cur[comp].pin = pin;
+    sim_acmp_cur[comp].cfg = *cfg;
+    /* the output settles without an edge */
+    sim_acmp_cur[comp].state = 
+        sim_acmp_mv[sim_acmp_ain(pin)] > sim_acmp_ref_mv(cfg);
+    sim_acmp_cur[comp].events = 0;
+    return comp;
+}
+
+int
+acmp_config(int comp, const struct acmp_cfg *cfg)
+{
+    if (comp < 0 || comp >= SIM_ACMP_NUM || sim_acmp_cur[comp].pin < 0 ||
+        !sim_acmp_valid(cfg)) {
+        return -1;
+    }
+    sim_acmp_cur[comp].cfg = *cfg;
+    sim_acmp_eval(comp);
+    return 0;
+}
+
+int
+acmp_state(int comp)
+{
+    if (comp < 0 || comp >= SIM_ACMP_NUM || sim_acmp_cur[comp].pin < 0) {
+        return -1;
+    }
+    return sim_acmp_cur[comp].state;
+}
+
+int
+acmp_close(int comp)
+{
+    if (comp < 0 || comp >= SIM_ACMP_NUM || sim_acmp_cur[comp].pin < 0) {
+        return -1;
+    }
+    sim_acmp_cur[comp].pin = -1;
+    return 0;
+}
+
+int
+sim_acmp_set_mv(enum system_device_id sysid, int mv)
+{
+    int ain = sim_acmp_ain(sysid);
+    int comp;
+
+    if (ain < 0) {
+        return -1;
+    }
+    sim_acmp_mv[ain] = mv;
+    comp = acmp_of(sysid);
+    if (comp >= 0) {
+        sim_acmp_eval(comp);
+    }
+    return 0;
+}
+
+uint32_t
+sim_acmp_events(int comp)
+{
+    if (comp < 0 || comp >= SIM_ACMP_NUM) {
+        return 0;
+    }
+    return sim_acmp_cur[comp].events;
+}
+
+void
+sim_acmp_reset(void)
+{
+    int i;
+
+    for (i = 0; i < SIM_ACMP_NUM; i++) {
+        sim_acmp_cur[i].pin = -1;
+    }
+    for (i = 0; i < SIM_ACMP_PINS; i++) {
+        sim_acmp_mv[i] = 0;
+    }
+}
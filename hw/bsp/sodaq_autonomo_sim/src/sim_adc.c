@@ -0,0 +1,344 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <hal/hal_adc.h>
+#include <hal/hal_adc_int.h>
+#include <bsp/bsp.h>
+#include <bsp/adc_cal.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+#define SIM_ADC_CHANNELS    (6)
+#define SIM_ADC_MAX         ((1 << SIM_ADC_BITS) - 1)
+/* gain and offset work on 12 bit counts like on the board */
+#define SIM_ADC_CAL_SHIFT   (12 - SIM_ADC_BITS)
+#define SIM_ADC_CAL_MAX     (4095)
+#define SIM_ADC_CAL_SPAN    (64)
+
+struct sim_adc_channel
+{
+    enum sim_adc_source source;
+    int value;
+    int step;
+    const uint16_t *seq;
+    int seq_cnt;
+    int seq_pos;
+    uint32_t reads;
+};
+
+struct sim_adc
+{
+    struct hal_adc parent;
+    struct sim_adc_channel *pchan;
+};
+
+static struct sim_adc_channel sim_adc_channels[SIM_ADC_CHANNELS];
+static int sim_adc_owned;
+
+/* the error of an uncalibrated part, then the correction of adc_cal.h */
+static struct adc_cal sim_adc_error = { 0, ADC_CAL_GAIN_ONE };
+static struct adc_cal sim_adc_cal = { 0, ADC_CAL_GAIN_ONE };
+
+static int
+sim_adc_clamp(int value)
+{
+    if (value < 0) {
+        return 0;
+    }
+    return value > SIM_ADC_CAL_MAX ? SIM_ADC_CAL_MAX : value;
+}
+
+static int
+sim_adc_apply(int sample)
+{
+    int value = sample << SIM_ADC_CAL_SHIFT;
+
+    value = sim_adc_clamp(((value * sim_adc_error.gain + 
+                            ADC_CAL_GAIN_ONE / 2) >> 11) + 
+                          sim_adc_error.offset);
+    value = sim_adc_clamp(((value - sim_adc_cal.offset) * sim_adc_cal.gain +
+                           ADC_CAL_GAIN_ONE / 2) >> 11);
+    return value >> SIM_ADC_CAL_SHIFT;
+}
+
+static struct sim_adc_channel *
+sim_adc_channel(enum system_device_id sysid)
+{
+    if (sysid < SODAQ_AUTONOMO_A0 || sysid > SODAQ_AUTONOMO_A5) {
+        return NULL;
+    }
+    return &sim_adc_channels[sysid - SODAQ_AUTONOMO_A0];
+}
+
+static int
+sim_adc_channel_sample(struct sim_adc_channel *pchan)
+{
+    int sample;
+
+    pchan->reads++;
+    switch (pchan->source) {
+        case SIM_ADC_RAMP:
+            sample = pchan->value;
+            pchan->value = (pchan->value + pchan->step) & SIM_ADC_MAX;
+            break;
+        case SIM_ADC_SEQ:
+            sample = pchan->seq[pchan->seq_pos];
+            if (++pchan->seq_pos >= pchan->seq_cnt) {
+                pchan->seq_pos = 0;
+            }
+            break;
+        case SIM_ADC_DAC:
+            sample = sim_dac_value() << (SIM_ADC_BITS - SIM_DAC_BITS);
+            break;
+        case SIM_ADC_CONST:
+        default:
+            sample = pchan->value;
+            break;
+    }
+    return sim_adc_apply(sample & SIM_ADC_MAX);
+}
+
+static int
+sim_adc_get_sample(struct hal_adc *padc)
+{
+    return sim_adc_channel_sample(((struct sim_adc *) padc)->pchan);
+}
+
+int
+sim_adc_sample(enum system_device_id sysid)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+
+    if (!pchan) {
+        return -1;
+    }
+    return sim_adc_channel_sample(pchan);
+}
+
+static int
+sim_adc_get_resolution(struct hal_adc *padc)
+{
+    return SIM_ADC_BITS;
+}
+
+static int
+sim_adc_get_reference_mv(struct hal_adc *padc)
+{
+    return SIM_ADC_REF_MV;
+}
+
+static const struct hal_adc_funcs sim_adc_funcs = 
+{
+    .hadc_get_sample = &sim_adc_get_sample,
+    .hadc_get_resolution = &sim_adc_get_resolution,
+    .hadc_get_reference_mv = &sim_adc_get_reference_mv,
+};
+
+struct hal_adc *
+sim_adc_create(enum system_device_id sysid)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+    struct sim_adc *padc;
+
+    if (!pchan) {
+        return NULL;
+    }
+    padc = malloc(sizeof(*padc));
+    if (!padc) {
+        return NULL;
+    }
+    padc->parent.driver_api = &sim_adc_funcs;
+    padc->pchan = pchan;
+    return &padc->parent;
+}
+
+void
+sim_adc_reset(void)
+{
+    memset(sim_adc_channels, 0, sizeof(sim_adc_channels));
+    sim_adc_owned = 0;
+    sim_adc_error.offset = 0;
+    sim_adc_error.gain = ADC_CAL_GAIN_ONE;
+    sim_adc_cal = sim_adc_error;
+}
+
+int
+sim_adc_claim(void)
+{
+    if (sim_adc_owned) {
+        return -2;
+    }
+    sim_adc_owned = 1;
+    return 0;
+}
+
+void
+sim_adc_release(void)
+{
+    sim_adc_owned = 0;
+}
+
+int
+bsp_adc_busy(void)
+{
+    return sim_adc_owned;
+}
+
+int
+sim_adc_set_const(enum system_device_id sysid, int value)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+
+    if (!pchan) {
+        return -1;
+    }
+    pchan->source = SIM_ADC_CONST;
+    pchan->value = value;
+    return 0;
+}
+
+int
+sim_adc_set_ramp(enum system_device_id sysid, int start, int step)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+
+    if (!pchan) {
+        return -1;
+    }
+    pchan->source = SIM_ADC_RAMP;
+    pchan->value = start & SIM_ADC_MAX;
+    pchan->step = step;
+    return 0;
+}
+
+int
+sim_adc_set_seq(enum system_device_id sysid, const uint16_t *samples, int cnt)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+
+    if (!pchan || !samples || cnt <= 0) {
+        return -1;
+    }
+    pchan->source = SIM_ADC_SEQ;
+    pchan->seq = samples;
+    pchan->seq_cnt = cnt;
+    pchan->seq_pos = 0;
+    return 0;
+}
+
+int
+sim_adc_set_dac(enum system_device_id sysid)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+
+    if (!pchan) {
+        return -1;
+    }
+    pchan->source = SIM_ADC_DAC;
+    return 0;
+}
+
+uint32_t
+sim_adc_reads(enum system_device_id sysid)
+{
+    struct sim_adc_channel *pchan = sim_adc_channel(sysid);
+
+    return pchan ? pchan->reads : 0;
+}
+
+int
+sim_adc_set_error(int offset, int gain)
+{
+    if (offset < ADC_CAL_OFFSET_MIN || offset > ADC_CAL_OFFSET_MAX ||
+        gain < ADC_CAL_GAIN_MIN || gain > ADC_CAL_GAIN_MAX) {
+        return -1;
+    }
+    sim_adc_error.offset = offset;
+    sim_adc_error.gain = gain;
+    return 0;
+}
+
+/* the same math as the board, the factory row is all zeroes here */
+int
+adc_cal_from_points(int raw1, int want1, int raw2, int want2,
+                    struct adc_cal *cal)
+{
+    int gain;
+    int offset;
+    int tmp;
+
+    if (raw2 < raw1) {
+        tmp = raw1;
+        raw1 = raw2;
+        raw2 = tmp;
+        tmp = want1;
+        want1 = want2;
+        want2 = tmp;
+    }
+    if (raw1 < 0 || want1 < 0 || raw2 - raw1 < SIM_ADC_CAL_SPAN || 
+        want2 <= want1) {
+        return -1;
+    }
+    gain = (ADC_CAL_GAIN_ONE * (want2 - want1) + (raw2 - raw1) / 2) / 
+           (raw2 - raw1);
+    if (gain < ADC_CAL_GAIN_MIN || gain > ADC_CAL_GAIN_MAX) {
+        return -1;
+    }
+    offset = raw1 - (want1 * ADC_CAL_GAIN_ONE + gain / 2) / gain;
+    if (offset < ADC_CAL_OFFSET_MIN || offset > ADC_CAL_OFFSET_MAX) {
+        return -1;
+    }
+    cal->offset = offset;
+    cal->gain = gain;
+    return 0;
+}
+
+int
+adc_cal_set(const struct adc_cal *cal)
+{
+    static const struct adc_cal off = { 0, ADC_CAL_GAIN_ONE };
+
+    if (!cal) {
+        cal = &off;
+    }
+    if (cal->offset < ADC_CAL_OFFSET_MIN || 
+        cal->offset > ADC_CAL_OFFSET_MAX ||
+        cal->gain < ADC_CAL_GAIN_MIN || cal->gain > ADC_CAL_GAIN_MAX) {
+        return -1;
+    }
+    if (sim_adc_owned) {
+        return -2;
+    }
+    sim_adc_cal = *cal;
+    return 0;
+}
+
+void
+adc_cal_get(struct adc_cal *cal)
+{
+    *cal = sim_adc_cal;
+}
+
+void
+adc_cal_factory(int *linearity, int *bias)
+{
+    *linearity = 0;
+    *bias = 0;
+}
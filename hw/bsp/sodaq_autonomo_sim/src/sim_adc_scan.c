@@ -0,0 +1,145 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_scan.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the background ADC scan.  The free running conversions are
+ * done by sim_adc_convert(), one pin each in order, and a pass ends with
+ * the last pin added like the DMA interrupt.  Values are the pin's model
+ * scaled to 12 bits as the averaging of the board leaves them.
+ */
+
+#define SIM_ADC_SCAN_PINS   (SODAQ_AUTONOMO_A5 - SODAQ_AUTONOMO_A0 + 1)
+
+static int sim_adc_scan_value[SIM_ADC_SCAN_PINS];
+static uint32_t sim_adc_scan_since[SIM_ADC_SCAN_PINS];
+static uint32_t sim_adc_scan_mask;
+static uint32_t sim_adc_scan_stamp;
+static uint32_t sim_adc_scan_cnt;
+static int sim_adc_scan_pos;
+
+static int
+sim_adc_scan_idx(enum system_device_id adc_pin)
+{
+    if (adc_pin < SODAQ_AUTONOMO_A0 || adc_pin > SODAQ_AUTONOMO_A5) {
+        return -1;
+    }
+    return adc_pin - SODAQ_AUTONOMO_A0;
+}
+
+int
+adc_scan_add(enum system_device_id adc_pin)
+{
+    int idx = sim_adc_scan_idx(adc_pin);
+
+    if (idx < 0) {
+        return -1;
+    }
+    if (sim_adc_scan_mask & (1UL << idx)) {
+        return 0;
+    }
+    if (!sim_adc_scan_mask) {
+        if (sim_adc_claim()) {
+            return -2;
+        }
+        sim_adc_scan_cnt = 0;
+    }
+    sim_adc_scan_mask |= (1UL << idx);
+    sim_adc_scan_since[idx] = sim_adc_scan_cnt;
+    /* like the board, a change restarts the pass */
+    sim_adc_scan_pos = 0;
+    return 0;
+}
+
+int
+adc_scan_remove(enum system_device_id adc_pin)
+{
+    int idx = sim_adc_scan_idx(adc_pin);
+
+    if (idx < 0 || !(sim_adc_scan_mask & (1UL << idx))) {
+        return -1;
+    }
+    sim_adc_scan_mask &= ~(1UL << idx);
+    sim_adc_scan_pos = 0;
+    if (!sim_adc_scan_mask) {
+        sim_adc_release();
+    }
+    return 0;
+}
+
+int
+adc_scan_read(enum system_device_id adc_pin, int *value, uint32_t *stamp)
+{
+    int idx = sim_adc_scan_idx(adc_pin);
+
+    if (idx < 0 || !(sim_adc_scan_mask & (1UL << idx))) {
+        return -1;
+    }
+    *value = sim_adc_scan_value[idx];
+    *stamp = sim_adc_scan_stamp;
+    if (sim_adc_scan_cnt == sim_adc_scan_since[idx]) {
+        return -2;
+    }
+    return 0;
+}
+
+uint32_t
+adc_scan_passes(void)
+{
+    return sim_adc_scan_cnt;
+}
+
+int
+sim_adc_scan_convert(int cnt)
+{
+    int i;
+
+    for (i = 0; i < cnt && sim_adc_scan_mask; i++) {
+        while (!(sim_adc_scan_mask & (1UL << sim_adc_scan_pos))) {
+            sim_adc_scan_pos++;
+        }
+        sim_adc_scan_value[sim_adc_scan_pos] = 
+            sim_adc_sample(SODAQ_AUTONOMO_A0 + sim_adc_scan_pos) << 
+            (ADC_SCAN_BITS - SIM_ADC_BITS);
+
+        /* the pass ends with the highest pin */
+        if ((sim_adc_scan_mask >> (sim_adc_scan_pos + 1)) == 0) {
+            sim_adc_scan_pos = 0;
+            sim_adc_scan_stamp = bsp_usec_get32();
+            sim_adc_scan_cnt++;
+        } else {
+            sim_adc_scan_pos++;
+        }
+    }
+    return i;
+}
+
+void
+sim_adc_scan_reset(void)
+{
+    sim_adc_scan_mask = 0;
+    sim_adc_scan_pos = 0;
+    sim_adc_scan_cnt = 0;
+    sim_adc_scan_stamp = 0;
+}
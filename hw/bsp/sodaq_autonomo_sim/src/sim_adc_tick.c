@@ -0,0 +1,94 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_tick.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the ADC sampled on a timer tick.  sim_adc_tick_fire() runs 
+ * the ticks, each one returns the sample taken at the tick before, like
+ * the conversion the board starts and collects a period later.  The 
+ * ticks are due when they are fired, so none is late or missed.
+ */
+
+static enum system_device_id sim_adc_tick_pin;
+static adc_tick_cb sim_adc_tick_func;
+static void *sim_adc_tick_arg;
+static int sim_adc_tick_pending;
+static int sim_adc_tick_running;
+
+int
+adc_tick_start(enum system_device_id adc_pin, uint32_t period,
+               adc_tick_cb cb, void *arg)
+{
+    if (adc_pin < SODAQ_AUTONOMO_A0 || adc_pin > SODAQ_AUTONOMO_A5 || 
+        period < ADC_TICK_MIN_PERIOD || !cb) {
+        return -1;
+    }
+    if (sim_adc_claim()) {
+        return -2;
+    }
+    sim_adc_tick_pin = adc_pin;
+    sim_adc_tick_func = cb;
+    sim_adc_tick_arg = arg;
+    sim_adc_tick_pending = -1;
+    sim_adc_tick_running = 1;
+    return 0;
+}
+
+int
+adc_tick_stop(void)
+{
+    if (sim_adc_tick_running) {
+        sim_adc_tick_running = 0;
+        sim_adc_release();
+    }
+    return 0;
+}
+
+uint32_t
+adc_tick_missed(void)
+{
+    return 0;
+}
+
+int
+sim_adc_tick_fire(int cnt)
+{
+    int value;
+    int i;
+
+    for (i = 0; i < cnt && sim_adc_tick_running; i++) {
+        value = sim_adc_tick_pending;
+        sim_adc_tick_pending = sim_adc_sample(sim_adc_tick_pin);
+        sim_adc_tick_func(sim_adc_tick_arg, value, bsp_usec_get32());
+    }
+    return i;
+}
+
+void
+sim_adc_tick_reset(void)
+{
+    sim_adc_tick_running = 0;
+    sim_adc_tick_pending = -1;
+}
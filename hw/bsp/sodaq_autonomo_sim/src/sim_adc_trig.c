@@ -0,0 +1,150 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/adc_trig.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/acmp.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the triggered ADC.  There is no pin behind the trigger, test
+ * code calls sim_adc_trig_fire() for every event and the sample is 
+ * written to the buffer as the DMA would.  The timer trigger runs on 
+ * the host clock instead; the conversions that fell due since the last
+ * call are taken whenever adc_trig_samples() is called.
+ */
+
+static struct adc_trig_cfg sim_adc_trig_cur;
+static uint32_t sim_adc_trig_cnt;
+static int sim_adc_trig_pos;
+static int sim_adc_trig_running;
+static uint32_t sim_adc_trig_start;
+static uint32_t sim_adc_trig_ticks;
+
+static int
+sim_adc_trig_valid(const struct adc_trig_cfg *cfg)
+{
+    switch (cfg->src) {
+        case ADC_TRIG_PWM_PERIOD:
+        case ADC_TRIG_PWM_COMPARE:
+            /* same pwm pins as the pwm model */
+            return cfg->trig_pin >= SODAQ_AUTONOMO_D2 && 
+                   cfg->trig_pin <= SODAQ_AUTONOMO_D13;
+        case ADC_TRIG_PIN_RISE:
+        case ADC_TRIG_PIN_FALL:
+            return cfg->trig_pin >= SODAQ_AUTONOMO_D0 && 
+                   cfg->trig_pin <= SODAQ_AUTONOMO_A5;
+        case ADC_TRIG_ACMP:
+            return acmp_of(cfg->trig_pin) >= 0;
+        case ADC_TRIG_TIMER:
+            return cfg->period >= ADC_TRIG_MIN_PERIOD;
+        default:
+            return 0;
+    }
+}
+
+int
+adc_trig_start(const struct adc_trig_cfg *cfg)
+{
+    if (cfg->adc_pin < SODAQ_AUTONOMO_A0 || cfg->adc_pin > SODAQ_AUTONOMO_A5 ||
+        !cfg->buf || cfg->buf_cnt < 2 || (cfg->buf_cnt & 1) || 
+        !sim_adc_trig_valid(cfg)) {
+        return -1;
+    }
+    if (sim_adc_claim()) {
+        return -2;
+    }
+    sim_adc_trig_cur = *cfg;
+    sim_adc_trig_cnt = 0;
+    sim_adc_trig_pos = 0;
+    sim_adc_trig_start = bsp_usec_get32();
+    sim_adc_trig_ticks = 0;
+    sim_adc_trig_running = 1;
+    return 0;
+}
+
+int
+adc_trig_stop(void)
+{
+    if (sim_adc_trig_running) {
+        sim_adc_trig_running = 0;
+        sim_adc_release();
+    }
+    return 0;
+}
+
+uint32_t
+adc_trig_samples(void)
+{
+    uint32_t due;
+
+    if (sim_adc_trig_running && sim_adc_trig_cur.src == ADC_TRIG_TIMER) {
+        due = (bsp_usec_get32() - sim_adc_trig_start) / 
+              sim_adc_trig_cur.period;
+        if (due > sim_adc_trig_ticks) {
+            sim_adc_trig_fire(due - sim_adc_trig_ticks);
+            sim_adc_trig_ticks = due;
+        }
+    }
+    return sim_adc_trig_cnt;
+}
+
+uint32_t
+adc_trig_missed(void)
+{
+    return 0;
+}
+
+int
+sim_adc_trig_fire(int cnt)
+{
+    struct adc_trig_cfg *cfg = &sim_adc_trig_cur;
+    int half = cfg->buf_cnt / 2;
+    int i;
+
+    if (!sim_adc_trig_running) {
+        return 0;
+    }
+    for (i = 0; i < cnt && sim_adc_trig_running; i++) {
+        cfg->buf[sim_adc_trig_pos++] = sim_adc_sample(cfg->adc_pin);
+        if (sim_adc_trig_pos % half == 0) {
+            sim_adc_trig_cnt += half;
+            if (cfg->cb) {
+                cfg->cb(cfg->arg, &cfg->buf[sim_adc_trig_pos - half], half);
+            }
+            if (sim_adc_trig_pos == cfg->buf_cnt) {
+                sim_adc_trig_pos = 0;
+            }
+        }
+    }
+    return i;
+}
+
+void
+sim_adc_trig_reset(void)
+{
+    memset(&sim_adc_trig_cur, 0, sizeof(sim_adc_trig_cur));
+    sim_adc_trig_cnt = 0;
+    sim_adc_trig_pos = 0;
+    sim_adc_trig_ticks = 0;
+    sim_adc_trig_running = 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/adc_window.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the ADC window monitor.  The free running conversions are
+ * done by sim_adc_convert(), each one samples the pin's model and the
+ * callback runs on every crossing of the band, like the interrupt.
+ */
+
+static enum system_device_id sim_adc_window_pin;
+static int sim_adc_window_lower;
+static int sim_adc_window_upper;
+static adc_window_cb sim_adc_window_func;
+static void *sim_adc_window_arg;
+static int sim_adc_window_last;
+static int sim_adc_window_inside;
+static int sim_adc_window_running;
+
+int
+adc_window_start(enum system_device_id adc_pin, int lower, int upper,
+                 adc_window_cb cb, void *arg)
+{
+    if (adc_pin < SODAQ_AUTONOMO_A0 || adc_pin > SODAQ_AUTONOMO_A5 || 
+        lower < 0 || upper > ADC_WINDOW_MAX || lower >= upper) {
+        return -1;
+    }
+    if (sim_adc_claim()) {
+        return -2;
+    }
+    sim_adc_window_pin = adc_pin;
+    sim_adc_window_lower = lower;
+    sim_adc_window_upper = upper;
+    sim_adc_window_func = cb;
+    sim_adc_window_arg = arg;
+    sim_adc_window_last = 0;
+    sim_adc_window_inside = 1;
+    sim_adc_window_running = 1;
+    return 0;
+}
+
+int
+adc_window_set(int lower, int upper)
+{
+    if (!sim_adc_window_running || lower < 0 || 
+        upper > ADC_WINDOW_MAX || lower >= upper) {
+        return -1;
+    }
+    sim_adc_window_lower = lower;
+    sim_adc_window_upper = upper;
+    return 0;
+}
+
+int
+adc_window_value(void)
+{
+    if (!sim_adc_window_running) {
+        return -1;
+    }
+    return sim_adc_window_last;
+}
+
+int
+adc_window_stop(void)
+{
+    if (sim_adc_window_running) {
+        sim_adc_window_running = 0;
+        sim_adc_release();
+    }
+    return 0;
+}
+
+int
+sim_adc_convert(int cnt)
+{
+    int inside;
+    int value;
+    int i;
+
+    if (!sim_adc_window_running) {
+        return sim_adc_scan_convert(cnt);
+    }
+    for (i = 0; i < cnt && sim_adc_window_running; i++) {
+        value = sim_adc_sample(sim_adc_window_pin);
+        sim_adc_window_last = value;
+
+        /* the hardware band excludes both limits */
+        inside = value > sim_adc_window_lower && 
+                 value < sim_adc_window_upper;
+        if (inside != sim_adc_window_inside) {
+            sim_adc_window_inside = inside;
+            if (sim_adc_window_func) {
+                sim_adc_window_func(sim_adc_window_arg, value, inside);
+            }
+        }
+    }
+    return i;
+}
+
+void
+sim_adc_window_reset(void)
+{
+    sim_adc_window_running = 0;
+    sim_adc_window_func = NULL;
+    sim_adc_window_last = 0;
+}
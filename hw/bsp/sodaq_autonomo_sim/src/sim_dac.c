@@ -0,0 +1,100 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <hal/hal_dac.h>
+#include <hal/hal_dac_int.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+#define SIM_DAC_MAX         ((1 << SIM_DAC_BITS) - 1)
+
+/* the board has a single DAC on A0 */
+static int sim_dac_out;
+
+static int
+sim_dac_write(struct hal_dac *pdac, int val)
+{
+    if (val < 0 || val > SIM_DAC_MAX) {
+        return -1;
+    }
+    sim_dac_out = val;
+    return 0;
+}
+
+static int
+sim_dac_current(struct hal_dac *pdac)
+{
+    return sim_dac_out;
+}
+
+static int
+sim_dac_get_bits(struct hal_dac *pdac)
+{
+    return SIM_DAC_BITS;
+}
+
+static int
+sim_dac_get_ref_mv(struct hal_dac *pdac)
+{
+    return SIM_DAC_REF_MV;
+}
+
+static int
+sim_dac_disable(struct hal_dac *pdac)
+{
+    sim_dac_out = 0;
+    return 0;
+}
+
+static const struct hal_dac_funcs sim_dac_funcs = 
+{
+    .hdac_write = &sim_dac_write,
+    .hdac_current = &sim_dac_current,
+    .hdac_get_bits = &sim_dac_get_bits,
+    .hdac_get_ref_mv = &sim_dac_get_ref_mv,
+    .hdac_disable = &sim_dac_disable,
+};
+
+struct hal_dac *
+sim_dac_create(enum system_device_id sysid)
+{
+    struct hal_dac *pdac;
+
+    if (sysid != SODAQ_AUTONOMO_A0) {
+        return NULL;
+    }
+    pdac = malloc(sizeof(*pdac));
+    if (!pdac) {
+        return NULL;
+    }
+    pdac->driver_api = &sim_dac_funcs;
+    return pdac;
+}
+
+void
+sim_dac_reset(void)
+{
+    sim_dac_out = 0;
+}
+
+int
+sim_dac_value(void)
+{
+    return sim_dac_out;
+}
@@ -0,0 +1,179 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <hal/hal_i2c.h>
+#include <hal/hal_i2c_int.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+struct sim_i2c_dev
+{
+    uint8_t present;
+    uint8_t address;
+    uint8_t reg;
+};
+
+static struct sim_i2c_dev sim_i2c_devs[SIM_I2C_MAX_DEVS];
+static int sim_i2c_started;
+
+static struct sim_i2c_dev *
+sim_i2c_find(uint8_t address)
+{
+    int i;
+
+    for (i = 0; i < SIM_I2C_MAX_DEVS; i++) {
+        if (sim_i2c_devs[i].present && sim_i2c_devs[i].address == address) {
+            return &sim_i2c_devs[i];
+        }
+    }
+    return NULL;
+}
+
+static int
+sim_i2c_write_data(struct hal_i2c *pi2c, struct hal_i2c_master_data *ppkt)
+{
+    struct sim_i2c_dev *pdev;
+
+    if (!sim_i2c_started) {
+        return -1;
+    }
+    pdev = sim_i2c_find(ppkt->address);
+    if (!pdev) {
+        /* nobody acked the address */
+        return -2;
+    }
+    if (ppkt->len) {
+        pdev->reg = ppkt->buffer[ppkt->len - 1];
+    }
+    return 0;
+}
+
+static int
+sim_i2c_read_data(struct hal_i2c *pi2c, struct hal_i2c_master_data *ppkt)
+{
+    struct sim_i2c_dev *pdev;
+
+    if (!sim_i2c_started) {
+        return -1;
+    }
+    pdev = sim_i2c_find(ppkt->address);
+    if (!pdev) {
+        return -2;
+    }
+    memset(ppkt->buffer, pdev->reg, ppkt->len);
+    return 0;
+}
+
+static int
+sim_i2c_probe(struct hal_i2c *pi2c, uint8_t address)
+{
+    return sim_i2c_find(address) ? 0 : -2;
+}
+
+static int
+sim_i2c_start(struct hal_i2c *pi2c)
+{
+    sim_i2c_started = 1;
+    return 0;
+}
+
+static int
+sim_i2c_stop(struct hal_i2c *pi2c)
+{
+    sim_i2c_started = 0;
+    return 0;
+}
+
+static const struct hal_i2c_funcs sim_i2c_funcs = 
+{
+    .hi2cm_write_data = &sim_i2c_write_data,
+    .hi2cm_read_data = &sim_i2c_read_data,
+    .hi2cm_probe = &sim_i2c_probe,
+    .hi2cm_start = &sim_i2c_start,
+    .hi2cm_stop = &sim_i2c_stop,
+};
+
+struct hal_i2c *
+sim_i2c_create(enum system_device_id sysid)
+{
+    struct hal_i2c *pi2c;
+
+    if (sysid != SODAQ_AUTONOMO_I2C) {
+        return NULL;
+    }
+    pi2c = malloc(sizeof(*pi2c));
+    if (!pi2c) {
+        return NULL;
+    }
+    pi2c->driver_api = &sim_i2c_funcs;
+    return pi2c;
+}
+
+void
+sim_i2c_reset(void)
+{
+    memset(sim_i2c_devs, 0, sizeof(sim_i2c_devs));
+    sim_i2c_started = 0;
+}
+
+int
+sim_i2c_add_dev(uint8_t address, uint8_t reg)
+{
+    struct sim_i2c_dev *pdev;
+    int i;
+
+    pdev = sim_i2c_find(address);
+    for (i = 0; !pdev && i < SIM_I2C_MAX_DEVS; i++) {
+        if (!sim_i2c_devs[i].present) {
+            pdev = &sim_i2c_devs[i];
+        }
+    }
+    if (!pdev) {
+        return -1;
+    }
+    pdev->present = 1;
+    pdev->address = address;
+    pdev->reg = reg;
+    return 0;
+}
+
+int
+sim_i2c_remove_dev(uint8_t address)
+{
+    struct sim_i2c_dev *pdev = sim_i2c_find(address);
+
+    if (!pdev) {
+        return -1;
+    }
+    pdev->present = 0;
+    return 0;
+}
+
+int
+sim_i2c_get_reg(uint8_t address, uint8_t *reg)
+{
+    struct sim_i2c_dev *pdev = sim_i2c_find(address);
+
+    if (!pdev) {
+        return -1;
+    }
+    *reg = pdev->reg;
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __SIM_PERIPH_PRIV_H__
+#define __SIM_PERIPH_PRIV_H__
+
+#include <bsp/bsp_sysid.h>
+
+struct hal_adc;
+struct hal_dac;
+struct hal_pwm;
+struct hal_spi;
+struct hal_i2c;
+struct uart_dma;
+
+/* driver factories used by hal_bsp.c, they return NULL for sysids the
+ * model does not support */
+struct hal_adc *sim_adc_create(enum system_device_id sysid);
+struct hal_dac *sim_dac_create(enum system_device_id sysid);
+struct hal_pwm *sim_pwm_create(enum system_device_id sysid);
+struct hal_spi *sim_spi_create(enum system_device_id sysid);
+struct hal_i2c *sim_i2c_create(enum system_device_id sysid);
+struct uart_dma *sim_uart_create(enum system_device_id sysid);
+
+/* takes one sample from the model of an analog pin, -1 if there is none */
+int sim_adc_sample(enum system_device_id sysid);
+
+/* ownership of the ADC by the triggered and window drivers, like the
+ * board's */
+int sim_adc_claim(void);
+void sim_adc_release(void);
+
+void sim_adc_reset(void);
+void sim_adc_trig_reset(void);
+void sim_adc_window_reset(void);
+void sim_adc_scan_reset(void);
+void sim_adc_tick_reset(void);
+
+/* runs cnt conversions of the scan of bsp/adc_scan.h if it owns the 
+ * ADC, returns the number done */
+int sim_adc_scan_convert(int cnt);
+void sim_acmp_reset(void);
+void sim_dac_reset(void);
+void sim_pwm_reset(void);
+void sim_spi_reset(void);
+void sim_i2c_reset(void);
+void sim_uart_reset(void);
+
+#endif /* __SIM_PERIPH_PRIV_H__ */
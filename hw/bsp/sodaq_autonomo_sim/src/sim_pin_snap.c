@@ -0,0 +1,87 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <os/os.h>
+#include <hal/hal_gpio.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/pin_snap.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the snapshot reads.  The levels are read pin by pin from the
+ * gpio model with interrupts off, the analog pins take one sample each
+ * from their models, scaled to 12 bits.  Both are done at one time.
+ */
+
+int
+pin_snap_gpio(const int *pins, int cnt, uint32_t *levels, uint32_t *stamp)
+{
+    uint32_t bits = 0;
+    os_sr_t sr;
+    int i;
+
+    if (cnt > 32) {
+        return -1;
+    }
+    for (i = 0; i < cnt; i++) {
+        if (pins[i] < 0 || pins[i] >= 64) {
+            return -1;
+        }
+    }
+    OS_ENTER_CRITICAL(sr);
+    *stamp = bsp_usec_get32();
+    for (i = 0; i < cnt; i++) {
+        if (hal_gpio_read(pins[i]) > 0) {
+            bits |= 1UL << i;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+    *levels = bits;
+    return 0;
+}
+
+int
+pin_snap_adc(const enum system_device_id *pins, int cnt, int *values,
+             uint32_t *stamp)
+{
+    int value;
+    int i;
+
+    if (cnt <= 0 || cnt > PIN_SNAP_ADC_MAX) {
+        return -1;
+    }
+    for (i = 0; i < cnt; i++) {
+        if (pins[i] < SODAQ_AUTONOMO_A0 || pins[i] > SODAQ_AUTONOMO_A5) {
+            return -1;
+        }
+    }
+    if (sim_adc_claim()) {
+        return -2;
+    }
+    *stamp = bsp_usec_get32();
+    for (i = 0; i < cnt; i++) {
+        value = sim_adc_sample(pins[i]);
+        values[i] = value < 0 ? 0 : 
+                    value << (PIN_SNAP_ADC_BITS - SIM_ADC_BITS);
+    }
+    sim_adc_release();
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <hal/hal_pwm.h>
+#include <hal/hal_pwm_int.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* the digital pins the board can drive from a timer */
+#define SIM_PWM_CHANNELS    (SODAQ_AUTONOMO_D13 + 1)
+
+struct sim_pwm_channel
+{
+    uint16_t duty;
+    uint32_t freq_hz;
+};
+
+struct sim_pwm
+{
+    struct hal_pwm parent;
+    struct sim_pwm_channel *pchan;
+};
+
+static struct sim_pwm_channel sim_pwm_channels[SIM_PWM_CHANNELS];
+
+static struct sim_pwm_channel *
+sim_pwm_channel(enum system_device_id sysid)
+{
+    if (sysid < SODAQ_AUTONOMO_D2 || sysid > SODAQ_AUTONOMO_D13) {
+        return NULL;
+    }
+    return &sim_pwm_channels[sysid];
+}
+
+static int
+sim_pwm_disable(struct hal_pwm *ppwm)
+{
+    ((struct sim_pwm *) ppwm)->pchan->duty = 0;
+    return 0;
+}
+
+static int
+sim_pwm_ena_duty(struct hal_pwm *ppwm, uint16_t fraction)
+{
+    ((struct sim_pwm *) ppwm)->pchan->duty = fraction;
+    return 0;
+}
+
+static int
+sim_pwm_set_freq(struct hal_pwm *ppwm, uint32_t freq_hz)
+{
+    if (freq_hz == 0 || freq_hz > SIM_PWM_CLOCK_HZ) {
+        return -1;
+    }
+    ((struct sim_pwm *) ppwm)->pchan->freq_hz = freq_hz;
+    return 0;
+}
+
+static int
+sim_pwm_get_clk(struct hal_pwm *ppwm)
+{
+    return SIM_PWM_CLOCK_HZ;
+}
+
+static int
+sim_pwm_get_bits(struct hal_pwm *ppwm)
+{
+    return SIM_PWM_BITS;
+}
+
+static const struct hal_pwm_funcs sim_pwm_funcs = 
+{
+    .hpwm_disable = &sim_pwm_disable,
+    .hpwm_ena_duty = &sim_pwm_ena_duty,
+    .hpwm_set_freq = &sim_pwm_set_freq,
+    .hpwm_get_clk = &sim_pwm_get_clk,
+    .hpwm_get_bits = &sim_pwm_get_bits,
+};
+
+struct hal_pwm *
+sim_pwm_create(enum system_device_id sysid)
+{
+    struct sim_pwm_channel *pchan = sim_pwm_channel(sysid);
+    struct sim_pwm *ppwm;
+
+    if (!pchan) {
+        return NULL;
+    }
+    ppwm = malloc(sizeof(*ppwm));
+    if (!ppwm) {
+        return NULL;
+    }
+    ppwm->parent.driver_api = &sim_pwm_funcs;
+    ppwm->pchan = pchan;
+    return &ppwm->parent;
+}
+
+void
+sim_pwm_reset(void)
+{
+    memset(sim_pwm_channels, 0, sizeof(sim_pwm_channels));
+}
+
+int
+sim_pwm_state(enum system_device_id sysid, uint16_t *duty, uint32_t *freq_hz)
+{
+    struct sim_pwm_channel *pchan = sim_pwm_channel(sysid);
+
+    if (!pchan) {
+        return -1;
+    }
+    if (duty) {
+        *duty = pchan->duty;
+    }
+    if (freq_hz) {
+        *freq_hz = pchan->freq_hz;
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_spi_int.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* one entry for SPI_ICSP and one for SPI_ALT */
+#define SIM_SPI_PORTS       (2)
+
+struct sim_spi
+{
+    struct hal_spi parent;
+    int port;
+};
+
+static uint8_t sim_spi_xor[SIM_SPI_PORTS];
+static uint8_t sim_spi_configured[SIM_SPI_PORTS];
+
+static int
+sim_spi_port(enum system_device_id sysid)
+{
+    switch (sysid) {
+        case SODAQ_AUTONOMO_SPI_ICSP:
+            return 0;
+        case SODAQ_AUTONOMO_SPI_ALT:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+static int
+sim_spi_config(struct hal_spi *pspi, struct hal_spi_settings *psettings)
+{
+    if (psettings->baudrate == 0) {
+        return -1;
+    }
+    sim_spi_configured[((struct sim_spi *) pspi)->port] = 1;
+    return 0;
+}
+
+static int
+sim_spi_master_transfer(struct hal_spi *pspi, uint16_t tx)
+{
+    int port = ((struct sim_spi *) pspi)->port;
+
+    if (!sim_spi_configured[port]) {
+        return -1;
+    }
+    /* MOSI is wired to MISO */
+    return (tx ^ sim_spi_xor[port]) & 0xff;
+}
+
+static const struct hal_spi_funcs sim_spi_funcs = 
+{
+    .hspi_config = &sim_spi_config,
+    .hspi_master_transfer = &sim_spi_master_transfer,
+};
+
+struct hal_spi *
+sim_spi_create(enum system_device_id sysid)
+{
+    int port = sim_spi_port(sysid);
+    struct sim_spi *pspi;
+
+    if (port < 0) {
+        return NULL;
+    }
+    pspi = malloc(sizeof(*pspi));
+    if (!pspi) {
+        return NULL;
+    }
+    pspi->parent.driver_api = &sim_spi_funcs;
+    pspi->port = port;
+    sim_spi_configured[port] = 0;
+    return &pspi->parent;
+}
+
+void
+sim_spi_reset(void)
+{
+    int i;
+
+    for (i = 0; i < SIM_SPI_PORTS; i++) {
+        sim_spi_xor[i] = 0;
+        sim_spi_configured[i] = 0;
+    }
+}
+
+int
+sim_spi_set_loopback(enum system_device_id sysid, uint8_t xor_mask)
+{
+    int port = sim_spi_port(sysid);
+
+    if (port < 0) {
+        return -1;
+    }
+    sim_spi_xor[port] = xor_mask;
+    return 0;
+}
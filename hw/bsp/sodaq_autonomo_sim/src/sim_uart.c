@@ -0,0 +1,235 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <bsp/bsp_sysid.h>
+#include <bsp/uart_dma.h>
+#include <bsp/sim_periph.h>
+#include "sim_periph_priv.h"
+
+/* 
+ * Model of the Bee socket UART.  Sending takes no time: the bytes are 
+ * either looped back into the receive ring or kept for the test to 
+ * take.  Received bytes go into the ring the way the DMA writes them, 
+ * overwriting what the reader did not take in time.
+ */
+
+#define SIM_UART_MAX_BAUD   (48000000 / 16)
+#define SIM_UART_RX_MASK    (UART_DMA_RX_SIZE - 1)
+#define SIM_UART_TX_MASK    (UART_DMA_TX_SIZE - 1)
+
+struct uart_dma
+{
+    uint8_t rx_buf[UART_DMA_RX_SIZE];
+    uint8_t tx_buf[UART_DMA_TX_SIZE];
+    uint16_t rx_head;
+    uint16_t rx_tail;
+    uint16_t tx_head;
+    uint16_t tx_tail;
+    uint16_t rx_new;            /* bytes since the line was last idle */
+    uint32_t rx_written;
+    uint32_t rx_taken;
+    uint32_t rx_overruns;
+    uart_dma_idle_cb cb;
+    void *arg;
+    uint8_t loopback;
+    uint8_t running;
+};
+
+static struct uart_dma sim_uart_port;
+
+struct uart_dma *
+sim_uart_create(enum system_device_id sysid)
+{
+    if (sysid != SODAQ_AUTONOMO_BEE_UART) {
+        return NULL;
+    }
+    return &sim_uart_port;
+}
+
+int
+uart_dma_start(struct uart_dma *pu, uint32_t baud, uart_dma_idle_cb cb,
+               void *arg)
+{
+    if (baud == 0 || baud > SIM_UART_MAX_BAUD) {
+        return -1;
+    }
+    if (pu->running) {
+        return -2;
+    }
+    pu->rx_head = pu->rx_tail = pu->rx_new = 0;
+    pu->rx_written = pu->rx_taken = pu->rx_overruns = 0;
+    pu->tx_head = pu->tx_tail = 0;
+    pu->cb = cb;
+    pu->arg = arg;
+    pu->running = 1;
+    return 0;
+}
+
+int
+uart_dma_stop(struct uart_dma *pu)
+{
+    pu->running = 0;
+    return 0;
+}
+
+static void
+sim_uart_rx_byte(struct uart_dma *pu, uint8_t byte)
+{
+    pu->rx_buf[pu->rx_head] = byte;
+    pu->rx_head = (pu->rx_head + 1) & SIM_UART_RX_MASK;
+    pu->rx_new++;
+    pu->rx_written++;
+}
+
+int
+uart_dma_write(struct uart_dma *pu, const uint8_t *data, int len)
+{
+    int space;
+    int cnt;
+    int i;
+
+    if (!pu->running) {
+        return 0;
+    }
+    space = UART_DMA_TX_SIZE - 1 - uart_dma_tx_pending(pu);
+    cnt = len < space ? len : space;
+    for (i = 0; i < cnt; i++) {
+        if (pu->loopback) {
+            sim_uart_rx_byte(pu, data[i]);
+        } else {
+            pu->tx_buf[pu->tx_head] = data[i];
+            pu->tx_head = (pu->tx_head + 1) & SIM_UART_TX_MASK;
+        }
+    }
+    return cnt;
+}
+
+int
+uart_dma_read(struct uart_dma *pu, uint8_t *data, int len)
+{
+    int avail = uart_dma_rx_avail(pu);
+    int cnt = len < avail ? len : avail;
+    int i;
+
+    if (avail < 0) {
+        return -1;
+    }
+    for (i = 0; i < cnt; i++) {
+        data[i] = pu->rx_buf[pu->rx_tail];
+        pu->rx_tail = (pu->rx_tail + 1) & SIM_UART_RX_MASK;
+    }
+    pu->rx_taken += cnt;
+    return cnt;
+}
+
+int
+uart_dma_peek(struct uart_dma *pu)
+{
+    if (uart_dma_rx_avail(pu) <= 0) {
+        return -1;
+    }
+    return pu->rx_buf[pu->rx_tail];
+}
+
+int
+uart_dma_rx_avail(struct uart_dma *pu)
+{
+    uint32_t pending = pu->rx_written - pu->rx_taken;
+
+    if (!pu->running) {
+        return 0;
+    }
+    if (pending > UART_DMA_RX_SIZE) {
+        pu->rx_taken = pu->rx_written;
+        pu->rx_tail = pu->rx_head;
+        pu->rx_overruns++;
+        return -1;
+    }
+    return pending;
+}
+
+uint32_t
+uart_dma_rx_overruns(struct uart_dma *pu)
+{
+    return pu->rx_overruns;
+}
+
+int
+uart_dma_tx_pending(struct uart_dma *pu)
+{
+    /* the bytes the test has not taken yet */
+    return (pu->tx_head - pu->tx_tail) & SIM_UART_TX_MASK;
+}
+
+int
+sim_uart_rx(const uint8_t *data, int len)
+{
+    struct uart_dma *pu = &sim_uart_port;
+    int i;
+
+    if (!pu->running) {
+        return -1;
+    }
+    for (i = 0; i < len; i++) {
+        sim_uart_rx_byte(pu, data[i]);
+    }
+    return 0;
+}
+
+void
+sim_uart_idle(void)
+{
+    struct uart_dma *pu = &sim_uart_port;
+    uint32_t pending;
+
+    if (pu->running && pu->rx_new) {
+        pu->rx_new = 0;
+        if (pu->cb) {
+            pending = pu->rx_written - pu->rx_taken;
+            pu->cb(pu->arg, 
+                   pending > UART_DMA_RX_SIZE ? -1 : (int) pending);
+        }
+    }
+}
+
+void
+sim_uart_set_loopback(int on)
+{
+    sim_uart_port.loopback = on;
+}
+
+int
+sim_uart_tx_take(uint8_t *data, int len)
+{
+    struct uart_dma *pu = &sim_uart_port;
+    int cnt = 0;
+
+    while (cnt < len && pu->tx_tail != pu->tx_head) {
+        data[cnt++] = pu->tx_buf[pu->tx_tail];
+        pu->tx_tail = (pu->tx_tail + 1) & SIM_UART_TX_MASK;
+    }
+    return cnt;
+}
+
+void
+sim_uart_reset(void)
+{
+    memset(&sim_uart_port, 0, sizeof(sim_uart_port));
+}
@@ -0,0 +1,144 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ARDUINO_CODEC_H__
+#define __ARDUINO_CODEC_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 
+ * Compact binary form of a block of samples from one pin.  A short 
+ * header carries the pin and the time of the first sample, then every
+ * sample is the difference to the one before it as a zigzag varint, so
+ * a slow 10 bit signal takes one byte per sample.  The first sample is
+ * the difference to 0, every block decodes on its own.
+ *
+ * The header is the version byte, the entry id of the pin, the stamp 
+ * little endian and the period and count as varints.  Only stdint is
+ * used, arduino_codec.c builds as it is for a host.
+ *
+ * A summary of a window of values has its own first byte, then the 
+ * entry id, the stamp, the window and the count, the min as a zigzag
+ * varint and the max and mean above the min as varints.
+ *
+ * A snapshot of all pins has its own first byte, then its flags and the
+ * stamp of the gpio read.  The entry ids of the gpio pins are a mask 
+ * varint, followed by their levels, one bit per pin in entry id order.
+ * Then comes the mask of the analog pins, the usecs from the gpio read
+ * to their conversion as a zigzag varint and a varint value per pin.
+ */
+
+#define ARDUINO_CODEC_VERSION       (1)
+#define ARDUINO_CODEC_HDR_MAX       (14)
+/* a difference of two int16 samples takes at most 3 bytes */
+#define ARDUINO_CODEC_MAX_LEN(cnt)  (ARDUINO_CODEC_HDR_MAX + (cnt) * 3)
+
+#define ARDUINO_CODEC_SUMMARY       (2)
+#define ARDUINO_CODEC_SUMMARY_MAX   (31)
+
+#define ARDUINO_CODEC_SNAPSHOT      (3)
+#define ARDUINO_CODEC_SNAPSHOT_ADC  (6)
+#define ARDUINO_CODEC_SNAPSHOT_MAX  (6 + 4 * 3 + 5 + \
+                                     ARDUINO_CODEC_SNAPSHOT_ADC * 3)
+/* the analog values are from one pass of the ADC */
+#define ARDUINO_CODEC_SNAP_ONE_PASS (0x01)
+/* the adc pins are left out, another driver owned the ADC */
+#define ARDUINO_CODEC_SNAP_ADC_BUSY (0x02)
+
+struct arduino_codec_hdr
+{
+    uint8_t  entry_id;
+    uint16_t cnt;
+    uint32_t stamp;             /* bsp_usec_get32() of the first sample */
+    uint32_t period;            /* usecs from one sample to the next, 0 if
+                                 * they are not evenly spaced */
+};
+
+struct arduino_codec_summary
+{
+    uint8_t  entry_id;
+    uint32_t stamp;             /* bsp_usec_get32() of the first value */
+    uint32_t window;            /* ms */
+    uint32_t cnt;
+    int32_t  min;
+    int32_t  max;
+    int32_t  mean;
+};
+
+struct arduino_codec_snapshot
+{
+    uint8_t  flags;
+    uint32_t stamp;             /* bsp_usec_get32() of the gpio read */
+    uint32_t gpio_mask;         /* bit per entry id */
+    uint32_t gpio_levels;       /* bit per entry id, only those in the 
+                                 * mask */
+    uint32_t adc_mask;
+    int32_t  adc_delta;         /* usecs from stamp to the conversion */
+    uint16_t adc[ARDUINO_CODEC_SNAPSHOT_ADC];
+                                /* raw 12 bit values of the adc_mask pins
+                                 * in entry id order */
+};
+
+/* encodes hdr->cnt samples into buf, returns the length or -1 if it 
+ * does not fit in size */
+int
+arduino_codec_encode(const struct arduino_codec_hdr *hdr, 
+                     const int16_t *samples, uint8_t *buf, int size);
+
+/* reads the header of an encoded block, returns its length or -1 */
+int
+arduino_codec_decode_hdr(const uint8_t *buf, int len, 
+                         struct arduino_codec_hdr *hdr);
+
+/* decodes a block into hdr and up to max samples, returns the number of
+ * bytes used or -1 if the block is bad or has more samples */
+int
+arduino_codec_decode(const uint8_t *buf, int len, 
+                     struct arduino_codec_hdr *hdr, int16_t *samples, 
+                     int max);
+
+/* encodes a summary into buf, returns the length or -1 */
+int
+arduino_codec_encode_summary(const struct arduino_codec_summary *ps, 
+                             uint8_t *buf, int size);
+
+/* returns the length of the summary in buf or -1 if it is not one */
+int
+arduino_codec_decode_summary(const uint8_t *buf, int len, 
+                             struct arduino_codec_summary *ps);
+
+/* encodes a snapshot into buf, returns the length or -1 */
+int
+arduino_codec_encode_snapshot(const struct arduino_codec_snapshot *ps,
+                              uint8_t *buf, int size);
+
+/* returns the length of the snapshot in buf or -1 if it is not one */
+int
+arduino_codec_decode_snapshot(const uint8_t *buf, int len,
+                              struct arduino_codec_snapshot *ps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ARDUINO_CODEC_H__ */
@@ -20,8 +20,242 @@
 #ifndef __ARDUINO_TEST_H__
 #define __ARDUINO_TEST_H__
 
+#include <stdint.h>
+#include <os/os.h>
+
 /* initialize the arduino_test console library */
 int
 arduino_test_init(void);
 
+/* starts the task that runs the pin operations. Should be the highest
+ * priority of the pin clients; without it they run in the caller */
+int
+arduino_test_task_init(uint8_t prio, os_stack_t *stack, uint16_t stack_size);
+
+/* runs an "arduino" shell command, argv[0] is the command name */
+int
+arduino_test_cmd(int argc, char **argv);
+
+/* returns the entry id of the named pin (e.g. "A0") or -1 */
+int
+arduino_test_pin_lookup(const char *pinstr);
+
+/* reads the raw value of a pin and the bsp_usec_get32() time the 
+ * read was started at.  For an adc_scan pin it is the time the value
+ * was converted, so its age is bsp_usec_get32() minus it */
+int
+arduino_test_read_stamped(int entry_id, int *value, uint32_t *usecs);
+
+/* reads every gpio_in, adc and adc_scan pin at one time into one record
+ * in the snapshot form of arduino_codec.h and returns its length, or 
+ * less than 0 if a read fails or it does not fit in size.  The gpio pins
+ * come from one read of the port and the adc pins from one pass of the
+ * ADC, or none if another driver owns it.  Values are raw 12 bit counts
+ * without the filter of the pin */
+int
+arduino_test_snapshot(uint8_t *buf, int size);
+
+/* compiles one pin command, "set <pin> <function>", "write <pin> <value>",
+ * "read <pin>" or "delay <ms>", into a macro step appended after the len
+ * bytes of steps.  Returns the new length or -1 if the command is bad or
+ * does not fit in size */
+int
+arduino_test_macro_compile(int argc, char **argv, uint8_t *steps, int len,
+                           int size);
+
+/* runs compiled steps in order and stops at the first error.  Returns 0
+ * or that error, failed if not NULL gets the index of the step */
+int
+arduino_test_macro_exec(const uint8_t *steps, int len, int *failed);
+
+/* reads an adc or dac pin and returns the value in milli-volts. 
+ * Uses the scale cached when the pin was set, so no formatting 
+ * or division is done */
+int
+arduino_test_read_mv(int entry_id, int *mvolts);
+
+/* reads a pwm_duty pin and returns the duty cycle in percent */
+int
+arduino_test_read_percent(int entry_id, int *percent);
+
+/* 
+ * Streaming filter on Q15 samples, 0..32767, with no division so it is
+ * cheap on the M0+.  An adc pin runs its conversions through one, and 
+ * it can be used on the buffers of a triggered ADC.  The smoothing 
+ * filter is followed by a decimator that passes one output in decim.
+ */
+enum arduino_test_filter_kind
+{
+    ARDUINO_FILTER_NONE = 0,
+    ARDUINO_FILTER_AVG,         /* moving average, param is the length,
+                                 * a power of 2 */
+    ARDUINO_FILTER_IIR,         /* single pole, param is alpha in Q15 */
+    ARDUINO_FILTER_MEDIAN,      /* median, param is the odd length */
+    ARDUINO_FILTER_KIND_MAX,
+};
+
+#define ARDUINO_FILTER_MAX_LEN      (16)
+#define ARDUINO_FILTER_DECIM_MAX    (64)
+
+struct arduino_test_filter
+{
+    uint8_t  kind;
+    uint8_t  len;
+    uint8_t  shift;             /* log2 of len for the average */
+    uint8_t  decim;
+    uint8_t  cnt;               /* samples since the last output */
+    uint8_t  pos;               /* oldest sample of the window */
+    uint8_t  primed;
+    int16_t  alpha;
+    int32_t  acc;               /* window sum, or the iir output << 15 */
+    int16_t  win[ARDUINO_FILTER_MAX_LEN];
+    int16_t  sorted[ARDUINO_FILTER_MAX_LEN];
+};
+
+/* sets up a filter, returns -1 if the parameters are not valid */
+int
+arduino_test_filter_init(struct arduino_test_filter *pf, int kind, 
+                         int param, int decim);
+
+/* filters cnt samples from in, returns the number of outputs written to
+ * out, which may be in */
+int
+arduino_test_filter_run(struct arduino_test_filter *pf, const int16_t *in,
+                        int cnt, int16_t *out);
+
+/* returns the amplitude of the freq component of cnt samples taken at 
+ * rate, in the units of the samples, or -1.  cnt is a power of 2 and the
+ * samples should have their mean removed */
+int32_t
+arduino_test_goertzel(const int16_t *samples, int cnt, uint32_t freq, 
+                      uint32_t rate);
+
+/* 
+ * Append-only circular log of records written straight to a flash area,
+ * for data that comes too fast for NFFS.  Records are collected in RAM
+ * and programmed a flash page at a time, each carries a CRC.  When the
+ * area is full the block with the oldest records is erased.  Not for
+ * interrupt context.
+ */
+struct arduino_test_log_info
+{
+    uint32_t size;              /* bytes of flash */
+    uint32_t used;              /* bytes holding records */
+    uint32_t block_size;        /* the unit that is erased */
+    uint32_t erases;            /* blocks erased since the open */
+    uint32_t bad;               /* records that failed the CRC on the
+                                 * last walk */
+    uint32_t scan_usecs;        /* the recovery scan of the open */
+};
+
+/* opens the log in a flash area and finds its end, the BSP log area is
+ * opened by arduino_test_init() */
+int
+arduino_test_log_open(int flash_area_id);
+
+/* appends one record of len bytes, it is in flash after the page fills
+ * or arduino_test_log_flush() */
+int
+arduino_test_log_append(const void *data, int len);
+
+int
+arduino_test_log_flush(void);
+
+/* erases the whole log */
+int
+arduino_test_log_erase(void);
+
+/* calls cb with every record that passes its CRC, oldest first, until cb
+ * returns non-zero.  A record is read into buf, longer ones are skipped */
+int
+arduino_test_log_walk(int (*cb)(void *arg, const void *data, int len),
+                      void *arg, void *buf, int size);
+
+int
+arduino_test_log_info(struct arduino_test_log_info *info);
+
+/* 
+ * Windowed summaries of pin values.  A pin is read every period_ms and
+ * only the count, min, max and sum of the window are kept.  At the end 
+ * of each window one summary record, in the form of arduino_codec.h, is
+ * appended to the sample log.  The reads are made by a task started 
+ * with arduino_test_agg_task_init(), below the priority of the shell.
+ * Up to 8 pins, the setup is not saved.
+ */
+int
+arduino_test_agg_task_init(uint8_t prio, os_stack_t *stack, 
+                           uint16_t stack_size);
+
+/* starts or restarts the summaries of a pin, window_ms is at most a day */
+int
+arduino_test_agg_add(int entry_id, uint32_t period_ms, uint32_t window_ms);
+
+/* stops them, the part of the window so far is logged */
+int
+arduino_test_agg_remove(int entry_id);
+
+/* makes len bytes at buf, for example the buffer of a triggered ADC, 
+ * readable through the newtmgr export, NULL removes them.  They are 
+ * read as they are, stop the capture first for a consistent copy.  
+ * arduino spectrum puts its last block here, a later call replaces it */
+void
+arduino_test_export_ram(const void *buf, uint32_t len);
+
+/* something a pin reported on its own */
+enum arduino_test_event_kind
+{
+    ARDUINO_EVENT_WINDOW_OUT = 0,   /* adc_window value left the band */
+    ARDUINO_EVENT_WINDOW_IN,        /* and came back */
+    ARDUINO_EVENT_AC_RISE,          /* ac input went above the reference */
+    ARDUINO_EVENT_AC_FALL,          /* and below it */
+    ARDUINO_EVENT_UART_IDLE,        /* uart line went quiet, the value is
+                                     * the number of bytes waiting */
+};
+
+struct arduino_test_event
+{
+    uint8_t  entry_id;
+    uint8_t  kind;
+    int      value;
+    uint32_t usecs;                 /* bsp_usec_get32() when posted */
+};
+
+/* the type of the os_event posted to the notify queue */
+#define ARDUINO_TEST_EVENT_T    (OS_EVENT_T_PERUSER + 1)
+
+/* takes the oldest event, returns -1 if there is none */
+int
+arduino_test_event_get(struct arduino_test_event *ev);
+
+/* returns the number of events lost because nobody took them */
+uint32_t
+arduino_test_event_drops(void);
+
+/* posts an ARDUINO_TEST_EVENT_T os_event to evq when events arrive */
+void
+arduino_test_event_notify(struct os_eventq *evq);
+
+/* where the time of a command goes, see arduino_test_prof_usecs() */
+enum arduino_test_phase
+{
+    ARDUINO_PHASE_OTHER = 0,
+    ARDUINO_PHASE_PARSE,
+    ARDUINO_PHASE_LOOKUP,
+    ARDUINO_PHASE_LOCK,
+    ARDUINO_PHASE_HAL,
+    ARDUINO_PHASE_FORMAT,
+    ARDUINO_PHASE_CONSOLE,
+    ARDUINO_PHASE_MAX,
+};
+
+#ifdef ARDUINO_TEST_PROFILE
+/* clears the time accumulated per phase */
+void
+arduino_test_prof_reset(void);
+
+/* returns the time spent in a phase since the last reset */
+uint32_t
+arduino_test_prof_usecs(int phase);
+#endif
+
 #endif /* __ARDUINO_TEST_H__ */
\ No newline at end of file
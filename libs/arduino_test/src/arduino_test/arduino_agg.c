@@ -0,0 +1,372 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <console/console.h>
+#include <arduino_test/arduino_codec.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Windowed summaries of pin values.  Each configured pin is read every
+ * period, and only the count, min, max and sum of the current window are
+ * kept, so the memory does not grow with the window.  When a window ends
+ * one summary record goes to the sample log, in the form of 
+ * arduino_codec.h, and the next window starts.  A minute of a pin read 
+ * every 100 ms is 600 values and one record of about 17 bytes.
+ *
+ * The reads run on a low priority task of this library, between them it
+ * sleeps until the next read or window end is due.  The reads themselves
+ * still go to the I/O task, so they are serialized with the shell.
+ */
+
+#define ARDUINO_AGG_MAX         (8)
+/* a day, so the window in ticks fits 32 bits */
+#define ARDUINO_AGG_MAX_WINDOW  (86400000UL)
+/* the longest sleep with nothing configured */
+#define ARDUINO_AGG_IDLE        (OS_TICKS_PER_SEC)
+/* the pins whose read is a value */
+#define ARDUINO_AGG_TYPES       ((1UL << INTERFACE_GPIO_OUT) | \
+                                 (1UL << INTERFACE_GPIO_IN) | \
+                                 (1UL << INTERFACE_ADC) | \
+                                 (1UL << INTERFACE_ADC_SCAN) | \
+                                 (1UL << INTERFACE_DAC) | \
+                                 (1UL << INTERFACE_PWM_DUTY) | \
+                                 (1UL << INTERFACE_PWM_FREQ) | \
+                                 (1UL << INTERFACE_AC))
+
+#define ARDUINO_AGG_DUE(now, t) ((int32_t) ((now) - (t)) >= 0)
+
+struct arduino_agg
+{
+    int8_t   entry_id;          /* -1 if the slot is free */
+    uint32_t period_ms;
+    uint32_t window_ms;
+    uint32_t period;            /* in ticks */
+    uint32_t window;
+    os_time_t next;             /* tick of the next read */
+    os_time_t end;              /* tick the window ends at */
+    uint32_t stamp;             /* of the first value in the window */
+    uint32_t cnt;
+    int32_t  min;
+    int32_t  max;
+    int64_t  sum;
+    uint32_t windows;           /* summaries logged */
+    uint32_t errors;            /* reads and appends that failed */
+};
+
+static struct arduino_agg arduino_agg[ARDUINO_AGG_MAX];
+static struct os_mutex arduino_agg_mutex;
+static struct os_task arduino_agg_task;
+/* wakes the task when a pin is added */
+static struct os_sem arduino_agg_sem;
+
+static uint32_t
+arduino_agg_ticks(uint32_t ms)
+{
+    uint32_t ticks;
+
+    ticks = ((uint64_t) ms * OS_TICKS_PER_SEC + 999) / 1000;
+    return ticks ? ticks : 1;
+}
+
+static struct arduino_agg *
+arduino_agg_find(int entry_id)
+{
+    int i;
+
+    for (i = 0; i < ARDUINO_AGG_MAX; i++) {
+        if (arduino_agg[i].entry_id == entry_id) {
+            return &arduino_agg[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+arduino_agg_clear(struct arduino_agg *pa)
+{
+    pa->cnt = 0;
+    pa->min = INT32_MAX;
+    pa->max = INT32_MIN;
+    pa->sum = 0;
+}
+
+/* logs the summary of the window of window_ms that ended and starts 
+ * the next */
+static void
+arduino_agg_emit(struct arduino_agg *pa, uint32_t window_ms)
+{
+    struct arduino_codec_summary sum;
+    uint8_t rec[ARDUINO_CODEC_SUMMARY_MAX];
+    int len;
+
+    if (pa->cnt == 0) {
+        return;
+    }
+    sum.entry_id = pa->entry_id;
+    sum.stamp = pa->stamp;
+    sum.window = window_ms;
+    sum.cnt = pa->cnt;
+    sum.min = pa->min;
+    sum.max = pa->max;
+    /* rounded, the one division of a window */
+    if (pa->sum >= 0) {
+        sum.mean = (pa->sum + pa->cnt / 2) / pa->cnt;
+    } else {
+        sum.mean = (pa->sum - pa->cnt / 2) / pa->cnt;
+    }
+    arduino_agg_clear(pa);
+
+    len = arduino_codec_encode_summary(&sum, rec, sizeof(rec));
+    /* a window is long, so it is worth a flush to survive a reset */
+    if (len < 0 || arduino_test_log_append(rec, len) || 
+        arduino_test_log_flush()) {
+        pa->errors++;
+    } else {
+        pa->windows++;
+    }
+}
+
+static void
+arduino_agg_sample(struct arduino_agg *pa)
+{
+    struct arduino_pin_req req = { 0 };
+
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_entry = pa->entry_id;
+    req.apr_type_mask = ARDUINO_AGG_TYPES;
+    if (arduino_task_call(&req)) {
+        pa->errors++;
+        return;
+    }
+    if (pa->cnt == 0) {
+        pa->stamp = req.apr_stamp;
+    }
+    pa->cnt++;
+    pa->sum += req.apr_value;
+    if (req.apr_value < pa->min) {
+        pa->min = req.apr_value;
+    }
+    if (req.apr_value > pa->max) {
+        pa->max = req.apr_value;
+    }
+}
+
+/* does the reads and window ends due at now, returns the ticks to the 
+ * next one */
+static uint32_t
+arduino_agg_poll(os_time_t now)
+{
+    struct arduino_agg *pa;
+    uint32_t wait = ARDUINO_AGG_IDLE;
+    int i;
+
+    os_mutex_pend(&arduino_agg_mutex, OS_WAIT_FOREVER);
+    for (i = 0; i < ARDUINO_AGG_MAX; i++) {
+        pa = &arduino_agg[i];
+        if (pa->entry_id < 0) {
+            continue;
+        }
+        /* the window first, a read at its end belongs to the next one */
+        if (ARDUINO_AGG_DUE(now, pa->end)) {
+            arduino_agg_emit(pa, pa->window_ms);
+            pa->end += pa->window;
+            if (ARDUINO_AGG_DUE(now, pa->end)) {
+                pa->end = now + pa->window;
+            }
+        }
+        if (ARDUINO_AGG_DUE(now, pa->next)) {
+            arduino_agg_sample(pa);
+            pa->next += pa->period;
+            /* behind, the reads missed are skipped */
+            if (ARDUINO_AGG_DUE(now, pa->next)) {
+                pa->next = now + pa->period;
+            }
+        }
+        if (pa->next - now < wait) {
+            wait = pa->next - now;
+        }
+        if (pa->end - now < wait) {
+            wait = pa->end - now;
+        }
+    }
+    os_mutex_release(&arduino_agg_mutex);
+    return wait;
+}
+
+static void
+arduino_agg_task_handler(void *arg)
+{
+    while (1) {
+        (void) os_sem_pend(&arduino_agg_sem, arduino_agg_poll(os_time_get()));
+    }
+}
+
+int
+arduino_test_agg_task_init(uint8_t prio, os_stack_t *stack, 
+                           uint16_t stack_size)
+{
+    return os_task_init(&arduino_agg_task, "agg", arduino_agg_task_handler,
+                        NULL, prio, OS_WAIT_FOREVER, stack, stack_size);
+}
+
+int
+arduino_test_agg_add(int entry_id, uint32_t period_ms, uint32_t window_ms)
+{
+    struct arduino_agg *pa;
+    int rc = 0;
+
+    if (entry_id < 0 || entry_id >= ARDUINO_NUM_DEVS || period_ms == 0 ||
+        window_ms < period_ms || window_ms > ARDUINO_AGG_MAX_WINDOW) {
+        return -1;
+    }
+    os_mutex_pend(&arduino_agg_mutex, OS_WAIT_FOREVER);
+    pa = arduino_agg_find(entry_id);
+    if (!pa) {
+        pa = arduino_agg_find(-1);
+    }
+    if (!pa) {
+        rc = -1;
+        goto out;
+    }
+    memset(pa, 0, sizeof(*pa));
+    pa->entry_id = entry_id;
+    pa->period_ms = period_ms;
+    pa->window_ms = window_ms;
+    pa->period = arduino_agg_ticks(period_ms);
+    pa->window = arduino_agg_ticks(window_ms);
+    pa->next = os_time_get();
+    pa->end = pa->next + pa->window;
+    arduino_agg_clear(pa);
+    os_sem_release(&arduino_agg_sem);
+out:
+    os_mutex_release(&arduino_agg_mutex);
+    return rc;
+}
+
+int
+arduino_test_agg_remove(int entry_id)
+{
+    struct arduino_agg *pa;
+    uint32_t elapsed;
+    int rc = -1;
+
+    os_mutex_pend(&arduino_agg_mutex, OS_WAIT_FOREVER);
+    pa = entry_id >= 0 ? arduino_agg_find(entry_id) : NULL;
+    if (pa) {
+        /* the part of the window so far is not lost */
+        elapsed = os_time_get() - (pa->end - pa->window);
+        arduino_agg_emit(pa, (uint64_t) elapsed * 1000 / OS_TICKS_PER_SEC);
+        pa->entry_id = -1;
+        rc = 0;
+    }
+    os_mutex_release(&arduino_agg_mutex);
+    return rc;
+}
+
+static void
+arduino_agg_show(void)
+{
+    struct arduino_agg *pa;
+    int shown = 0;
+    int i;
+
+    os_mutex_pend(&arduino_agg_mutex, OS_WAIT_FOREVER);
+    for (i = 0; i < ARDUINO_AGG_MAX; i++) {
+        pa = &arduino_agg[i];
+        if (pa->entry_id < 0) {
+            continue;
+        }
+        console_printf("  %s every %lu ms, windows of %lu ms, %lu logged, "
+                       "%lu errors, %lu values so far", 
+                       pin_map[pa->entry_id].name, 
+                       (unsigned long) pa->period_ms, 
+                       (unsigned long) pa->window_ms, 
+                       (unsigned long) pa->windows,
+                       (unsigned long) pa->errors, (unsigned long) pa->cnt);
+        if (pa->cnt) {
+            console_printf(", min %ld max %ld", (long) pa->min, 
+                           (long) pa->max);
+        }
+        console_printf("\n");
+        shown++;
+    }
+    os_mutex_release(&arduino_agg_mutex);
+    if (!shown) {
+        console_printf("No pins are aggregated\n");
+    }
+}
+
+int
+arduino_agg_cmd(int argc, char **argv)
+{
+    uint32_t period_ms;
+    uint32_t window_s;
+    int entry_id;
+
+    if (argc == 1) {
+        arduino_agg_show();
+        return 0;
+    }
+    if (argc < 3 || argc > 4) {
+        return -1;
+    }
+    entry_id = arduino_pinstr_to_entry(argv[1]);
+    if (entry_id < 0) {
+        return -1;
+    }
+    if (argc == 3) {
+        if (strcmp(argv[2], "off")) {
+            return -1;
+        }
+        if (arduino_test_agg_remove(entry_id)) {
+            console_printf("%s is not aggregated\n", argv[1]);
+        }
+        return 0;
+    }
+
+    period_ms = strtoul(argv[2], NULL, 0);
+    window_s = strtoul(argv[3], NULL, 0);
+    if (window_s == 0 || window_s > ARDUINO_AGG_MAX_WINDOW / 1000) {
+        return -1;
+    }
+    if (arduino_test_agg_add(entry_id, period_ms, window_s * 1000)) {
+        console_printf("Unable to aggregate %s, %d pins at most\n", argv[1],
+                       ARDUINO_AGG_MAX);
+    }
+    return 0;
+}
+
+int
+arduino_agg_init(void)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < ARDUINO_AGG_MAX; i++) {
+        arduino_agg[i].entry_id = -1;
+    }
+    rc = os_sem_init(&arduino_agg_sem, 0);
+    if (rc) {
+        return rc;
+    }
+    return os_mutex_init(&arduino_agg_mutex);
+}
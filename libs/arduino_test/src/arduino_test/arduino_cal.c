@@ -0,0 +1,173 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <console/console.h>
+#include <bsp/adc_cal.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Two point calibration of the ADC.  A known voltage is put on an adc
+ * pin and measured with the correction off, then a second one, and the
+ * gain and offset that map the two readings onto the ideal counts are
+ * programmed into the ADC.  From then on every conversion is corrected
+ * by the hardware, the cached mV scale of the pins stays as it is.
+ */
+
+/* raw conversions averaged for one point */
+#define ARDUINO_CAL_SAMPLES         (16)
+#define ARDUINO_CAL_SAMPLES_SHIFT   (4)
+/* the correction works on counts of this many bits */
+#define ARDUINO_CAL_BITS            (12)
+
+static int16_t arduino_cal_buf[ARDUINO_CAL_SAMPLES];
+
+/* the first point, waiting for the second */
+static int arduino_cal_have_point;
+static int arduino_cal_raw;
+static int arduino_cal_want;
+
+static void
+arduino_cal_show(void)
+{
+    struct adc_cal cal;
+    int linearity;
+    int bias;
+
+    adc_cal_factory(&linearity, &bias);
+    adc_cal_get(&cal);
+    console_printf("ADC factory linearity %d bias %d, ", linearity, bias);
+    if (cal.offset == 0 && cal.gain == ADC_CAL_GAIN_ONE) {
+        console_printf("no correction\n");
+    } else {
+        console_printf("correction offset %d gain %u/%d\n", cal.offset, 
+                       cal.gain, ADC_CAL_GAIN_ONE);
+    }
+}
+
+/* measures one point with the correction off, in 12 bit counts */
+static int
+arduino_cal_measure(int entry_id, int mvolts, int *raw, int *want)
+{
+    struct arduino_pin_req req = { 0 };
+    struct adc_cal cal;
+    interfaces_t pin;
+    int32_t sum = 0;
+    int bits;
+    int rc;
+    int i;
+
+    adc_cal_get(&cal);
+    rc = adc_cal_set(NULL);
+    if (rc) {
+        return rc;
+    }
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_entry = entry_id;
+    req.apr_arg = ARDUINO_CAL_SAMPLES;
+    req.apr_value = 0;
+    req.apr_buf = arduino_cal_buf;
+    req.apr_type_mask = 1UL << INTERFACE_ADC;
+    req.apr_snap = &pin;
+    rc = arduino_task_call(&req);
+    (void) adc_cal_set(&cal);
+    if (rc) {
+        return rc;
+    }
+
+    /* the cached scale of the pin is its reference and resolution */
+    bits = pin.shift;
+    if (pin.scale == 0 || bits > ARDUINO_CAL_BITS) {
+        return -1;
+    }
+    for (i = 0; i < ARDUINO_CAL_SAMPLES; i++) {
+        sum += arduino_cal_buf[i];
+    }
+    sum <<= ARDUINO_CAL_BITS - bits;
+    *raw = (sum + (1 << (ARDUINO_CAL_SAMPLES_SHIFT - 1))) >> 
+           ARDUINO_CAL_SAMPLES_SHIFT;
+    *want = (((int32_t) mvolts << ARDUINO_CAL_BITS) + pin.scale / 2) / 
+            pin.scale;
+    return 0;
+}
+
+int
+arduino_cal_cmd(int argc, char **argv)
+{
+    struct adc_cal cal;
+    int entry_id;
+    int mvolts;
+    int raw;
+    int want;
+    int rc;
+
+    /* cal, cal off, cal <pin> <mV> */
+    if (argc == 1) {
+        arduino_cal_show();
+        return 0;
+    }
+    if (argc == 2 && !strcmp(argv[1], "off")) {
+        arduino_cal_have_point = 0;
+        rc = adc_cal_set(NULL);
+        if (rc) {
+            console_printf("Unable to clear the ADC correction, err=%d\n", 
+                           rc);
+        } else {
+            console_printf("Cleared the ADC correction\n");
+        }
+        return 0;
+    }
+    if (argc != 3) {
+        return -1;
+    }
+    entry_id = arduino_pinstr_to_entry(argv[1]);
+    mvolts = atoi(argv[2]);
+    if (entry_id < 0 || mvolts < 0 || mvolts > UINT16_MAX) {
+        return -1;
+    }
+
+    rc = arduino_cal_measure(entry_id, mvolts, &raw, &want);
+    if (rc) {
+        console_printf("Unable to measure %s, err=%d\n", argv[1], rc);
+        return 0;
+    }
+    console_printf("%s at %d mV reads %d, ideal %d\n", argv[1], mvolts, 
+                   raw, want);
+    if (!arduino_cal_have_point) {
+        arduino_cal_raw = raw;
+        arduino_cal_want = want;
+        arduino_cal_have_point = 1;
+        console_printf("Now measure a second voltage\n");
+        return 0;
+    }
+
+    arduino_cal_have_point = 0;
+    rc = adc_cal_from_points(arduino_cal_raw, arduino_cal_want, raw, want, 
+                             &cal);
+    if (!rc) {
+        rc = adc_cal_set(&cal);
+    }
+    if (rc) {
+        console_printf("Unable to calibrate the ADC, err=%d\n", rc);
+    } else {
+        arduino_cal_show();
+    }
+    return 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdint.h>
+#include <arduino_test/arduino_codec.h>
+
+/* small differences of either sign become small unsigned numbers */
+#define ARDUINO_ZIGZAG(v)       (((uint32_t) (v) << 1) ^ \
+                                 (uint32_t) ((int32_t) (v) >> 31))
+#define ARDUINO_UNZIGZAG(v)     ((int32_t) ((v) >> 1) ^ -(int32_t) ((v) & 1))
+
+/* 7 bits per byte, the top bit says another byte follows */
+static int
+arduino_codec_put(uint8_t *buf, int pos, int size, uint32_t value)
+{
+    while (value > 0x7f) {
+        if (pos >= size) {
+            return -1;
+        }
+        buf[pos++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    if (pos >= size) {
+        return -1;
+    }
+    buf[pos++] = value;
+    return pos;
+}
+
+static int
+arduino_codec_get(const uint8_t *buf, int pos, int len, uint32_t *value)
+{
+    uint32_t v = 0;
+    int shift = 0;
+    uint8_t b;
+
+    do {
+        if (pos >= len || shift > 28) {
+            return -1;
+        }
+        b = buf[pos++];
+        v |= (uint32_t) (b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    *value = v;
+    return pos;
+}
+
+/* the 6 bytes every form starts with */
+static void
+arduino_codec_put_stamp(uint8_t *buf, uint8_t kind, uint8_t entry_id, 
+                        uint32_t stamp)
+{
+    buf[0] = kind;
+    buf[1] = entry_id;
+    buf[2] = stamp;
+    buf[3] = stamp >> 8;
+    buf[4] = stamp >> 16;
+    buf[5] = stamp >> 24;
+}
+
+int
+arduino_codec_encode(const struct arduino_codec_hdr *hdr, 
+                     const int16_t *samples, uint8_t *buf, int size)
+{
+    int32_t prev = 0;
+    int pos = 6;
+    int i;
+
+    if (size < pos) {
+        return -1;
+    }
+    arduino_codec_put_stamp(buf, ARDUINO_CODEC_VERSION, hdr->entry_id, 
+                            hdr->stamp);
+    pos = arduino_codec_put(buf, pos, size, hdr->period);
+    if (pos >= 0) {
+        pos = arduino_codec_put(buf, pos, size, hdr->cnt);
+    }
+    for (i = 0; i < hdr->cnt && pos >= 0; i++) {
+        pos = arduino_codec_put(buf, pos, size, 
+                                ARDUINO_ZIGZAG(samples[i] - prev));
+        prev = samples[i];
+    }
+    return pos;
+}
+
+int
+arduino_codec_decode_hdr(const uint8_t *buf, int len, 
+                         struct arduino_codec_hdr *hdr)
+{
+    uint32_t cnt;
+    int pos;
+
+    if (len < 6 || buf[0] != ARDUINO_CODEC_VERSION) {
+        return -1;
+    }
+    hdr->entry_id = buf[1];
+    hdr->stamp = buf[2] | ((uint32_t) buf[3] << 8) | 
+                 ((uint32_t) buf[4] << 16) | ((uint32_t) buf[5] << 24);
+    pos = arduino_codec_get(buf, 6, len, &hdr->period);
+    if (pos >= 0) {
+        pos = arduino_codec_get(buf, pos, len, &cnt);
+    }
+    if (pos < 0 || cnt > UINT16_MAX) {
+        return -1;
+    }
+    hdr->cnt = cnt;
+    return pos;
+}
+
+int
+arduino_codec_decode(const uint8_t *buf, int len, 
+                     struct arduino_codec_hdr *hdr, int16_t *samples, 
+                     int max)
+{
+    uint32_t value;
+    int32_t prev = 0;
+    int pos;
+    int i;
+
+    pos = arduino_codec_decode_hdr(buf, len, hdr);
+    if (pos < 0 || hdr->cnt > max) {
+        return -1;
+    }
+    for (i = 0; i < hdr->cnt; i++) {
+        pos = arduino_codec_get(buf, pos, len, &value);
+        if (pos < 0) {
+            return -1;
+        }
+        prev += ARDUINO_UNZIGZAG(value);
+        samples[i] = prev;
+    }
+    return pos;
+}
+
+int
+arduino_codec_encode_summary(const struct arduino_codec_summary *ps, 
+                             uint8_t *buf, int size)
+{
+    int pos = 6;
+
+    if (size < pos || ps->max < ps->min || ps->mean < ps->min || 
+        ps->mean > ps->max) {
+        return -1;
+    }
+    arduino_codec_put_stamp(buf, ARDUINO_CODEC_SUMMARY, ps->entry_id, 
+                            ps->stamp);
+    pos = arduino_codec_put(buf, pos, size, ps->window);
+    if (pos >= 0) {
+        pos = arduino_codec_put(buf, pos, size, ps->cnt);
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_put(buf, pos, size, ARDUINO_ZIGZAG(ps->min));
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_put(buf, pos, size, 
+                                (uint32_t) ps->max - (uint32_t) ps->min);
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_put(buf, pos, size, 
+                                (uint32_t) ps->mean - (uint32_t) ps->min);
+    }
+    return pos;
+}
+
+int
+arduino_codec_decode_summary(const uint8_t *buf, int len, 
+                             struct arduino_codec_summary *ps)
+{
+    uint32_t value;
+    int pos;
+
+    if (len < 6 || buf[0] != ARDUINO_CODEC_SUMMARY) {
+        return -1;
+    }
+    ps->entry_id = buf[1];
+    ps->stamp = buf[2] | ((uint32_t) buf[3] << 8) | 
+                ((uint32_t) buf[4] << 16) | ((uint32_t) buf[5] << 24);
+    pos = arduino_codec_get(buf, 6, len, &ps->window);
+    if (pos >= 0) {
+        pos = arduino_codec_get(buf, pos, len, &ps->cnt);
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_get(buf, pos, len, &value);
+        if (pos >= 0) {
+            ps->min = ARDUINO_UNZIGZAG(value);
+        }
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_get(buf, pos, len, &value);
+        if (pos >= 0) {
+            ps->max = ps->min + value;
+        }
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_get(buf, pos, len, &value);
+        if (pos >= 0) {
+            ps->mean = ps->min + value;
+        }
+    }
+    return pos;
+}
+
+/* returns the number of bits set, at most the 32 of an entry mask */
+static int
+arduino_codec_bits(uint32_t mask)
+{
+    int cnt = 0;
+
+    while (mask) {
+        mask &= mask - 1;
+        cnt++;
+    }
+    return cnt;
+}
+
+/* the levels are packed to one bit per pin of the mask */
+int
+arduino_codec_encode_snapshot(const struct arduino_codec_snapshot *ps,
+                              uint8_t *buf, int size)
+{
+    uint32_t levels = 0;
+    uint32_t bit;
+    int cnt = 0;
+    int pos = 6;
+    int i;
+
+    if (size < pos || 
+        arduino_codec_bits(ps->adc_mask) > ARDUINO_CODEC_SNAPSHOT_ADC) {
+        return -1;
+    }
+    for (bit = 1; bit; bit <<= 1) {
+        if (ps->gpio_mask & bit) {
+            if (ps->gpio_levels & bit) {
+                levels |= 1UL << cnt;
+            }
+            cnt++;
+        }
+    }
+    arduino_codec_put_stamp(buf, ARDUINO_CODEC_SNAPSHOT, ps->flags, 
+                            ps->stamp);
+    pos = arduino_codec_put(buf, pos, size, ps->gpio_mask);
+    if (pos >= 0 && ps->gpio_mask) {
+        pos = arduino_codec_put(buf, pos, size, levels);
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_put(buf, pos, size, ps->adc_mask);
+    }
+    if (pos >= 0 && ps->adc_mask) {
+        pos = arduino_codec_put(buf, pos, size, 
+                                ARDUINO_ZIGZAG(ps->adc_delta));
+    }
+    cnt = arduino_codec_bits(ps->adc_mask);
+    for (i = 0; i < cnt && pos >= 0; i++) {
+        pos = arduino_codec_put(buf, pos, size, ps->adc[i]);
+    }
+    return pos;
+}
+
+int
+arduino_codec_decode_snapshot(const uint8_t *buf, int len,
+                              struct arduino_codec_snapshot *ps)
+{
+    uint32_t levels = 0;
+    uint32_t value;
+    uint32_t bit;
+    int cnt = 0;
+    int pos;
+    int i;
+
+    if (len < 6 || buf[0] != ARDUINO_CODEC_SNAPSHOT) {
+        return -1;
+    }
+    ps->flags = buf[1];
+    ps->stamp = buf[2] | ((uint32_t) buf[3] << 8) | 
+                ((uint32_t) buf[4] << 16) | ((uint32_t) buf[5] << 24);
+    ps->gpio_levels = 0;
+    ps->adc_delta = 0;
+    pos = arduino_codec_get(buf, 6, len, &ps->gpio_mask);
+    if (pos >= 0 && ps->gpio_mask) {
+        pos = arduino_codec_get(buf, pos, len, &levels);
+    }
+    if (pos >= 0) {
+        pos = arduino_codec_get(buf, pos, len, &ps->adc_mask);
+    }
+    if (pos < 0 || 
+        arduino_codec_bits(ps->adc_mask) > ARDUINO_CODEC_SNAPSHOT_ADC) {
+        return -1;
+    }
+    for (bit = 1; bit; bit <<= 1) {
+        if (ps->gpio_mask & bit) {
+            if (levels & (1UL << cnt)) {
+                ps->gpio_levels |= bit;
+            }
+            cnt++;
+        }
+    }
+    if (ps->adc_mask) {
+        pos = arduino_codec_get(buf, pos, len, &value);
+        if (pos >= 0) {
+            ps->adc_delta = ARDUINO_UNZIGZAG(value);
+        }
+    }
+    cnt = arduino_codec_bits(ps->adc_mask);
+    for (i = 0; i < cnt && pos >= 0; i++) {
+        pos = arduino_codec_get(buf, pos, len, &value);
+        if (pos >= 0) {
+            ps->adc[i] = value;
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,385 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <config/config.h>
+#include <bsp/adc_cal.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * The pin setup is kept in sys/config as one entry per configured pin,
+ * e.g. "arduino/A0=adc" or "arduino/D8=pwm_duty:32768".  Values from the
+ * config are collected by the set handler and applied to the hardware
+ * in one pass by commit, both at boot and from the config shell command.
+ * 
+ * Changing a pin does not write flash.  "arduino save" stores only the
+ * pins that differ from what is already in flash, so a burst of 
+ * reconfiguration costs a single save with a few lines.
+ *
+ * The ADC correction is kept next to the pins as "arduino/cal=<offset>:
+ * <gain>", the register values of bsp/adc_cal.h.
+ */
+
+/* what is stored in flash right now */
+static struct arduino_conf_pin arduino_conf_saved[ARDUINO_NUM_DEVS];
+/* what the last persist export handed out, it only counts as saved once
+ * conf_save() has written it */
+static struct arduino_conf_pin arduino_conf_staged[ARDUINO_NUM_DEVS];
+
+/* what the config asked for, applied by commit */
+static struct arduino_conf_pin arduino_conf_want[ARDUINO_NUM_DEVS];
+static uint32_t arduino_conf_pending;
+static int arduino_conf_loading;
+
+static struct adc_cal arduino_conf_cal_saved = { 0, ADC_CAL_GAIN_ONE };
+static struct adc_cal arduino_conf_cal_staged;
+static struct adc_cal arduino_conf_cal_want;
+static int arduino_conf_cal_pending;
+
+static char *arduino_conf_get(int argc, char **argv, char *val, 
+                              int val_len_max);
+static int arduino_conf_set(int argc, char **argv, char *val);
+static int arduino_conf_commit(void);
+static int arduino_conf_export(void (*func)(char *name, char *val),
+                               enum conf_export_tgt tgt);
+
+static struct conf_handler arduino_conf_handler = 
+{
+    .ch_name = "arduino",
+    .ch_get = arduino_conf_get,
+    .ch_set = arduino_conf_set,
+    .ch_commit = arduino_conf_commit,
+    .ch_export = arduino_conf_export,
+};
+
+/* only output values and settings like the filter of an adc make sense
+ * to restore, replaying the value of an input or a bus transfer would 
+ * have side effects */
+int
+arduino_conf_has_value(int type)
+{
+    switch (type) {
+        case INTERFACE_GPIO_OUT:
+        case INTERFACE_ADC:
+        case INTERFACE_DAC:
+        case INTERFACE_PWM_DUTY:
+        case INTERFACE_PWM_FREQ:
+        case INTERFACE_ADC_WINDOW:
+        case INTERFACE_AC:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void
+arduino_conf_current(int entry_id, struct arduino_conf_pin *pcp)
+{
+    interfaces_t *pint = &interface_map[entry_id];
+
+    pcp->type = pint->type;
+    pcp->value = arduino_conf_has_value(pint->type) ? pint->value : 0;
+}
+
+/* formats a pin as "<function>[:<value>]", the value of an adc_window
+ * is its band "<lower>:<upper>" */
+static char *
+arduino_conf_fmt(const struct arduino_conf_pin *pcp, char *buf, int len)
+{
+    const char *name = interface_info[pcp->type].name;
+    int cnt = strlen(name);
+
+    /* function name, a colon and an int or a band */
+    if (len < cnt + 13) {
+        return NULL;
+    }
+    memcpy(buf, name, cnt);
+    buf[cnt] = '\0';
+    if (arduino_conf_has_value(pcp->type)) {
+        buf[cnt++] = ':';
+        arduino_fmt_value(&buf[cnt], pcp->type, pcp->value);
+    }
+    return buf;
+}
+
+static char *
+arduino_conf_fmt_cal(const struct adc_cal *cal, char *buf, int len)
+{
+    int cnt;
+
+    /* two ints and a colon */
+    if (len < 24) {
+        return NULL;
+    }
+    cnt = arduino_fmt_int(buf, cal->offset);
+    buf[cnt++] = ':';
+    arduino_fmt_uint(&buf[cnt], cal->gain);
+    return buf;
+}
+
+static int
+arduino_conf_parse_cal(const char *str, struct adc_cal *cal)
+{
+    char *end;
+    long offset;
+    unsigned long gain;
+
+    offset = strtol(str, &end, 0);
+    if (end == str || *end != ':') {
+        return -1;
+    }
+    str = end + 1;
+    gain = strtoul(str, &end, 0);
+    if (end == str || *end != '\0' || 
+        offset < ADC_CAL_OFFSET_MIN || offset > ADC_CAL_OFFSET_MAX ||
+        gain < ADC_CAL_GAIN_MIN || gain > ADC_CAL_GAIN_MAX) {
+        return -1;
+    }
+    cal->offset = offset;
+    cal->gain = gain;
+    return 0;
+}
+
+static int
+arduino_conf_cal_changed(const struct adc_cal *cal)
+{
+    return cal->offset != arduino_conf_cal_saved.offset ||
+           cal->gain != arduino_conf_cal_saved.gain;
+}
+
+static char *
+arduino_conf_get(int argc, char **argv, char *val, int val_len_max)
+{
+    struct arduino_conf_pin cp;
+    int entry_id;
+
+    if (argc != 1) {
+        return NULL;
+    }
+    if (!strcmp(argv[0], "cal")) {
+        struct adc_cal cal;
+
+        adc_cal_get(&cal);
+        return arduino_conf_fmt_cal(&cal, val, val_len_max);
+    }
+    entry_id = arduino_pinstr_to_entry(argv[0]);
+    if (entry_id < 0) {
+        return NULL;
+    }
+    arduino_conf_current(entry_id, &cp);
+    return arduino_conf_fmt(&cp, val, val_len_max);
+}
+
+static int
+arduino_conf_set(int argc, char **argv, char *val)
+{
+    struct arduino_conf_pin *pcp;
+    char *colon;
+    int entry_id;
+    int type;
+
+    if (argc != 1) {
+        return OS_ENOENT;
+    }
+    if (!strcmp(argv[0], "cal")) {
+        if (!val) {
+            arduino_conf_cal_want.offset = 0;
+            arduino_conf_cal_want.gain = ADC_CAL_GAIN_ONE;
+        } else if (arduino_conf_parse_cal(val, &arduino_conf_cal_want)) {
+            return OS_EINVAL;
+        }
+        arduino_conf_cal_pending = 1;
+        return 0;
+    }
+    entry_id = arduino_pinstr_to_entry(argv[0]);
+    if (entry_id < 0) {
+        return OS_ENOENT;
+    }
+    pcp = &arduino_conf_want[entry_id];
+    if (!val) {
+        val = "none";
+    }
+
+    colon = strchr(val, ':');
+    if (colon) {
+        *colon = '\0';
+    }
+    type = arduino_devstr_to_dev(val);
+    if (type < 0) {
+        return OS_EINVAL;
+    }
+    pcp->type = type;
+    pcp->value = 0;
+    if (colon && arduino_conf_has_value(type)) {
+        if (arduino_parse_value(type, colon + 1, &pcp->value)) {
+            return OS_EINVAL;
+        }
+    }
+    arduino_conf_pending |= (1UL << entry_id);
+    return 0;
+}
+
+static int
+arduino_conf_commit(void)
+{
+    struct arduino_conf_pin *pcp;
+    interfaces_t *pint;
+    int entry_id;
+    int rc = 0;
+    int err;
+
+    /* before the pins, so adc pins come up corrected */
+    if (arduino_conf_cal_pending) {
+        rc = adc_cal_set(&arduino_conf_cal_want);
+        if (arduino_conf_loading) {
+            arduino_conf_cal_saved = arduino_conf_cal_want;
+        }
+        arduino_conf_cal_pending = 0;
+    }
+
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        if (!(arduino_conf_pending & (1UL << entry_id))) {
+            continue;
+        }
+        pcp = &arduino_conf_want[entry_id];
+        pint = &interface_map[entry_id];
+        err = 0;
+
+        if (pcp->type != pint->type) {
+            if (pint->type != INTERFACE_UNINITIALIZED) {
+                err = arduino_set_device(entry_id, INTERFACE_UNINITIALIZED);
+            }
+            if (!err && pcp->type != INTERFACE_UNINITIALIZED) {
+                err = arduino_set_device(entry_id, pcp->type);
+            }
+        }
+        if (!err && arduino_conf_has_value(pcp->type) && 
+            pcp->value != pint->value) {
+            err = arduino_write(entry_id, pcp->value);
+        }
+
+        /* whatever was loaded from flash is what is saved there */
+        if (arduino_conf_loading) {
+            arduino_conf_saved[entry_id] = *pcp;
+        }
+        if (err) {
+            rc = err;
+        }
+    }
+    arduino_conf_pending = 0;
+    return rc;
+}
+
+static int
+arduino_conf_export(void (*func)(char *name, char *val),
+                    enum conf_export_tgt tgt)
+{
+    struct arduino_conf_pin cp;
+    struct arduino_conf_pin *psaved;
+    struct adc_cal cal;
+    char name[16];
+    char val[24];
+    int entry_id;
+
+    adc_cal_get(&cal);
+    if (tgt == CONF_EXPORT_PERSIST) {
+        arduino_conf_cal_staged = cal;
+        if (arduino_conf_cal_changed(&cal)) {
+            func("arduino/cal", arduino_conf_fmt_cal(&cal, val, sizeof(val)));
+        }
+    } else if (cal.offset != 0 || cal.gain != ADC_CAL_GAIN_ONE) {
+        func("arduino/cal", arduino_conf_fmt_cal(&cal, val, sizeof(val)));
+    }
+
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        arduino_conf_current(entry_id, &cp);
+        psaved = &arduino_conf_saved[entry_id];
+
+        if (tgt == CONF_EXPORT_PERSIST) {
+            arduino_conf_staged[entry_id] = cp;
+            /* only write the pins that changed since they were saved */
+            if (cp.type == psaved->type && cp.value == psaved->value) {
+                continue;
+            }
+        } else if (cp.type == INTERFACE_UNINITIALIZED) {
+            continue;
+        }
+
+        strcpy(name, "arduino/");
+        strcat(name, pin_map[entry_id].name);
+        func(name, arduino_conf_fmt(&cp, val, sizeof(val)));
+    }
+    return 0;
+}
+
+/* writes the changed pins, they only count as saved if that worked */
+static int
+arduino_conf_write(void)
+{
+    int rc;
+
+    rc = conf_save();
+    if (rc) {
+        return rc;
+    }
+    memcpy(arduino_conf_saved, arduino_conf_staged, 
+           sizeof(arduino_conf_saved));
+    arduino_conf_cal_saved = arduino_conf_cal_staged;
+    return 0;
+}
+
+int
+arduino_conf_save(void)
+{
+    struct arduino_conf_pin cp;
+    struct adc_cal cal;
+    int entry_id;
+
+    adc_cal_get(&cal);
+    if (arduino_conf_cal_changed(&cal)) {
+        return arduino_conf_write();
+    }
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        arduino_conf_current(entry_id, &cp);
+        if (cp.type != arduino_conf_saved[entry_id].type ||
+            cp.value != arduino_conf_saved[entry_id].value) {
+            return arduino_conf_write();
+        }
+    }
+    /* nothing changed, leave the flash alone */
+    return 0;
+}
+
+int
+arduino_conf_init(void)
+{
+    int rc;
+
+    rc = conf_register(&arduino_conf_handler);
+    if (rc) {
+        return rc;
+    }
+
+    arduino_conf_loading = 1;
+    rc = conf_load();
+    arduino_conf_loading = 0;
+    return rc;
+}
@@ -0,0 +1,448 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <console/console.h>
+#include <hal/hal_dac.h>
+#include <hal/hal_pwm.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_tick.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Closed control loop from an adc pin to a dac or pwm_duty pin, run by
+ * the timer interrupt of bsp/adc_tick.h.  Every tick takes one 
+ * conversion of the input, runs a PID on it in Q15 and writes the 
+ * output, so the loop runs at kHz rates without the shell or the I/O
+ * task.  The error and output are Q15, the gains Q15 with 1.0 as 32768,
+ * the products 64 bit.  ki per tick keeps ARDUINO_CTL_KI_SHIFT more 
+ * bits, so a small ki at a high rate does not round to 0.  The 
+ * derivative is taken on the input, so a new setpoint does not kick the
+ * output, and the integral stops while the output is at a limit.
+ *
+ * Each tick notes how late it ran against the clock and how long the 
+ * loop took, for the jitter and the CPU share.  While the loop runs it 
+ * owns both pins: they cannot be set or written and a read of the input
+ * returns the value of the last tick.
+ */
+
+#define ARDUINO_CTL_MAX_RATE    (1000000 / ADC_TICK_MIN_PERIOD)
+#define ARDUINO_CTL_Q15_ONE     (32768)
+#define ARDUINO_CTL_Q15_MAX     (32767)
+/* a gain on the shell is below this */
+#define ARDUINO_CTL_GAIN_MAX    (65536)
+/* the extra fraction bits of ki per tick and of the integral, and the
+ * bound on ki per tick that keeps its products with a Q15 error and 
+ * their sum in 64 bits */
+#define ARDUINO_CTL_KI_SHIFT    (16)
+#define ARDUINO_CTL_KI_MAX      ((int64_t) 1 << 46)
+
+struct arduino_ctl
+{
+    volatile uint8_t running;
+    uint8_t  primed;            /* prev_in holds a value */
+    uint8_t  in;                /* entry ids */
+    uint8_t  out;
+    uint8_t  out_type;
+    uint8_t  in_shift;          /* input counts to Q15 */
+    int8_t   out_shift;         /* Q15 to output counts, < 0 is up */
+    volatile int32_t sp;        /* setpoint in input counts */
+    int32_t  kp;                /* Q15, ki and kd per tick */
+    int64_t  ki;                /* Q31 */
+    int32_t  kd;
+    int64_t  integ;             /* Q46 */
+    int32_t  prev_in;
+    uint32_t rate;
+
+    /* written by the interrupt */
+    volatile int32_t last_in;
+    volatile uint32_t last_stamp;
+    uint32_t start;
+    uint32_t ticks;
+    uint32_t lat_min;           /* usecs from the due time to the loop */
+    uint32_t lat_max;
+    uint64_t lat_sum;
+    uint32_t busy_max;          /* usecs in the loop */
+    uint64_t busy_sum;
+};
+
+static struct arduino_ctl arduino_ctl;
+static struct os_mutex arduino_ctl_mutex;
+
+static void
+arduino_ctl_tick(void *arg, int value, uint32_t due)
+{
+    struct arduino_ctl *pc = &arduino_ctl;
+    interfaces_t *pout = &interface_map[pc->out];
+    uint32_t start = bsp_usec_get32();
+    uint32_t lat = start - due;
+    int64_t step;
+    int64_t u;
+    int32_t err;
+    int32_t in;
+    int out;
+
+    /* nothing converted yet */
+    if (value < 0) {
+        return;
+    }
+    in = value << pc->in_shift;
+    if (!pc->primed) {
+        pc->prev_in = in;
+        pc->primed = 1;
+    }
+    err = (pc->sp << pc->in_shift) - in;
+
+    step = pc->ki * err;
+    pc->integ += step;
+    u = ((int64_t) pc->kp * err + (pc->integ >> ARDUINO_CTL_KI_SHIFT) + 
+         (int64_t) pc->kd * (pc->prev_in - in)) >> 15;
+    pc->prev_in = in;
+    if (u > ARDUINO_CTL_Q15_MAX) {
+        u = ARDUINO_CTL_Q15_MAX;
+        if (step > 0) {
+            pc->integ -= step;
+        }
+    } else if (u < 0) {
+        u = 0;
+        if (step < 0) {
+            pc->integ -= step;
+        }
+    }
+
+    out = pc->out_shift >= 0 ? (int) u >> pc->out_shift : 
+                               (int) u << -pc->out_shift;
+    if (pc->out_type == INTERFACE_DAC) {
+        hal_dac_write(pout->pdac, out);
+    } else {
+        hal_pwm_enable_duty_cycle(pout->ppwm, out);
+    }
+    pout->value = out;
+    pout->stamp = due;
+    pc->last_in = value;
+    pc->last_stamp = due;
+
+    if (pc->ticks == 0) {
+        pc->start = due;
+    }
+    pc->ticks++;
+    pc->lat_sum += lat;
+    if (lat < pc->lat_min) {
+        pc->lat_min = lat;
+    }
+    if (lat > pc->lat_max) {
+        pc->lat_max = lat;
+    }
+    lat = bsp_usec_get32() - start;
+    pc->busy_sum += lat;
+    if (lat > pc->busy_max) {
+        pc->busy_max = lat;
+    }
+}
+
+int
+arduino_ctl_uses(int entry_id)
+{
+    return arduino_ctl.running && 
+           (entry_id == arduino_ctl.in || entry_id == arduino_ctl.out);
+}
+
+int
+arduino_ctl_pin_op(struct arduino_pin_req *req)
+{
+    struct arduino_ctl *pc = &arduino_ctl;
+    os_sr_t sr;
+
+    if (req->apr_op != ARDUINO_OP_READ || req->apr_buf) {
+        return -4;
+    }
+    if (req->apr_entry == pc->out) {
+        req->apr_value = interface_map[pc->out].value;
+        return 0;
+    }
+    OS_ENTER_CRITICAL(sr);
+    req->apr_value = pc->last_in;
+    interface_map[pc->in].stamp = pc->last_stamp;
+    OS_EXIT_CRITICAL(sr);
+    return pc->last_in < 0 ? -1 : 0;
+}
+
+/* parses a gain like "1.25" or "-0.004" into Q15 */
+static int
+arduino_ctl_parse_gain(const char *str, int32_t *gain)
+{
+    uint32_t whole = 0;
+    uint32_t frac = 0;
+    uint32_t div = 1;
+    int neg = 0;
+
+    if (*str == '-') {
+        neg = 1;
+        str++;
+    }
+    if (*str < '0' || *str > '9') {
+        return -1;
+    }
+    while (*str >= '0' && *str <= '9') {
+        whole = whole * 10 + *str++ - '0';
+        if (whole >= ARDUINO_CTL_GAIN_MAX) {
+            return -1;
+        }
+    }
+    if (*str == '.') {
+        str++;
+        /* digits past the 5th are below a Q15 step */
+        while (*str >= '0' && *str <= '9') {
+            if (div < 100000) {
+                frac = frac * 10 + *str - '0';
+                div *= 10;
+            }
+            str++;
+        }
+    }
+    if (*str) {
+        return -1;
+    }
+    *gain = whole * ARDUINO_CTL_Q15_ONE + 
+            (frac * ARDUINO_CTL_Q15_ONE + div / 2) / div;
+    if (neg) {
+        *gain = -*gain;
+    }
+    return 0;
+}
+
+/* the output in Q15 as the integral starts from it, so the loop takes 
+ * over without a bump */
+static int64_t
+arduino_ctl_bumpless(struct arduino_ctl *pc)
+{
+    int32_t value = interface_map[pc->out].value;
+
+    if (pc->out_shift >= 0) {
+        value <<= pc->out_shift;
+    } else {
+        value >>= -pc->out_shift;
+    }
+    return (int64_t) value << (15 + ARDUINO_CTL_KI_SHIFT);
+}
+
+static int
+arduino_ctl_start(int in, int out, uint32_t rate, int sp, int32_t kp, 
+                  int32_t ki, int32_t kd)
+{
+    struct arduino_ctl *pc = &arduino_ctl;
+    interfaces_t *pin = &interface_map[in];
+    interfaces_t *pout = &interface_map[out];
+    int64_t ki_tick;
+    int64_t kd_tick;
+    int bits;
+    int rc;
+
+    if (in == out || rate == 0 || rate > ARDUINO_CTL_MAX_RATE || sp < 0 ||
+        sp > ADC_TICK_MAX) {
+        return -1;
+    }
+    ki_tick = ((int64_t) ki << ARDUINO_CTL_KI_SHIFT) / (int32_t) rate;
+    kd_tick = (int64_t) kd * rate;
+    /* a gain that does not fit, or one that would do nothing */
+    if (kd_tick > INT32_MAX || kd_tick < -INT32_MAX || 
+        ki_tick >= ARDUINO_CTL_KI_MAX || ki_tick <= -ARDUINO_CTL_KI_MAX ||
+        (ki && ki_tick == 0)) {
+        return -1;
+    }
+
+    os_mutex_pend(&arduino_ctl_mutex, OS_WAIT_FOREVER);
+    if (pc->running) {
+        rc = -3;
+        goto out;
+    }
+    /* in the order the board setup takes them */
+    arduino_pin_lock(in < out ? in : out);
+    arduino_pin_lock(in < out ? out : in);
+    if (pin->type != INTERFACE_ADC || (pout->type != INTERFACE_DAC && 
+                                       pout->type != INTERFACE_PWM_DUTY)) {
+        rc = -1;
+        goto unlock;
+    }
+    bits = pout->type == INTERFACE_DAC ? pout->shift : 16;
+    if (bits < 1 || bits > 16) {
+        rc = -1;
+        goto unlock;
+    }
+
+    memset(pc, 0, sizeof(*pc));
+    pc->in = in;
+    pc->out = out;
+    pc->out_type = pout->type;
+    pc->in_shift = 15 - ADC_TICK_BITS;
+    pc->out_shift = 15 - bits;
+    pc->sp = sp;
+    pc->kp = kp;
+    pc->ki = ki_tick;
+    pc->kd = kd_tick;
+    pc->integ = arduino_ctl_bumpless(pc);
+    pc->rate = rate;
+    pc->last_in = -1;
+    pc->lat_min = UINT32_MAX;
+
+    pc->running = 1;
+    rc = adc_tick_start(pin_map[in].sysid, 1000000 / rate, arduino_ctl_tick,
+                        NULL);
+    if (rc) {
+        pc->running = 0;
+    }
+unlock:
+    arduino_pin_unlock(in < out ? out : in);
+    arduino_pin_unlock(in < out ? in : out);
+out:
+    os_mutex_release(&arduino_ctl_mutex);
+    return rc;
+}
+
+static int
+arduino_ctl_stop(void)
+{
+    struct arduino_ctl *pc = &arduino_ctl;
+    int rc = -1;
+
+    os_mutex_pend(&arduino_ctl_mutex, OS_WAIT_FOREVER);
+    if (pc->running) {
+        arduino_pin_lock(pc->in < pc->out ? pc->in : pc->out);
+        arduino_pin_lock(pc->in < pc->out ? pc->out : pc->in);
+        rc = adc_tick_stop();
+        pc->running = 0;
+        arduino_pin_unlock(pc->in < pc->out ? pc->out : pc->in);
+        arduino_pin_unlock(pc->in < pc->out ? pc->in : pc->out);
+    }
+    os_mutex_release(&arduino_ctl_mutex);
+    return rc;
+}
+
+static void
+arduino_ctl_show(void)
+{
+    struct arduino_ctl snap;
+    uint32_t elapsed;
+    uint32_t permille = 0;
+    uint32_t lat_mean = 0;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    snap = arduino_ctl;
+    OS_EXIT_CRITICAL(sr);
+    if (!snap.running) {
+        console_printf("No control loop\n");
+        return;
+    }
+    elapsed = snap.last_stamp - snap.start;
+    if (snap.ticks) {
+        lat_mean = snap.lat_sum / snap.ticks;
+    }
+    if (elapsed) {
+        permille = snap.busy_sum * 1000 / elapsed;
+    }
+    console_printf("%s -> %s at %lu Hz, setpoint %ld, in %ld out %d\n", 
+                   pin_map[snap.in].name, pin_map[snap.out].name, 
+                   (unsigned long) snap.rate, (long) snap.sp, 
+                   (long) snap.last_in, interface_map[snap.out].value);
+    if (!snap.ticks) {
+        return;
+    }
+    console_printf("%lu ticks, %lu missed, latency %lu/%lu/%lu us "
+                   "min/mean/max, jitter %lu us\n", 
+                   (unsigned long) snap.ticks, 
+                   (unsigned long) adc_tick_missed(),
+                   (unsigned long) snap.lat_min, (unsigned long) lat_mean, 
+                   (unsigned long) snap.lat_max, 
+                   (unsigned long) (snap.lat_max - snap.lat_min));
+    console_printf("loop %lu us mean, %lu us max, cpu %lu.%lu %%\n", 
+                   (unsigned long) (snap.busy_sum / snap.ticks),
+                   (unsigned long) snap.busy_max, 
+                   (unsigned long) permille / 10, 
+                   (unsigned long) permille % 10);
+}
+
+int
+arduino_ctl_cmd(int argc, char **argv)
+{
+    int32_t gain[3] = { 0, 0, 0 };
+    uint32_t rate;
+    int in;
+    int out;
+    int sp;
+    int rc;
+    int i;
+
+    if (argc == 1) {
+        arduino_ctl_show();
+        return 0;
+    }
+    if (argc == 2 && !strcmp(argv[1], "off")) {
+        if (arduino_ctl_stop()) {
+            console_printf("No control loop\n");
+        }
+        return 0;
+    }
+    if (argc == 3 && !strcmp(argv[1], "sp")) {
+        sp = atoi(argv[2]);
+        if (sp < 0 || sp > ADC_TICK_MAX) {
+            return -1;
+        }
+        /* one word, the interrupt takes it at the next tick */
+        arduino_ctl.sp = sp;
+        return 0;
+    }
+
+    /* ctl <in> <out> <rate> <setpoint> <kp> [<ki> [<kd>]] */
+    if (argc < 6 || argc > 8) {
+        return -1;
+    }
+    in = arduino_pinstr_to_entry(argv[1]);
+    out = arduino_pinstr_to_entry(argv[2]);
+    rate = strtoul(argv[3], NULL, 0);
+    sp = atoi(argv[4]);
+    for (i = 5; i < argc; i++) {
+        if (arduino_ctl_parse_gain(argv[i], &gain[i - 5])) {
+            return -1;
+        }
+    }
+    if (in < 0 || out < 0 || rate == 0 || rate > ARDUINO_CTL_MAX_RATE ||
+        sp < 0 || sp > ADC_TICK_MAX) {
+        return -1;
+    }
+
+    rc = arduino_ctl_start(in, out, rate, sp, gain[0], gain[1], gain[2]);
+    if (rc == -3) {
+        console_printf("A control loop is already running\n");
+    } else if (rc == -2) {
+        console_printf("Unable to start the loop, the ADC is in use\n");
+    } else if (rc) {
+        console_printf("Unable to start the loop, %s has to be adc and %s "
+                       "dac or pwm_duty\n", argv[1], argv[2]);
+    }
+    return 0;
+}
+
+int
+arduino_ctl_init(void)
+{
+    return os_mutex_init(&arduino_ctl_mutex);
+}
@@ -0,0 +1,98 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <bsp/bsp_usec.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Things pins report on their own, like ADC window crossings, are 
+ * posted from interrupt context into a small ring.  Whoever wants them
+ * takes them out with arduino_test_event_get(), optionally woken up by
+ * an os_event on its own queue.  When the ring is full new events are
+ * dropped and counted.
+ */
+
+#define ARDUINO_EVENT_QLEN      (16)
+
+static struct arduino_test_event arduino_event_q[ARDUINO_EVENT_QLEN];
+static uint8_t arduino_event_head;
+static uint8_t arduino_event_tail;
+static uint32_t arduino_event_drops;
+
+static struct os_eventq *arduino_event_evq;
+static struct os_event arduino_event_ev = {
+    .ev_type = ARDUINO_TEST_EVENT_T,
+};
+
+void
+arduino_event_post(int entry_id, int kind, int value)
+{
+    struct arduino_test_event *pev;
+    uint32_t stamp = bsp_usec_get32();
+    uint8_t next;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    next = (arduino_event_head + 1) % ARDUINO_EVENT_QLEN;
+    if (next == arduino_event_tail) {
+        arduino_event_drops++;
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    pev = &arduino_event_q[arduino_event_head];
+    pev->entry_id = entry_id;
+    pev->kind = kind;
+    pev->value = value;
+    pev->usecs = stamp;
+    arduino_event_head = next;
+    OS_EXIT_CRITICAL(sr);
+
+    if (arduino_event_evq) {
+        os_eventq_put(arduino_event_evq, &arduino_event_ev);
+    }
+}
+
+int
+arduino_test_event_get(struct arduino_test_event *ev)
+{
+    os_sr_t sr;
+    int rc = -1;
+
+    OS_ENTER_CRITICAL(sr);
+    if (arduino_event_tail != arduino_event_head) {
+        *ev = arduino_event_q[arduino_event_tail];
+        arduino_event_tail = (arduino_event_tail + 1) % ARDUINO_EVENT_QLEN;
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+    return rc;
+}
+
+uint32_t
+arduino_test_event_drops(void)
+{
+    return arduino_event_drops;
+}
+
+void
+arduino_test_event_notify(struct os_eventq *evq)
+{
+    arduino_event_evq = evq;
+}
@@ -0,0 +1,65 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* the first byte of a header, the second is the kind of file */
+#define ARDUINO_FILE_MAGIC      ('A')
+
+int
+arduino_file_path(const char *dir, const char *name, char *path)
+{
+    int len = strlen(name);
+    int i;
+
+    if (len == 0 || len > ARDUINO_FILE_NAME_LEN) {
+        return -1;
+    }
+    for (i = 0; i < len; i++) {
+        if (!((name[i] >= 'a' && name[i] <= 'z') || 
+              (name[i] >= 'A' && name[i] <= 'Z') ||
+              (name[i] >= '0' && name[i] <= '9') || name[i] == '_')) {
+            return -1;
+        }
+    }
+    strcpy(path, dir);
+    strcat(path, "/");
+    strcat(path, name);
+    return 0;
+}
+
+void
+arduino_file_hdr_put(uint8_t *buf, uint8_t kind)
+{
+    buf[0] = ARDUINO_FILE_MAGIC;
+    buf[1] = kind;
+    buf[2] = ARDUINO_NUM_DEVS;
+    buf[3] = INTERFACE_MAX;
+}
+
+int
+arduino_file_hdr_check(const uint8_t *buf, int len, uint8_t kind)
+{
+    if (len < ARDUINO_FILE_HDR_LEN || buf[0] != ARDUINO_FILE_MAGIC ||
+        buf[1] != kind || buf[2] != ARDUINO_NUM_DEVS || 
+        buf[3] != INTERFACE_MAX) {
+        return -1;
+    }
+    return 0;
+}
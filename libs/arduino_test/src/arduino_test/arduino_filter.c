@@ -0,0 +1,157 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Q15 streaming filters.  The M0+ has a single cycle multiplier but no
+ * divider, so the average is a running sum over a power of two window, 
+ * the iir is one multiply per sample and the median keeps its window 
+ * sorted, moving one entry per sample instead of sorting.
+ */
+
+int
+arduino_filter_valid(int kind, int param, int decim)
+{
+    if (decim < 1 || decim > ARDUINO_FILTER_DECIM_MAX) {
+        return 0;
+    }
+    switch (kind) {
+        case ARDUINO_FILTER_NONE:
+            return param == 0;
+        case ARDUINO_FILTER_AVG:
+            return param >= 2 && param <= ARDUINO_FILTER_MAX_LEN && 
+                   !(param & (param - 1));
+        case ARDUINO_FILTER_IIR:
+            return param >= 1 && param <= INT16_MAX;
+        case ARDUINO_FILTER_MEDIAN:
+            return param >= 3 && param < ARDUINO_FILTER_MAX_LEN && 
+                   (param & 1);
+        default:
+            return 0;
+    }
+}
+
+int
+arduino_test_filter_init(struct arduino_test_filter *pf, int kind, 
+                         int param, int decim)
+{
+    if (!arduino_filter_valid(kind, param, decim)) {
+        return -1;
+    }
+    memset(pf, 0, sizeof(*pf));
+    pf->kind = kind;
+    pf->decim = decim;
+    if (kind == ARDUINO_FILTER_IIR) {
+        pf->alpha = param;
+    } else if (kind != ARDUINO_FILTER_NONE) {
+        pf->len = param;
+        while ((1 << pf->shift) < param) {
+            pf->shift++;
+        }
+    }
+    return 0;
+}
+
+/* starts the window from the first sample instead of from 0 */
+static void
+arduino_filter_prime(struct arduino_test_filter *pf, int16_t x)
+{
+    int i;
+
+    for (i = 0; i < pf->len; i++) {
+        pf->win[i] = x;
+        pf->sorted[i] = x;
+    }
+    if (pf->kind == ARDUINO_FILTER_IIR) {
+        pf->acc = (int32_t) x << 15;
+    } else {
+        pf->acc = (int32_t) x * pf->len;
+    }
+    pf->primed = 1;
+}
+
+/* replaces the oldest sample of the sorted window with x */
+static int16_t
+arduino_filter_median(struct arduino_test_filter *pf, int16_t x)
+{
+    int16_t old = pf->win[pf->pos];
+    int16_t *s = pf->sorted;
+    int i = 0;
+
+    while (s[i] != old) {
+        i++;
+    }
+    /* move the hole left or right to where x belongs */
+    while (i > 0 && s[i - 1] > x) {
+        s[i] = s[i - 1];
+        i--;
+    }
+    while (i < pf->len - 1 && s[i + 1] < x) {
+        s[i] = s[i + 1];
+        i++;
+    }
+    s[i] = x;
+    return s[pf->len >> 1];
+}
+
+int
+arduino_test_filter_run(struct arduino_test_filter *pf, const int16_t *in,
+                        int cnt, int16_t *out)
+{
+    int32_t y;
+    int16_t x;
+    int n = 0;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        x = in[i];
+        if (!pf->primed) {
+            arduino_filter_prime(pf, x);
+        }
+        switch (pf->kind) {
+            case ARDUINO_FILTER_AVG:
+                pf->acc += x - pf->win[pf->pos];
+                y = (pf->acc + (1 << (pf->shift - 1))) >> pf->shift;
+                break;
+            case ARDUINO_FILTER_IIR:
+                /* y += alpha * (x - y), kept with 15 more bits */
+                pf->acc += (int32_t) pf->alpha * (x - (pf->acc >> 15));
+                y = pf->acc >> 15;
+                break;
+            case ARDUINO_FILTER_MEDIAN:
+                y = arduino_filter_median(pf, x);
+                break;
+            default:
+                y = x;
+                break;
+        }
+        if (pf->len) {
+            pf->win[pf->pos] = x;
+            if (++pf->pos == pf->len) {
+                pf->pos = 0;
+            }
+        }
+        if (++pf->cnt == pf->decim) {
+            pf->cnt = 0;
+            out[n++] = y;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,797 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <console/console.h>
+#include <hal/flash_map.h>
+#include <util/crc16.h>
+#include <bsp/bsp.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_trig.h>
+#include <arduino_test/arduino_codec.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Raw sample log, an append-only ring in a flash area of its own with no
+ * file system.  The area is cut into blocks of whole erase sectors, each
+ * starting with a header that holds a sequence number, so the newest
+ * block is found by reading one header per block.  Records follow the
+ * header, a length and a CRC16 and the data padded to a word.  Erased 
+ * flash reads 0xff, a length of 0xffff is the end of a block.  Only the
+ * block being written is walked at open, so the recovery scan is short.
+ *
+ * Records are collected in a page buffer and a page is programmed when
+ * it fills.  When the head block is full the next one is erased, it 
+ * holds the oldest records.  That is the only stall, one block erase.
+ */
+
+#define ARDUINO_LOG_MAGIC       (0x474f4c41)    /* "ALOG" */
+/* the SAMD21 programs 64 byte pages, a shorter write costs a whole one */
+#define ARDUINO_LOG_PAGE        (64)
+/* small sectors are combined so the block header is a small overhead */
+#define ARDUINO_LOG_BLOCK_MIN   (2048)
+#define ARDUINO_LOG_ALIGN(len)  (((len) + 3) & ~3)
+#define ARDUINO_LOG_END         (0xffff)
+/* the piece of flash an export reads at a time */
+#define ARDUINO_LOG_EXPORT_WIN  (48)
+
+/* "arduino log" records a block of conversions of a pin per record, in
+ * the form of arduino_codec.h */
+#define ARDUINO_LOG_MAX_SAMPLES (256)
+#define ARDUINO_LOG_MAX_RATE    (1000000 / ADC_TRIG_MIN_PERIOD)
+#define ARDUINO_LOG_MAX_USECS   (2000000)
+#define ARDUINO_LOG_MAX_RECORDS (1000)
+#define ARDUINO_LOG_SHOW        (8)
+
+struct arduino_log_block_hdr
+{
+    uint32_t magic;
+    uint32_t seq;
+};
+
+struct arduino_log_rec_hdr
+{
+    uint16_t len;
+    uint16_t crc;               /* CRC16-CCITT of len and the data */
+};
+
+struct arduino_log
+{
+    const struct flash_area *fa;
+    uint32_t block_size;
+    uint16_t blocks;
+    uint16_t head;              /* the block being written */
+    uint16_t full;              /* blocks of older records before it */
+    uint32_t seq;               /* of the head block */
+    uint32_t off;               /* where the next record goes */
+    uint32_t written;           /* flash is programmed up to here */
+    uint32_t erases;
+    uint32_t bad;
+    uint32_t scan_usecs;
+    /* the page off is in, from written on it is not in flash yet */
+    uint8_t  page[ARDUINO_LOG_PAGE];
+};
+
+static struct arduino_log arduino_log;
+static struct os_mutex arduino_log_mutex;
+
+static int16_t arduino_log_samples_buf[ARDUINO_LOG_MAX_SAMPLES];
+static uint8_t arduino_log_rec[ARDUINO_CODEC_MAX_LEN(ARDUINO_LOG_MAX_SAMPLES)];
+static struct os_mutex arduino_log_rec_mutex;
+
+static uint16_t
+arduino_log_crc(uint16_t len, const void *data)
+{
+    uint16_t crc;
+
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, &len, sizeof(len));
+    return crc16_ccitt(crc, data, len);
+}
+
+/* programs what is not in flash yet up to end, in the page of written */
+static int
+arduino_log_program(uint32_t end)
+{
+    struct arduino_log *plog = &arduino_log;
+    uint32_t base = plog->written & ~(ARDUINO_LOG_PAGE - 1);
+    int rc;
+
+    if (end <= plog->written) {
+        return 0;
+    }
+    rc = flash_area_write(plog->fa, plog->written, 
+                          plog->page + (plog->written - base), 
+                          end - plog->written);
+    if (rc) {
+        return rc;
+    }
+    plog->written = end;
+    if ((end & (ARDUINO_LOG_PAGE - 1)) == 0) {
+        memset(plog->page, 0xff, sizeof(plog->page));
+    }
+    return 0;
+}
+
+/* adds len bytes at off, padding if data is NULL */
+static int
+arduino_log_put(const void *data, int len)
+{
+    struct arduino_log *plog = &arduino_log;
+    const uint8_t *src = data;
+    int room;
+    int rc;
+
+    while (len > 0) {
+        room = ARDUINO_LOG_PAGE - (plog->off & (ARDUINO_LOG_PAGE - 1));
+        if (room > len) {
+            room = len;
+        }
+        if (src) {
+            memcpy(plog->page + (plog->off & (ARDUINO_LOG_PAGE - 1)), src, 
+                   room);
+            src += room;
+        }
+        plog->off += room;
+        len -= room;
+        if ((plog->off & (ARDUINO_LOG_PAGE - 1)) == 0) {
+            rc = arduino_log_program(plog->off);
+            if (rc) {
+                return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+static int
+arduino_log_start_block(int block, uint32_t seq)
+{
+    struct arduino_log *plog = &arduino_log;
+    struct arduino_log_block_hdr hdr;
+    uint32_t start = block * plog->block_size;
+    int rc;
+
+    rc = flash_area_erase(plog->fa, start, plog->block_size);
+    if (rc) {
+        return rc;
+    }
+    plog->erases++;
+    plog->head = block;
+    plog->seq = seq;
+    plog->off = start;
+    plog->written = start;
+    memset(plog->page, 0xff, sizeof(plog->page));
+
+    hdr.magic = ARDUINO_LOG_MAGIC;
+    hdr.seq = seq;
+    return arduino_log_put(&hdr, sizeof(hdr));
+}
+
+/* walks the records of the head block to the first erased length */
+static int
+arduino_log_find_end(void)
+{
+    struct arduino_log *plog = &arduino_log;
+    struct arduino_log_rec_hdr hdr;
+    uint8_t tail[ARDUINO_LOG_PAGE];
+    uint32_t end = (plog->head + 1) * plog->block_size;
+    uint32_t pos = plog->head * plog->block_size + 
+                   sizeof(struct arduino_log_block_hdr);
+    uint32_t page_end;
+    int rc;
+    int i;
+
+    while (pos + sizeof(hdr) <= end) {
+        rc = flash_area_read(plog->fa, pos, &hdr, sizeof(hdr));
+        if (rc) {
+            return rc;
+        }
+        if (hdr.len == ARDUINO_LOG_END) {
+            break;
+        }
+        pos += ARDUINO_LOG_ALIGN(sizeof(hdr) + hdr.len);
+    }
+    if (pos > end) {
+        pos = end;
+    }
+
+    /* a page cut off while it was programmed can have bytes after the
+     * end, the next record goes on a clean page then */
+    if (pos < end) {
+        page_end = (pos | (ARDUINO_LOG_PAGE - 1)) + 1;
+        rc = flash_area_read(plog->fa, pos, tail, page_end - pos);
+        if (rc) {
+            return rc;
+        }
+        for (i = 0; i < page_end - pos; i++) {
+            if (tail[i] != 0xff) {
+                pos = page_end;
+                break;
+            }
+        }
+    }
+    plog->off = pos;
+    plog->written = pos;
+    memset(plog->page, 0xff, sizeof(plog->page));
+    return 0;
+}
+
+int
+arduino_test_log_open(int flash_area_id)
+{
+    struct arduino_log *plog = &arduino_log;
+    struct arduino_log_block_hdr hdr;
+    const struct flash_area *fa;
+    uint32_t sector;
+    uint32_t start;
+    int found = 0;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = flash_area_to_sectors(flash_area_id, &cnt, NULL);
+    if (rc || cnt == 0) {
+        return -1;
+    }
+    rc = flash_area_open(flash_area_id, &fa);
+    if (rc) {
+        return -1;
+    }
+
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    memset(plog, 0, sizeof(*plog));
+    sector = fa->fa_size / cnt;
+    plog->block_size = sector * 
+                       ((ARDUINO_LOG_BLOCK_MIN + sector - 1) / sector);
+    plog->blocks = fa->fa_size / plog->block_size;
+    if (plog->blocks < 2 || (sector & (ARDUINO_LOG_PAGE - 1))) {
+        rc = -1;
+        goto out;
+    }
+    plog->fa = fa;
+
+    /* the newest block has the highest sequence number */
+    start = bsp_usec_get32();
+    for (i = 0; i < plog->blocks; i++) {
+        rc = flash_area_read(fa, i * plog->block_size, &hdr, sizeof(hdr));
+        if (rc) {
+            goto out;
+        }
+        if (hdr.magic == ARDUINO_LOG_MAGIC && 
+            (!found || (int32_t) (hdr.seq - plog->seq) > 0)) {
+            found = 1;
+            plog->head = i;
+            plog->seq = hdr.seq;
+        }
+    }
+    if (!found) {
+        rc = arduino_log_start_block(0, 0);
+        goto out;
+    }
+
+    /* the blocks before it count if their numbers run up to it */
+    for (i = 1; i < plog->blocks; i++) {
+        rc = flash_area_read(fa, ((plog->head + plog->blocks - i) % 
+                                  plog->blocks) * plog->block_size, 
+                             &hdr, sizeof(hdr));
+        if (rc) {
+            goto out;
+        }
+        if (hdr.magic != ARDUINO_LOG_MAGIC || hdr.seq != plog->seq - i) {
+            break;
+        }
+    }
+    plog->full = i - 1;
+    rc = arduino_log_find_end();
+
+out:
+    if (rc) {
+        plog->fa = NULL;
+    } else {
+        plog->scan_usecs = bsp_usec_get32() - start;
+    }
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+int
+arduino_test_log_append(const void *data, int len)
+{
+    struct arduino_log *plog = &arduino_log;
+    struct arduino_log_rec_hdr hdr;
+    uint32_t stride = ARDUINO_LOG_ALIGN(sizeof(hdr) + len);
+    int rc;
+
+    if (len <= 0 || len >= ARDUINO_LOG_END) {
+        return -1;
+    }
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    if (!plog->fa || stride > plog->block_size - 
+                              sizeof(struct arduino_log_block_hdr)) {
+        rc = -1;
+        goto out;
+    }
+    if (plog->off + stride > (plog->head + 1) * plog->block_size) {
+        rc = arduino_log_program(plog->off);
+        if (rc) {
+            goto out;
+        }
+        rc = arduino_log_start_block((plog->head + 1) % plog->blocks, 
+                                     plog->seq + 1);
+        if (rc) {
+            goto out;
+        }
+        if (plog->full < plog->blocks - 1) {
+            plog->full++;
+        }
+    }
+
+    hdr.len = len;
+    hdr.crc = arduino_log_crc(len, data);
+    rc = arduino_log_put(&hdr, sizeof(hdr));
+    if (rc == 0) {
+        rc = arduino_log_put(data, len);
+    }
+    if (rc == 0) {
+        rc = arduino_log_put(NULL, stride - sizeof(hdr) - len);
+    }
+out:
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+int
+arduino_test_log_flush(void)
+{
+    int rc;
+
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    if (!arduino_log.fa) {
+        rc = -1;
+    } else {
+        rc = arduino_log_program(arduino_log.off);
+    }
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+int
+arduino_test_log_erase(void)
+{
+    struct arduino_log *plog = &arduino_log;
+    int rc;
+
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    if (!plog->fa) {
+        rc = -1;
+        goto out;
+    }
+    /* the first block is erased when it is started */
+    rc = flash_area_erase(plog->fa, plog->block_size, 
+                          (plog->blocks - 1) * plog->block_size);
+    if (rc) {
+        goto out;
+    }
+    plog->erases += plog->blocks - 1;
+    plog->full = 0;
+    rc = arduino_log_start_block(0, plog->seq + 1);
+out:
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+int
+arduino_test_log_walk(int (*cb)(void *arg, const void *data, int len),
+                      void *arg, void *buf, int size)
+{
+    struct arduino_log *plog = &arduino_log;
+    struct arduino_log_rec_hdr hdr;
+    uint32_t stride;
+    uint32_t pos;
+    uint32_t end;
+    int block;
+    int rc;
+    int i;
+
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    if (!plog->fa) {
+        rc = -1;
+        goto out;
+    }
+    /* the records still in the page buffer too */
+    rc = arduino_log_program(plog->off);
+    if (rc) {
+        goto out;
+    }
+    plog->bad = 0;
+
+    for (i = plog->full; i >= 0; i--) {
+        block = (plog->head + plog->blocks - i) % plog->blocks;
+        pos = block * plog->block_size;
+        end = i ? pos + plog->block_size : plog->off;
+        pos += sizeof(struct arduino_log_block_hdr);
+        while (pos + sizeof(hdr) <= end) {
+            rc = flash_area_read(plog->fa, pos, &hdr, sizeof(hdr));
+            if (rc) {
+                goto out;
+            }
+            stride = ARDUINO_LOG_ALIGN(sizeof(hdr) + hdr.len);
+            if (hdr.len == ARDUINO_LOG_END || pos + stride > end) {
+                break;
+            }
+            if (hdr.len <= size) {
+                rc = flash_area_read(plog->fa, pos + sizeof(hdr), buf, 
+                                     hdr.len);
+                if (rc) {
+                    goto out;
+                }
+                if (arduino_log_crc(hdr.len, buf) != hdr.crc) {
+                    plog->bad++;
+                } else if (cb(arg, buf, hdr.len)) {
+                    goto out;
+                }
+            }
+            pos += stride;
+        }
+    }
+out:
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+int
+arduino_test_log_info(struct arduino_test_log_info *info)
+{
+    struct arduino_log *plog = &arduino_log;
+    int rc = 0;
+
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    if (!plog->fa) {
+        rc = -1;
+    } else {
+        info->size = plog->fa->fa_size;
+        info->used = plog->full * plog->block_size + 
+                     plog->off - plog->head * plog->block_size;
+        info->block_size = plog->block_size;
+        info->erases = plog->erases;
+        info->bad = plog->bad;
+        info->scan_usecs = plog->scan_usecs;
+    }
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+int
+arduino_log_export(uint32_t *off, int len, uint32_t *end,
+                   int (*out)(void *arg, const void *data, int len), 
+                   void *arg)
+{
+    struct arduino_log *plog = &arduino_log;
+    uint8_t win[ARDUINO_LOG_EXPORT_WIN];
+    uint32_t first;
+    uint32_t block_seq;
+    uint32_t pos;
+    uint32_t addr;
+    int chunk;
+    int cnt;
+    int rc;
+
+    os_mutex_pend(&arduino_log_mutex, OS_WAIT_FOREVER);
+    if (!plog->fa) {
+        rc = -1;
+        goto out;
+    }
+    /* the records still in the page buffer too */
+    rc = arduino_log_program(plog->off);
+    if (rc) {
+        goto out;
+    }
+
+    first = (plog->seq - plog->full) * plog->block_size;
+    *end = plog->seq * plog->block_size + 
+           plog->off - plog->head * plog->block_size;
+    if ((int32_t) (*off - first) < 0) {
+        *off = first;
+    }
+    if ((int32_t) (*end - *off) < 0) {
+        rc = -1;
+        goto out;
+    }
+
+    /* up to the end of the block the offset is in */
+    block_seq = *off / plog->block_size;
+    pos = *off - block_seq * plog->block_size;
+    cnt = plog->block_size - pos;
+    if (cnt > *end - *off) {
+        cnt = *end - *off;
+    }
+    if (cnt > len) {
+        cnt = len;
+    }
+    addr = ((plog->head + plog->blocks - (plog->seq - block_seq)) % 
+            plog->blocks) * plog->block_size + pos;
+
+    for (len = 0; len < cnt; len += chunk) {
+        chunk = cnt - len;
+        if (chunk > sizeof(win)) {
+            chunk = sizeof(win);
+        }
+        rc = flash_area_read(plog->fa, addr + len, win, chunk);
+        if (rc) {
+            goto out;
+        }
+        rc = out(arg, win, chunk);
+        if (rc) {
+            goto out;
+        }
+    }
+    rc = cnt;
+out:
+    os_mutex_release(&arduino_log_mutex);
+    return rc;
+}
+
+/* counts the records, then prints those from skip on */
+struct arduino_log_show
+{
+    int cnt;
+    int skip;
+};
+
+static int
+arduino_log_count_cb(void *arg, const void *data, int len)
+{
+    ((struct arduino_log_show *) arg)->cnt++;
+    return 0;
+}
+
+static int
+arduino_log_bits(uint32_t mask)
+{
+    int cnt = 0;
+
+    for (; mask; mask >>= 1) {
+        cnt += mask & 1;
+    }
+    return cnt;
+}
+
+static int
+arduino_log_show_cb(void *arg, const void *data, int len)
+{
+    struct arduino_log_show *ps = arg;
+    struct arduino_codec_hdr hdr;
+    struct arduino_codec_summary sum;
+    struct arduino_codec_snapshot snap;
+    int16_t *samples = arduino_log_samples_buf;
+    int min;
+    int max;
+    int i;
+
+    if (ps->cnt++ < ps->skip) {
+        return 0;
+    }
+    if (arduino_codec_decode_summary(data, len, &sum) == len && 
+        sum.entry_id < ARDUINO_NUM_DEVS) {
+        console_printf("  %10lu %s %lu values in %lu ms, min %ld max %ld "
+                       "mean %ld, %d bytes\n", (unsigned long) sum.stamp, 
+                       pin_map[sum.entry_id].name, (unsigned long) sum.cnt,
+                       (unsigned long) sum.window, (long) sum.min, 
+                       (long) sum.max, (long) sum.mean, len);
+        return 0;
+    }
+    if (arduino_codec_decode_snapshot(data, len, &snap) == len) {
+        console_printf("  %10lu snapshot of %d gpio and %d adc pins, "
+                       "%d bytes\n", (unsigned long) snap.stamp, 
+                       arduino_log_bits(snap.gpio_mask), 
+                       arduino_log_bits(snap.adc_mask), len);
+        return 0;
+    }
+    if (arduino_codec_decode(data, len, &hdr, samples, 
+                             ARDUINO_LOG_MAX_SAMPLES) != len || 
+        hdr.cnt == 0 || hdr.entry_id >= ARDUINO_NUM_DEVS) {
+        console_printf("  %d bytes\n", len);
+        return 0;
+    }
+    min = max = samples[0];
+    for (i = 1; i < hdr.cnt; i++) {
+        if (samples[i] < min) {
+            min = samples[i];
+        } else if (samples[i] > max) {
+            max = samples[i];
+        }
+    }
+    console_printf("  %10lu %s %d samples every %lu us, min %d max %d, "
+                   "%d bytes\n", (unsigned long) hdr.stamp, 
+                   pin_map[hdr.entry_id].name, hdr.cnt, 
+                   (unsigned long) hdr.period, min, max, len);
+    return 0;
+}
+
+static void
+arduino_log_show(int last)
+{
+    struct arduino_log_show show = { 0 };
+    int rc;
+
+    rc = arduino_test_log_walk(arduino_log_count_cb, &show, 
+                               arduino_log_rec, sizeof(arduino_log_rec));
+    if (rc == 0) {
+        console_printf("%d records in the sample log\n", show.cnt);
+        show.skip = show.cnt > last ? show.cnt - last : 0;
+        show.cnt = 0;
+        rc = arduino_test_log_walk(arduino_log_show_cb, &show, 
+                                   arduino_log_rec, sizeof(arduino_log_rec));
+    }
+    if (rc) {
+        console_printf("Unable to read the sample log, err=%d\n", rc);
+    }
+}
+
+static void
+arduino_log_show_info(void)
+{
+    struct arduino_test_log_info info;
+    int rc;
+
+    rc = arduino_test_log_info(&info);
+    if (rc) {
+        console_printf("No sample log, err=%d\n", rc);
+        return;
+    }
+    console_printf("Sample log %lu of %lu bytes used, blocks of %lu bytes, "
+                   "%lu erased, %lu bad records, opened in %lu us\n", 
+                   (unsigned long) info.used, (unsigned long) info.size, 
+                   (unsigned long) info.block_size, 
+                   (unsigned long) info.erases, (unsigned long) info.bad,
+                   (unsigned long) info.scan_usecs);
+}
+
+/* takes records blocks of cnt conversions of a pin into the log, bytes
+ * gets what they took in flash */
+static int
+arduino_log_samples(int entry_id, uint32_t rate, int cnt, int records, 
+                    uint32_t *append_usecs, uint32_t *bytes)
+{
+    struct arduino_pin_req req;
+    struct arduino_codec_hdr hdr;
+    uint32_t start;
+    int len;
+    int rc = 0;
+    int i;
+
+    *append_usecs = 0;
+    *bytes = 0;
+    for (i = 0; i < records && rc == 0; i++) {
+        memset(&req, 0, sizeof(req));
+        req.apr_op = ARDUINO_OP_READ;
+        req.apr_entry = entry_id;
+        req.apr_arg = cnt;
+        req.apr_value = 1000000 / rate;
+        req.apr_buf = arduino_log_samples_buf;
+        req.apr_type_mask = 1UL << INTERFACE_ADC;
+        rc = arduino_task_call(&req);
+        if (rc) {
+            break;
+        }
+
+        start = bsp_usec_get32();
+        hdr.entry_id = entry_id;
+        hdr.cnt = cnt;
+        hdr.stamp = req.apr_stamp;
+        /* the spacing the conversions actually had */
+        hdr.period = cnt > 1 ? 
+                     (req.apr_value + (cnt - 1) / 2) / (cnt - 1) : 0;
+        len = arduino_codec_encode(&hdr, arduino_log_samples_buf, 
+                                   arduino_log_rec, sizeof(arduino_log_rec));
+        rc = arduino_test_log_append(arduino_log_rec, len);
+        *append_usecs += bsp_usec_get32() - start;
+        *bytes += len;
+    }
+    if (rc == 0) {
+        start = bsp_usec_get32();
+        rc = arduino_test_log_flush();
+        *append_usecs += bsp_usec_get32() - start;
+    }
+    return rc;
+}
+
+int
+arduino_log_cmd(int argc, char **argv)
+{
+    uint32_t rate;
+    uint32_t usecs;
+    uint32_t bytes;
+    int entry_id;
+    int records = 1;
+    int cnt;
+    int rc;
+
+    if (argc == 2 && !strcmp(argv[1], "info")) {
+        arduino_log_show_info();
+        return 0;
+    }
+    if (argc == 2 && !strcmp(argv[1], "erase")) {
+        rc = arduino_test_log_erase();
+        if (rc) {
+            console_printf("Unable to erase the sample log, err=%d\n", rc);
+        } else {
+            console_printf("Erased the sample log\n");
+        }
+        return 0;
+    }
+    if ((argc == 2 || argc == 3) && !strcmp(argv[1], "show")) {
+        cnt = argc == 3 ? atoi(argv[2]) : ARDUINO_LOG_SHOW;
+        if (cnt <= 0) {
+            return -1;
+        }
+        os_mutex_pend(&arduino_log_rec_mutex, OS_WAIT_FOREVER);
+        arduino_log_show(cnt);
+        os_mutex_release(&arduino_log_rec_mutex);
+        return 0;
+    }
+
+    /* log <pin> <rate> <samples> [records] */
+    if (argc != 4 && argc != 5) {
+        return -1;
+    }
+    entry_id = arduino_pinstr_to_entry(argv[1]);
+    rate = strtoul(argv[2], NULL, 0);
+    cnt = atoi(argv[3]);
+    if (argc == 5) {
+        records = atoi(argv[4]);
+    }
+    if (entry_id < 0 || rate == 0 || rate > ARDUINO_LOG_MAX_RATE ||
+        cnt < 1 || cnt > ARDUINO_LOG_MAX_SAMPLES || 
+        (uint64_t) (cnt - 1) * 1000000 / rate > ARDUINO_LOG_MAX_USECS ||
+        records < 1 || records > ARDUINO_LOG_MAX_RECORDS) {
+        return -1;
+    }
+
+    os_mutex_pend(&arduino_log_rec_mutex, OS_WAIT_FOREVER);
+    rc = arduino_log_samples(entry_id, rate, cnt, records, &usecs, &bytes);
+    os_mutex_release(&arduino_log_rec_mutex);
+    if (rc) {
+        console_printf("Unable to log %s, err=%d\n", argv[1], rc);
+    } else {
+        console_printf("Logged %d records of %d samples of %s in %lu bytes, "
+                       "appends took %lu us\n", records, cnt, argv[1], 
+                       (unsigned long) bytes, (unsigned long) usecs);
+    }
+    return 0;
+}
+
+int
+arduino_log_init(void)
+{
+    int rc;
+
+    rc = os_mutex_init(&arduino_log_mutex);
+    if (rc) {
+        return rc;
+    }
+    rc = os_mutex_init(&arduino_log_rec_mutex);
+    if (rc) {
+        return rc;
+    }
+    /* without a usable area the log commands say so, the rest works */
+    (void) arduino_test_log_open(FLASH_AREA_SAMPLE_LOG);
+    return 0;
+}
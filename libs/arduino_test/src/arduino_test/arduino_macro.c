@@ -0,0 +1,377 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <console/console.h>
+#include <fs/fs.h>
+#include <fs/fsutil.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Macros are pin command sequences stored in NFFS under ARDUINO_MACRO_DIR.
+ * Every line is compiled when it is added, pin and function names are 
+ * resolved to entry ids and values are parsed, so running a macro does 
+ * no text handling at all.  A step is an opcode byte and its operands:
+ *
+ *   ARDUINO_MACRO_SET     <entry> <type>
+ *   ARDUINO_MACRO_WRITE   <entry> <value, 4 bytes little endian>
+ *   ARDUINO_MACRO_READ    <entry>
+ *   ARDUINO_MACRO_DELAY   <ms, 2 bytes little endian>
+ *
+ * The file starts with a header that records the size of the pin and 
+ * function tables, a macro compiled by a build where they differ is 
+ * refused rather than run on the wrong pins.
+ */
+
+#define ARDUINO_MACRO_DIR       "/macro"
+#define ARDUINO_MACRO_KIND      ('M')
+
+#ifndef ARDUINO_MACRO_MAX_LEN
+#define ARDUINO_MACRO_MAX_LEN   (256)
+#endif
+
+enum arduino_macro_op
+{
+    ARDUINO_MACRO_SET = 1,
+    ARDUINO_MACRO_WRITE,
+    ARDUINO_MACRO_READ,
+    ARDUINO_MACRO_DELAY,
+    ARDUINO_MACRO_OP_MAX,
+};
+
+/* the length of a step by opcode, 0 for a bad one */
+static const uint8_t arduino_macro_step_len[ARDUINO_MACRO_OP_MAX] = 
+{
+    0, 3, 6, 2, 3,
+};
+
+/* one file is loaded or built at a time */
+static uint8_t arduino_macro_buf[ARDUINO_MACRO_MAX_LEN];
+static struct os_mutex arduino_macro_mutex;
+
+/* 
+ * the length of the step at pos, 0 if it runs past len or names an entry 
+ * or a function outside the tables
+ */
+static int
+arduino_macro_len(const uint8_t *steps, int pos, int len)
+{
+    const uint8_t *step = steps + pos;
+    int step_len;
+
+    if (step[0] >= ARDUINO_MACRO_OP_MAX) {
+        return 0;
+    }
+    step_len = arduino_macro_step_len[step[0]];
+    if (step_len == 0 || pos + step_len > len) {
+        return 0;
+    }
+    if (step[0] != ARDUINO_MACRO_DELAY && step[1] >= ARDUINO_NUM_DEVS) {
+        return 0;
+    }
+    if (step[0] == ARDUINO_MACRO_SET && step[2] >= INTERFACE_MAX) {
+        return 0;
+    }
+    return step_len;
+}
+
+/* the function the steps so far leave entry_id in, or the one it has now */
+static int
+arduino_macro_type(const uint8_t *steps, int len, int entry_id)
+{
+    int type = interface_map[entry_id].type;
+    int step_len;
+    int pos;
+
+    for (pos = 0; pos < len; pos += step_len) {
+        step_len = arduino_macro_len(steps, pos, len);
+        if (step_len == 0) {
+            break;
+        }
+        if (steps[pos] == ARDUINO_MACRO_SET && steps[pos + 1] == entry_id) {
+            type = steps[pos + 2];
+        }
+    }
+    return type;
+}
+
+int
+arduino_test_macro_compile(int argc, char **argv, uint8_t *steps, int len,
+                           int size)
+{
+    uint8_t *step = steps + len;
+    int entry_id = -1;
+    int value;
+    int type;
+
+    if (argc < 2) {
+        return -1;
+    }
+    if (strcmp(argv[0], "delay")) {
+        entry_id = arduino_pinstr_to_entry(argv[1]);
+        if (entry_id < 0) {
+            return -1;
+        }
+    }
+
+    if (!strcmp(argv[0], "set") && argc == 3) {
+        type = arduino_devstr_to_dev(argv[2]);
+        if (type < 0 || len + 3 > size) {
+            return -1;
+        }
+        step[0] = ARDUINO_MACRO_SET;
+        step[1] = entry_id;
+        step[2] = type;
+        return len + 3;
+    }
+    if (!strcmp(argv[0], "write") && argc == 3) {
+        type = arduino_macro_type(steps, len, entry_id);
+        if (arduino_parse_value(type, argv[2], &value) || len + 6 > size) {
+            return -1;
+        }
+        step[0] = ARDUINO_MACRO_WRITE;
+        step[1] = entry_id;
+        step[2] = value;
+        step[3] = value >> 8;
+        step[4] = value >> 16;
+        step[5] = value >> 24;
+        return len + 6;
+    }
+    if (!strcmp(argv[0], "read") && argc == 2) {
+        if (len + 2 > size) {
+            return -1;
+        }
+        step[0] = ARDUINO_MACRO_READ;
+        step[1] = entry_id;
+        return len + 2;
+    }
+    if (!strcmp(argv[0], "delay") && argc == 2) {
+        if (arduino_parse_value(INTERFACE_UNINITIALIZED, argv[1], &value) ||
+            value < 0 || value > UINT16_MAX || len + 3 > size) {
+            return -1;
+        }
+        step[0] = ARDUINO_MACRO_DELAY;
+        step[1] = value;
+        step[2] = value >> 8;
+        return len + 3;
+    }
+    return -1;
+}
+
+int
+arduino_test_macro_exec(const uint8_t *steps, int len, int *failed)
+{
+    const uint8_t *step;
+    int step_len;
+    int value;
+    int pos;
+    int cnt;
+    int rc = 0;
+
+    for (pos = 0, cnt = 0; pos < len; pos += step_len, cnt++) {
+        step_len = arduino_macro_len(steps, pos, len);
+        if (step_len == 0) {
+            rc = -1;
+            break;
+        }
+        step = steps + pos;
+        switch (step[0]) {
+            case ARDUINO_MACRO_SET:
+                rc = arduino_set_device(step[1], step[2]);
+                break;
+            case ARDUINO_MACRO_WRITE:
+                value = step[2] | (step[3] << 8) | (step[4] << 16) | 
+                        ((uint32_t) step[5] << 24);
+                rc = arduino_write(step[1], value);
+                break;
+            case ARDUINO_MACRO_READ:
+                rc = arduino_read(step[1], &value, NULL);
+                break;
+            case ARDUINO_MACRO_DELAY:
+                value = step[1] | (step[2] << 8);
+                os_time_delay((value * OS_TICKS_PER_SEC + 999) / 1000);
+                break;
+        }
+        if (rc) {
+            break;
+        }
+    }
+    if (rc && failed) {
+        *failed = cnt;
+    }
+    return rc;
+}
+
+/* reads the named macro into arduino_macro_buf, returns the length of 
+ * its steps, 0 if there is none or -1 if it does not fit this build */
+static int
+arduino_macro_load(const char *path)
+{
+    uint32_t len;
+    int rc;
+
+    rc = fsutil_read_file(path, 0, sizeof(arduino_macro_buf), 
+                          arduino_macro_buf, &len);
+    if (rc == FS_ENOENT) {
+        return 0;
+    }
+    if (rc || arduino_file_hdr_check(arduino_macro_buf, len, 
+                                     ARDUINO_MACRO_KIND)) {
+        return -1;
+    }
+    return len - ARDUINO_FILE_HDR_LEN;
+}
+
+static int
+arduino_macro_add(const char *name, int argc, char **argv)
+{
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_MACRO_DIR)];
+    uint8_t *steps = arduino_macro_buf + ARDUINO_FILE_HDR_LEN;
+    int size = sizeof(arduino_macro_buf) - ARDUINO_FILE_HDR_LEN;
+    int len;
+
+    if (arduino_file_path(ARDUINO_MACRO_DIR, name, path)) {
+        return -1;
+    }
+    len = arduino_macro_load(path);
+    if (len < 0) {
+        return -2;
+    }
+    len = arduino_test_macro_compile(argc, argv, steps, len, size);
+    if (len < 0) {
+        return -3;
+    }
+
+    arduino_file_hdr_put(arduino_macro_buf, ARDUINO_MACRO_KIND);
+    /* the directory is made once, after that this fails harmlessly */
+    fs_mkdir(ARDUINO_MACRO_DIR);
+    return fsutil_write_file(path, arduino_macro_buf, 
+                             len + ARDUINO_FILE_HDR_LEN);
+}
+
+static int
+arduino_macro_run(const char *name, int *failed)
+{
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_MACRO_DIR)];
+    int len;
+
+    if (arduino_file_path(ARDUINO_MACRO_DIR, name, path)) {
+        return -1;
+    }
+    len = arduino_macro_load(path);
+    if (len <= 0) {
+        return len ? -2 : -1;
+    }
+    return arduino_test_macro_exec(arduino_macro_buf + ARDUINO_FILE_HDR_LEN,
+                                   len, failed);
+}
+
+static int
+arduino_macro_del(const char *name)
+{
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_MACRO_DIR)];
+
+    if (arduino_file_path(ARDUINO_MACRO_DIR, name, path)) {
+        return -1;
+    }
+    return fs_unlink(path);
+}
+
+static void
+arduino_macro_list(void)
+{
+    char name[ARDUINO_FILE_NAME_LEN + 1];
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_MACRO_DIR)];
+    struct fs_dir *dir;
+    struct fs_dirent *dirent;
+    uint8_t name_len;
+    int len;
+
+    if (fs_opendir(ARDUINO_MACRO_DIR, &dir)) {
+        console_printf("No macros\n");
+        return;
+    }
+    while (fs_readdir(dir, &dirent) == 0) {
+        if (fs_dirent_is_dir(dirent) ||
+            fs_dirent_name(dirent, sizeof(name), name, &name_len) ||
+            arduino_file_path(ARDUINO_MACRO_DIR, name, path)) {
+            continue;
+        }
+        len = arduino_macro_load(path);
+        if (len < 0) {
+            console_printf("%12s from another build\n", name);
+        } else {
+            console_printf("%12s %d bytes\n", name, len);
+        }
+    }
+    fs_closedir(dir);
+}
+
+int
+arduino_macro_cmd(int argc, char **argv)
+{
+    int failed = -1;
+    int rc = 0;
+    int err;
+
+    if (argc < 2) {
+        return -1;
+    }
+
+    os_mutex_pend(&arduino_macro_mutex, OS_WAIT_FOREVER);
+    if (!strcmp(argv[1], "add") && argc >= 5) {
+        err = arduino_macro_add(argv[2], argc - 3, argv + 3);
+        if (err) {
+            console_printf("Unable to add to macro %s, err=%d\n", 
+                           argv[2], err);
+        } else {
+            console_printf("Added to macro %s\n", argv[2]);
+        }
+    } else if (!strcmp(argv[1], "run") && argc == 3) {
+        err = arduino_macro_run(argv[2], &failed);
+        if (err && failed >= 0) {
+            console_printf("Unable to run macro %s, step %d, err=%d\n", 
+                           argv[2], failed, err);
+        } else if (err) {
+            console_printf("Unable to run macro %s, err=%d\n", argv[2], err);
+        } else {
+            console_printf("Ran macro %s\n", argv[2]);
+        }
+    } else if (!strcmp(argv[1], "del") && argc == 3) {
+        err = arduino_macro_del(argv[2]);
+        if (err) {
+            console_printf("Unable to delete macro %s, err=%d\n", 
+                           argv[2], err);
+        } else {
+            console_printf("Deleted macro %s\n", argv[2]);
+        }
+    } else if (!strcmp(argv[1], "list") && argc == 2) {
+        arduino_macro_list();
+    } else {
+        rc = -1;
+    }
+    os_mutex_release(&arduino_macro_mutex);
+    return rc;
+}
+
+int
+arduino_macro_init(void)
+{
+    return os_mutex_init(&arduino_macro_mutex);
+}
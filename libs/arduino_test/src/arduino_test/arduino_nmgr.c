@@ -0,0 +1,373 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <newtmgr/newtmgr.h>
+#include <json/json.h>
+#include <util/base64.h>
+#include <arduino_test/arduino_codec.h>
+#include <bsp/adc_trig.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * newtmgr access to the pins, group ARDUINO_NMGR_GROUP.
+ *
+ * read:  {"pin":"A1"} -> {"rc":0,"pin":"A1","val":512,"ts":123456}
+ *
+ * ts is the bsp_usec_get32() time the read was started at, the same
+ * clock the shell read prints.
+ *
+ * samples: {"pin":"A1","rate":1000,"cnt":64} -> {"rc":0,"data":"..."}
+ *
+ * Takes cnt conversions of an adc pin at rate Hz, data is the block in 
+ * the form of arduino_codec.h, base64 encoded.  About one byte a sample
+ * for a slow signal, where the decimal value in a read is 3 or 4.
+ *
+ * export: {"src":"log","off":0,"len":128} 
+ *      -> {"data":"...","off":0,"next":128,"end":4000,"rc":0}
+ *
+ * Returns up to len bytes of the sample log, or with "src":"ram" of the
+ * buffer given to arduino_test_export_ram(), from off on.  The bytes are
+ * base64 encoded straight from the buffer, or from a small window of the
+ * flash, into the response; the chunk is not copied first.  A transfer
+ * goes on by asking from next until it reaches end, and after a 
+ * disconnect it picks up from the last next it got.  Log offsets count
+ * from the first block ever written, so they stay valid across a reboot
+ * and while the log wraps.  If the log dropped off meanwhile, the chunk
+ * starts at the oldest byte, off says where.
+ */
+
+#define ARDUINO_NMGR_GROUP          (NMGR_GROUP_ID_PERUSER)
+#define ARDUINO_NMGR_ID_READ        (0)
+#define ARDUINO_NMGR_ID_SAMPLES     (1)
+#define ARDUINO_NMGR_ID_EXPORT      (2)
+
+#define ARDUINO_NMGR_MAX_SAMPLES    (128)
+#define ARDUINO_NMGR_MAX_RATE       (1000000 / ADC_TRIG_MIN_PERIOD)
+/* the pin stays locked for the whole block, so keep it short */
+#define ARDUINO_NMGR_MAX_USECS      (1000000)
+/* the chunk of an export, which has to fit in the newtmgr frame */
+#define ARDUINO_NMGR_EXPORT_LEN     (128)
+#define ARDUINO_NMGR_EXPORT_MAX     (256)
+/* the bytes encoded at a time, a multiple of 3 so no padding comes out */
+#define ARDUINO_NMGR_B64_IN         (48)
+
+static int arduino_nmgr_read(struct nmgr_jbuf *njb);
+static int arduino_nmgr_samples(struct nmgr_jbuf *njb);
+static int arduino_nmgr_export(struct nmgr_jbuf *njb);
+
+static const struct nmgr_handler arduino_nmgr_handlers[] = {
+    [ARDUINO_NMGR_ID_READ] = { arduino_nmgr_read, arduino_nmgr_read },
+    [ARDUINO_NMGR_ID_SAMPLES] = { arduino_nmgr_samples, 
+                                  arduino_nmgr_samples },
+    [ARDUINO_NMGR_ID_EXPORT] = { arduino_nmgr_export, arduino_nmgr_export },
+};
+
+/* the handlers all run on the newtmgr task, one at a time */
+static int16_t arduino_nmgr_buf[ARDUINO_NMGR_MAX_SAMPLES];
+static uint8_t arduino_nmgr_block[
+    ARDUINO_CODEC_MAX_LEN(ARDUINO_NMGR_MAX_SAMPLES)];
+static char arduino_nmgr_b64[BASE64_ENCODE_SIZE(sizeof(arduino_nmgr_block))];
+
+/* the "ram" source of an export */
+static const uint8_t *arduino_nmgr_ram;
+static uint32_t arduino_nmgr_ram_len;
+
+/* the data string of an export as it is written */
+struct arduino_nmgr_stream
+{
+    struct json_encoder *ans_enc;
+    uint8_t  ans_started;
+    uint8_t  ans_carry_len;
+    uint8_t  ans_carry[3];      /* bytes short of a group of 3 */
+};
+
+static struct nmgr_group arduino_nmgr_group = {
+    .ng_handlers = arduino_nmgr_handlers,
+    .ng_handlers_count = sizeof(arduino_nmgr_handlers) / 
+                         sizeof(arduino_nmgr_handlers[0]),
+    .ng_group_id = ARDUINO_NMGR_GROUP,
+};
+
+static int
+arduino_nmgr_read(struct nmgr_jbuf *njb)
+{
+    char pin[8];
+    const struct json_attr_t attrs[] = {
+        { "pin", t_string, .addr.string = pin, .len = sizeof(pin) },
+        { NULL },
+    };
+    struct json_value jv;
+    uint32_t stamp;
+    int entry_id;
+    int value;
+    int rc;
+
+    rc = json_read_object(&njb->njb_buf, attrs);
+    if (rc) {
+        rc = NMGR_ERR_EINVAL;
+        goto err;
+    }
+    entry_id = arduino_pinstr_to_entry(pin);
+    if (entry_id < 0) {
+        rc = NMGR_ERR_ENOENT;
+        goto err;
+    }
+    if (arduino_read(entry_id, &value, &stamp)) {
+        rc = NMGR_ERR_EUNKNOWN;
+        goto err;
+    }
+
+    json_encode_object_start(&njb->njb_enc);
+    JSON_VALUE_INT(&jv, NMGR_ERR_EOK);
+    json_encode_object_entry(&njb->njb_enc, "rc", &jv);
+    JSON_VALUE_STRINGN(&jv, pin, strlen(pin));
+    json_encode_object_entry(&njb->njb_enc, "pin", &jv);
+    JSON_VALUE_INT(&jv, value);
+    json_encode_object_entry(&njb->njb_enc, "val", &jv);
+    JSON_VALUE_UINT(&jv, stamp);
+    json_encode_object_entry(&njb->njb_enc, "ts", &jv);
+    json_encode_object_finish(&njb->njb_enc);
+    return 0;
+
+err:
+    nmgr_jbuf_setoerr(njb, rc);
+    return 0;
+}
+
+static int
+arduino_nmgr_samples(struct nmgr_jbuf *njb)
+{
+    char pin[8];
+    long long int rate = 0;
+    long long int cnt = 0;
+    const struct json_attr_t attrs[] = {
+        { "pin", t_string, .addr.string = pin, .len = sizeof(pin) },
+        { "rate", t_integer, .addr.integer = &rate },
+        { "cnt", t_integer, .addr.integer = &cnt },
+        { NULL },
+    };
+    struct arduino_pin_req req = { 0 };
+    struct arduino_codec_hdr hdr;
+    struct json_value jv;
+    int entry_id;
+    int len;
+    int rc;
+
+    rc = json_read_object(&njb->njb_buf, attrs);
+    if (rc || rate <= 0 || rate > ARDUINO_NMGR_MAX_RATE || cnt <= 0 || 
+        cnt > ARDUINO_NMGR_MAX_SAMPLES || 
+        (cnt - 1) * 1000000 / rate > ARDUINO_NMGR_MAX_USECS) {
+        rc = NMGR_ERR_EINVAL;
+        goto err;
+    }
+    entry_id = arduino_pinstr_to_entry(pin);
+    if (entry_id < 0) {
+        rc = NMGR_ERR_ENOENT;
+        goto err;
+    }
+
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_entry = entry_id;
+    req.apr_arg = cnt;
+    req.apr_value = 1000000 / rate;
+    req.apr_buf = arduino_nmgr_buf;
+    req.apr_type_mask = 1UL << INTERFACE_ADC;
+    if (arduino_task_call(&req)) {
+        rc = NMGR_ERR_EUNKNOWN;
+        goto err;
+    }
+
+    hdr.entry_id = entry_id;
+    hdr.cnt = cnt;
+    hdr.stamp = req.apr_stamp;
+    hdr.period = cnt > 1 ? (req.apr_value + (cnt - 1) / 2) / (cnt - 1) : 0;
+    len = arduino_codec_encode(&hdr, arduino_nmgr_buf, arduino_nmgr_block, 
+                               sizeof(arduino_nmgr_block));
+    len = base64_encode(arduino_nmgr_block, len, arduino_nmgr_b64, 1);
+
+    json_encode_object_start(&njb->njb_enc);
+    JSON_VALUE_INT(&jv, NMGR_ERR_EOK);
+    json_encode_object_entry(&njb->njb_enc, "rc", &jv);
+    JSON_VALUE_STRINGN(&jv, arduino_nmgr_b64, len);
+    json_encode_object_entry(&njb->njb_enc, "data", &jv);
+    json_encode_object_finish(&njb->njb_enc);
+    return 0;
+
+err:
+    nmgr_jbuf_setoerr(njb, rc);
+    return 0;
+}
+
+/* starts the response at the first byte, so an error found before any 
+ * data can still be returned alone */
+static void
+arduino_nmgr_stream_start(struct arduino_nmgr_stream *pas)
+{
+    if (!pas->ans_started) {
+        json_encode_object_start(pas->ans_enc);
+        json_encode_object_key(pas->ans_enc, "data");
+        pas->ans_enc->je_write(pas->ans_enc->je_arg, "\"", 1);
+        pas->ans_started = 1;
+    }
+}
+
+/* base64 encodes len bytes into the response, called with the pieces of
+ * the chunk as they are read */
+static int
+arduino_nmgr_stream_out(void *arg, const void *data, int len)
+{
+    struct arduino_nmgr_stream *pas = arg;
+    struct json_encoder *enc = pas->ans_enc;
+    const uint8_t *src = data;
+    char out[BASE64_ENCODE_SIZE(ARDUINO_NMGR_B64_IN)];
+    int cnt;
+
+    arduino_nmgr_stream_start(pas);
+
+    /* complete the group the last piece left open */
+    while (pas->ans_carry_len && len) {
+        pas->ans_carry[pas->ans_carry_len++] = *src++;
+        len--;
+        if (pas->ans_carry_len == sizeof(pas->ans_carry)) {
+            cnt = base64_encode(pas->ans_carry, sizeof(pas->ans_carry), 
+                                out, 0);
+            enc->je_write(enc->je_arg, out, cnt);
+            pas->ans_carry_len = 0;
+        }
+    }
+
+    while (len >= 3) {
+        cnt = len < ARDUINO_NMGR_B64_IN ? len - len % 3 : ARDUINO_NMGR_B64_IN;
+        enc->je_write(enc->je_arg, out, base64_encode(src, cnt, out, 0));
+        src += cnt;
+        len -= cnt;
+    }
+
+    memcpy(pas->ans_carry, src, len);
+    pas->ans_carry_len = len;
+    return 0;
+}
+
+static void
+arduino_nmgr_stream_finish(struct arduino_nmgr_stream *pas)
+{
+    struct json_encoder *enc = pas->ans_enc;
+    char out[BASE64_ENCODE_SIZE(sizeof(pas->ans_carry))];
+    int cnt;
+
+    arduino_nmgr_stream_start(pas);
+    if (pas->ans_carry_len) {
+        cnt = base64_encode(pas->ans_carry, pas->ans_carry_len, out, 1);
+        enc->je_write(enc->je_arg, out, cnt);
+    }
+    enc->je_write(enc->je_arg, "\"", 1);
+    enc->je_wr_commas = 1;
+}
+
+static int
+arduino_nmgr_export(struct nmgr_jbuf *njb)
+{
+    char src[8];
+    long long unsigned int off = 0;
+    long long int len = 0;
+    const struct json_attr_t attrs[] = {
+        { "src", t_string, .addr.string = src, .len = sizeof(src) },
+        { "off", t_uinteger, .addr.uinteger = &off },
+        { "len", t_integer, .addr.integer = &len },
+        { NULL },
+    };
+    struct arduino_nmgr_stream as = { .ans_enc = &njb->njb_enc };
+    const uint8_t *ram;
+    struct json_value jv;
+    uint32_t start;
+    uint32_t end;
+    os_sr_t sr;
+    int rc;
+
+    strcpy(src, "log");
+    rc = json_read_object(&njb->njb_buf, attrs);
+    if (rc || len < 0 || len > ARDUINO_NMGR_EXPORT_MAX || 
+        off > UINT32_MAX) {
+        rc = NMGR_ERR_EINVAL;
+        goto err;
+    }
+    if (!len) {
+        len = ARDUINO_NMGR_EXPORT_LEN;
+    }
+    start = off;
+
+    if (!strcmp(src, "log")) {
+        rc = arduino_log_export(&start, len, &end, arduino_nmgr_stream_out,
+                                &as);
+    } else if (!strcmp(src, "ram")) {
+        OS_ENTER_CRITICAL(sr);
+        ram = arduino_nmgr_ram;
+        end = arduino_nmgr_ram_len;
+        OS_EXIT_CRITICAL(sr);
+        if (!ram || start > end) {
+            rc = -1;
+        } else {
+            rc = end - start < len ? end - start : len;
+            arduino_nmgr_stream_out(&as, ram + start, rc);
+        }
+    } else {
+        rc = NMGR_ERR_ENOENT;
+        goto err;
+    }
+    if (rc < 0 && !as.ans_started) {
+        rc = NMGR_ERR_EINVAL;
+        goto err;
+    }
+
+    /* a read that failed half way still has to close what it started */
+    arduino_nmgr_stream_finish(&as);
+    JSON_VALUE_UINT(&jv, start);
+    json_encode_object_entry(&njb->njb_enc, "off", &jv);
+    JSON_VALUE_UINT(&jv, start + (rc < 0 ? 0 : rc));
+    json_encode_object_entry(&njb->njb_enc, "next", &jv);
+    JSON_VALUE_UINT(&jv, end);
+    json_encode_object_entry(&njb->njb_enc, "end", &jv);
+    JSON_VALUE_INT(&jv, rc < 0 ? NMGR_ERR_EUNKNOWN : NMGR_ERR_EOK);
+    json_encode_object_entry(&njb->njb_enc, "rc", &jv);
+    json_encode_object_finish(&njb->njb_enc);
+    return 0;
+
+err:
+    nmgr_jbuf_setoerr(njb, rc);
+    return 0;
+}
+
+void
+arduino_test_export_ram(const void *buf, uint32_t len)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    arduino_nmgr_ram = buf;
+    arduino_nmgr_ram_len = buf ? len : 0;
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+arduino_nmgr_init(void)
+{
+    return nmgr_group_register(&arduino_nmgr_group);
+}
@@ -0,0 +1,238 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <console/console.h>
+#include <fs/fs.h>
+#include <fs/fsutil.h>
+#include <bsp/bsp_usec.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Profiles are whole board setups stored in NFFS under ARDUINO_PROFILE_DIR,
+ * the function and value of every pin in pin_map[].  Loading one checks
+ * all of it before any pin is touched and then applies it in a single 
+ * request to the I/O task with every pin locked, see arduino_set_all().
+ * Pins that already have their setup are left alone, so switching between
+ * two fixtures only glitches the pins that differ.
+ *
+ * The file is a header like that of a macro and 5 bytes per pin, the 
+ * type and the value little endian.
+ */
+
+#define ARDUINO_PROFILE_DIR         "/profile"
+#define ARDUINO_PROFILE_KIND        ('P')
+#define ARDUINO_PROFILE_PIN_LEN     (5)
+#define ARDUINO_PROFILE_LEN         (ARDUINO_FILE_HDR_LEN + \
+                                     ARDUINO_NUM_DEVS * ARDUINO_PROFILE_PIN_LEN)
+
+static uint8_t arduino_profile_buf[ARDUINO_PROFILE_LEN];
+static struct arduino_conf_pin arduino_profile_pins[ARDUINO_NUM_DEVS];
+static struct os_mutex arduino_profile_mutex;
+
+static int
+arduino_profile_save(const char *name)
+{
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_PROFILE_DIR)];
+    struct arduino_conf_pin cp;
+    uint8_t *pin = arduino_profile_buf + ARDUINO_FILE_HDR_LEN;
+    int entry_id;
+
+    if (arduino_file_path(ARDUINO_PROFILE_DIR, name, path)) {
+        return -1;
+    }
+    arduino_file_hdr_put(arduino_profile_buf, ARDUINO_PROFILE_KIND);
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        arduino_conf_current(entry_id, &cp);
+        pin[0] = cp.type;
+        pin[1] = cp.value;
+        pin[2] = cp.value >> 8;
+        pin[3] = cp.value >> 16;
+        pin[4] = cp.value >> 24;
+        pin += ARDUINO_PROFILE_PIN_LEN;
+    }
+    /* the directory is made once, after that this fails harmlessly */
+    fs_mkdir(ARDUINO_PROFILE_DIR);
+    return fsutil_write_file(path, arduino_profile_buf, ARDUINO_PROFILE_LEN);
+}
+
+/* reads the named profile into arduino_profile_pins and checks every 
+ * pin of it, returns -1 if there is none, -2 if it does not fit this 
+ * build and -3 if a pin has a bad function or value */
+static int
+arduino_profile_read(const char *path)
+{
+    const uint8_t *pin = arduino_profile_buf + ARDUINO_FILE_HDR_LEN;
+    struct arduino_conf_pin *pcp;
+    uint32_t len;
+    int entry_id;
+    int rc;
+
+    rc = fsutil_read_file(path, 0, sizeof(arduino_profile_buf), 
+                          arduino_profile_buf, &len);
+    if (rc) {
+        return -1;
+    }
+    if (len != ARDUINO_PROFILE_LEN || 
+        arduino_file_hdr_check(arduino_profile_buf, len, 
+                               ARDUINO_PROFILE_KIND)) {
+        return -2;
+    }
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        pcp = &arduino_profile_pins[entry_id];
+        pcp->type = pin[0];
+        pcp->value = pin[1] | (pin[2] << 8) | (pin[3] << 16) | 
+                     ((uint32_t) pin[4] << 24);
+        if (pcp->type >= INTERFACE_MAX) {
+            return -3;
+        }
+        if (arduino_conf_has_value(pcp->type)) {
+            if (!arduino_value_in_range(pcp->type, pcp->value)) {
+                return -3;
+            }
+        } else if (pcp->value) {
+            return -3;
+        }
+        pin += ARDUINO_PROFILE_PIN_LEN;
+    }
+    return 0;
+}
+
+static int
+arduino_profile_load(const char *name, int *changed, uint32_t *usecs)
+{
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_PROFILE_DIR)];
+    uint32_t start;
+    int rc;
+
+    if (arduino_file_path(ARDUINO_PROFILE_DIR, name, path)) {
+        return -1;
+    }
+    rc = arduino_profile_read(path);
+    if (rc) {
+        return rc;
+    }
+    start = bsp_usec_get32();
+    rc = arduino_set_all(arduino_profile_pins, changed);
+    *usecs = bsp_usec_get32() - start;
+    return rc ? -4 : 0;
+}
+
+static int
+arduino_profile_del(const char *name)
+{
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_PROFILE_DIR)];
+
+    if (arduino_file_path(ARDUINO_PROFILE_DIR, name, path)) {
+        return -1;
+    }
+    return fs_unlink(path);
+}
+
+static void
+arduino_profile_list(void)
+{
+    char name[ARDUINO_FILE_NAME_LEN + 1];
+    char path[ARDUINO_FILE_PATH_LEN(ARDUINO_PROFILE_DIR)];
+    struct fs_dir *dir;
+    struct fs_dirent *dirent;
+    uint8_t name_len;
+    int used;
+    int rc;
+    int i;
+
+    if (fs_opendir(ARDUINO_PROFILE_DIR, &dir)) {
+        console_printf("No profiles\n");
+        return;
+    }
+    while (fs_readdir(dir, &dirent) == 0) {
+        if (fs_dirent_is_dir(dirent) ||
+            fs_dirent_name(dirent, sizeof(name), name, &name_len) ||
+            arduino_file_path(ARDUINO_PROFILE_DIR, name, path)) {
+            continue;
+        }
+        rc = arduino_profile_read(path);
+        if (rc) {
+            console_printf("%12s %s\n", name, 
+                           rc == -2 ? "from another build" : "damaged");
+            continue;
+        }
+        used = 0;
+        for (i = 0; i < ARDUINO_NUM_DEVS; i++) {
+            if (arduino_profile_pins[i].type != INTERFACE_UNINITIALIZED) {
+                used++;
+            }
+        }
+        console_printf("%12s %d pins used\n", name, used);
+    }
+    fs_closedir(dir);
+}
+
+int
+arduino_profile_cmd(int argc, char **argv)
+{
+    uint32_t usecs;
+    int changed = 0;
+    int rc = 0;
+    int err;
+
+    if (argc < 2) {
+        return -1;
+    }
+
+    os_mutex_pend(&arduino_profile_mutex, OS_WAIT_FOREVER);
+    if (!strcmp(argv[1], "save") && argc == 3) {
+        err = arduino_profile_save(argv[2]);
+        if (err) {
+            console_printf("Unable to save profile %s, err=%d\n", 
+                           argv[2], err);
+        } else {
+            console_printf("Saved profile %s\n", argv[2]);
+        }
+    } else if (!strcmp(argv[1], "load") && argc == 3) {
+        err = arduino_profile_load(argv[2], &changed, &usecs);
+        if (err) {
+            console_printf("Unable to load profile %s, err=%d\n", 
+                           argv[2], err);
+        } else {
+            console_printf("Loaded profile %s, %d pins changed in %lu us\n",
+                           argv[2], changed, (unsigned long) usecs);
+        }
+    } else if (!strcmp(argv[1], "del") && argc == 3) {
+        err = arduino_profile_del(argv[2]);
+        if (err) {
+            console_printf("Unable to delete profile %s, err=%d\n", 
+                           argv[2], err);
+        } else {
+            console_printf("Deleted profile %s\n", argv[2]);
+        }
+    } else if (!strcmp(argv[1], "list") && argc == 2) {
+        arduino_profile_list();
+    } else {
+        rc = -1;
+    }
+    os_mutex_release(&arduino_profile_mutex);
+    return rc;
+}
+
+int
+arduino_profile_init(void)
+{
+    return os_mutex_init(&arduino_profile_mutex);
+}
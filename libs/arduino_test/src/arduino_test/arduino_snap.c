@@ -0,0 +1,102 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <console/console.h>
+#include <arduino_test/arduino_codec.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+static void
+arduino_snap_print(const struct arduino_codec_snapshot *ps, 
+                   const uint8_t *rec, int len)
+{
+    int entry_id;
+    int i;
+
+    console_printf("Snapshot at %lu us, %d bytes\n", 
+                   (unsigned long) ps->stamp, len);
+    if (ps->gpio_mask) {
+        console_printf("  gpio");
+        for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+            if (ps->gpio_mask & (1UL << entry_id)) {
+                console_printf(" %s=%d", pin_map[entry_id].name, 
+                               (ps->gpio_levels >> entry_id) & 1);
+            }
+        }
+        console_printf("\n");
+    }
+    if (ps->adc_mask) {
+        console_printf("  adc %+ld us%s", (long) ps->adc_delta, 
+                       (ps->flags & ARDUINO_CODEC_SNAP_ONE_PASS) ? 
+                       ", one pass," : ",");
+        i = 0;
+        for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+            if (ps->adc_mask & (1UL << entry_id)) {
+                console_printf(" %s=%u", pin_map[entry_id].name, 
+                               ps->adc[i++]);
+            }
+        }
+        console_printf("\n");
+    }
+    if (ps->flags & ARDUINO_CODEC_SNAP_ADC_BUSY) {
+        console_printf("  adc pins left out, the ADC is busy\n");
+    }
+    /* the record as a host gets it */
+    for (i = 0; i < len; i++) {
+        console_printf("%s%02x", (i % 16) ? " " : "  ", rec[i]);
+        if (i % 16 == 15 || i + 1 == len) {
+            console_printf("\n");
+        }
+    }
+}
+
+int
+arduino_snap_cmd(int argc, char **argv)
+{
+    struct arduino_codec_snapshot snap;
+    uint8_t rec[ARDUINO_CODEC_SNAPSHOT_MAX];
+    int len;
+    int rc;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "log"))) {
+        return -1;
+    }
+    rc = arduino_snapshot(&snap);
+    if (rc) {
+        console_printf("Unable to take a snapshot, err=%d\n", rc);
+        return 0;
+    }
+    len = arduino_codec_encode_snapshot(&snap, rec, sizeof(rec));
+    if (len < 0) {
+        console_printf("Unable to encode the snapshot\n");
+        return 0;
+    }
+    arduino_snap_print(&snap, rec, len);
+    if (argc == 2) {
+        rc = arduino_test_log_append(rec, len);
+        if (rc == 0) {
+            rc = arduino_test_log_flush();
+        }
+        if (rc) {
+            console_printf("Unable to log the snapshot, err=%d\n", rc);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <console/console.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_trig.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Spectral lines of an adc pin by the Goertzel algorithm.  A block of
+ * conversions is taken at a fixed rate and only the amplitude at each
+ * requested frequency is printed, a few numbers instead of the samples.
+ * Each bin is one multiply and two adds per sample in 32 bits with a 64
+ * bit product; the cosine comes from a table, not from floating point.
+ */
+
+#define ARDUINO_SPEC_MIN_CNT    (16)
+#define ARDUINO_SPEC_MAX_CNT    (256)
+#define ARDUINO_SPEC_MAX_BINS   (8)
+#define ARDUINO_SPEC_MAX_RATE   (1000000 / ADC_TRIG_MIN_PERIOD)
+/* the pin stays locked for the whole block, so keep it short */
+#define ARDUINO_SPEC_MAX_USECS  (2000000)
+
+/* the first quarter of a sine in Q15, 64 steps */
+static const int16_t arduino_sin_q15[65] = 
+{
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+static int16_t arduino_spec_buf[ARDUINO_SPEC_MAX_CNT];
+static struct os_mutex arduino_spec_mutex;
+
+/* sine of a phase where 2^32 is a full turn, interpolated in the table */
+static int32_t
+arduino_sin(uint32_t phase)
+{
+    int quadrant = phase >> 30;
+    int idx = (phase >> 24) & 0x3f;
+    int frac = (phase >> 16) & 0xff;
+    int32_t a;
+    int32_t b;
+
+    if (quadrant & 1) {
+        a = arduino_sin_q15[64 - idx];
+        b = arduino_sin_q15[63 - idx];
+    } else {
+        a = arduino_sin_q15[idx];
+        b = arduino_sin_q15[idx + 1];
+    }
+    a += ((b - a) * frac) >> 8;
+    return (quadrant & 2) ? -a : a;
+}
+
+static uint32_t
+arduino_isqrt64(uint64_t value)
+{
+    uint64_t bit = (uint64_t) 1 << 62;
+    uint64_t root = 0;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+int32_t
+arduino_test_goertzel(const int16_t *samples, int cnt, uint32_t freq, 
+                      uint32_t rate)
+{
+    uint32_t phase;
+    int32_t coeff;
+    int32_t s0;
+    int32_t s1 = 0;
+    int32_t s2 = 0;
+    int64_t power;
+    int shift = 0;
+    int i;
+
+    if (cnt < 2 || (cnt & (cnt - 1)) || rate == 0 || freq >= rate) {
+        return -1;
+    }
+    while ((1 << shift) < cnt) {
+        shift++;
+    }
+
+    /* 2 cos(2 pi freq / rate) in Q14 is the cosine in Q15 */
+    phase = ((uint64_t) freq << 32) / rate;
+    coeff = arduino_sin(phase + 0x40000000);
+
+    for (i = 0; i < cnt; i++) {
+        s0 = samples[i] + (int32_t) (((int64_t) coeff * s1) >> 14) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    power = (int64_t) s1 * s1 + (int64_t) s2 * s2 - 
+            (((int64_t) coeff * s1) >> 14) * s2;
+    if (power < 0) {
+        power = 0;
+    }
+    /* the bin of a sine with amplitude A is A * cnt / 2 */
+    return (arduino_isqrt64(power) << 1) >> shift;
+}
+
+int
+arduino_spectrum_cmd(int argc, char **argv)
+{
+    struct arduino_pin_req req = { 0 };
+    interfaces_t pin;
+    uint32_t freqs[ARDUINO_SPEC_MAX_BINS];
+    int32_t amps[ARDUINO_SPEC_MAX_BINS];
+    uint32_t rate;
+    uint32_t start;
+    uint32_t usecs;
+    int32_t sum = 0;
+    int32_t mean;
+    int entry_id;
+    int nbins;
+    int shift = 0;
+    int cnt;
+    int rc;
+    int i;
+
+    /* spectrum <pin> <rate> <samples> <freq> ... */
+    nbins = argc - 4;
+    if (nbins < 1 || nbins > ARDUINO_SPEC_MAX_BINS) {
+        return -1;
+    }
+    entry_id = arduino_pinstr_to_entry(argv[1]);
+    rate = strtoul(argv[2], NULL, 0);
+    cnt = atoi(argv[3]);
+    if (entry_id < 0 || rate == 0 || rate > ARDUINO_SPEC_MAX_RATE ||
+        cnt < ARDUINO_SPEC_MIN_CNT || cnt > ARDUINO_SPEC_MAX_CNT || 
+        (cnt & (cnt - 1)) ||
+        (uint64_t) (cnt - 1) * 1000000 / rate > ARDUINO_SPEC_MAX_USECS) {
+        return -1;
+    }
+    for (i = 0; i < nbins; i++) {
+        freqs[i] = strtoul(argv[4 + i], NULL, 0);
+        if (freqs[i] == 0 || freqs[i] >= rate / 2) {
+            return -1;
+        }
+    }
+    while ((1 << shift) < cnt) {
+        shift++;
+    }
+
+    os_mutex_pend(&arduino_spec_mutex, OS_WAIT_FOREVER);
+    /* the export would read the block while it is overwritten */
+    arduino_test_export_ram(NULL, 0);
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_entry = entry_id;
+    req.apr_arg = cnt;
+    req.apr_value = 1000000 / rate;
+    req.apr_buf = arduino_spec_buf;
+    req.apr_type_mask = 1UL << INTERFACE_ADC;
+    req.apr_snap = &pin;
+    rc = arduino_task_call(&req);
+    if (rc) {
+        os_mutex_release(&arduino_spec_mutex);
+        console_printf("Unable to sample %s, err=%d\n", argv[1], rc);
+        return 0;
+    }
+
+    /* the rate the conversions actually ran at */
+    usecs = req.apr_value;
+    if (usecs) {
+        rate = ((uint64_t) (cnt - 1) * 1000000 + usecs / 2) / usecs;
+    }
+
+    start = bsp_usec_get32();
+    for (i = 0; i < cnt; i++) {
+        sum += arduino_spec_buf[i];
+    }
+    mean = sum >> shift;
+    for (i = 0; i < cnt; i++) {
+        arduino_spec_buf[i] -= mean;
+    }
+    for (i = 0; i < nbins; i++) {
+        amps[i] = arduino_test_goertzel(arduino_spec_buf, cnt, freqs[i], 
+                                        rate);
+    }
+    usecs = bsp_usec_get32() - start;
+
+    /* put the block back as read, newtmgr can export it until the next 
+     * run */
+    for (i = 0; i < cnt; i++) {
+        arduino_spec_buf[i] += mean;
+    }
+    arduino_test_export_ram(arduino_spec_buf, cnt * sizeof(int16_t));
+    os_mutex_release(&arduino_spec_mutex);
+
+    console_printf("Spectrum of %s, %d samples at %lu Hz, mean %ld, "
+                   "computed in %lu us\n", argv[1], cnt, (unsigned long) rate, 
+                   (long) mean, (unsigned long) usecs);
+    for (i = 0; i < nbins; i++) {
+        console_printf("  %6lu Hz %6ld (%lu mV)\n", (unsigned long) freqs[i], 
+                (long) amps[i],
+                (unsigned long) (((uint32_t) amps[i] * pin.scale) >> 
+                                 pin.shift));
+    }
+    return 0;
+}
+
+int
+arduino_spectrum_init(void)
+{
+    return os_mutex_init(&arduino_spec_mutex);
+}
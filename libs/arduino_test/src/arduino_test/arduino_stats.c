@@ -0,0 +1,211 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <stats/stats.h>
+#include <bsp/bsp_usec.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * One stats section per interface type so `stat arduino_adc` etc. shows
+ * how each kind of pin is doing. The latency histogram has fixed 
+ * buckets spaced by a factor of 4, counting the time spent in the 
+ * HAL for every set, read and write on that interface type.
+ */
+STATS_SECT_START(arduino_stats)
+    STATS_SECT_ENTRY(set)
+    STATS_SECT_ENTRY(read)
+    STATS_SECT_ENTRY(write)
+    STATS_SECT_ENTRY(errors)
+    STATS_SECT_ENTRY(bus_bytes)
+    STATS_SECT_ENTRY(lat_lt_4us)
+    STATS_SECT_ENTRY(lat_lt_16us)
+    STATS_SECT_ENTRY(lat_lt_64us)
+    STATS_SECT_ENTRY(lat_lt_256us)
+    STATS_SECT_ENTRY(lat_lt_1ms)
+    STATS_SECT_ENTRY(lat_lt_4ms)
+    STATS_SECT_ENTRY(lat_ge_4ms)
+STATS_SECT_END
+
+STATS_NAME_START(arduino_stats)
+    STATS_NAME(arduino_stats, set)
+    STATS_NAME(arduino_stats, read)
+    STATS_NAME(arduino_stats, write)
+    STATS_NAME(arduino_stats, errors)
+    STATS_NAME(arduino_stats, bus_bytes)
+    STATS_NAME(arduino_stats, lat_lt_4us)
+    STATS_NAME(arduino_stats, lat_lt_16us)
+    STATS_NAME(arduino_stats, lat_lt_64us)
+    STATS_NAME(arduino_stats, lat_lt_256us)
+    STATS_NAME(arduino_stats, lat_lt_1ms)
+    STATS_NAME(arduino_stats, lat_lt_4ms)
+    STATS_NAME(arduino_stats, lat_ge_4ms)
+STATS_NAME_END(arduino_stats)
+
+#define ARDUINO_STATS_LAT_BUCKETS   (7)
+
+static STATS_SECT_DECL(arduino_stats) arduino_stats[INTERFACE_MAX];
+
+/* the stats names must stay around after registration */
+static char * const arduino_stats_names[INTERFACE_MAX] =
+{
+    "arduino_none",
+    "arduino_gpio_out",
+    "arduino_gpio_in",
+    "arduino_adc",
+    "arduino_dac",
+    "arduino_pwm_duty",
+    "arduino_pwm_freq",
+    "arduino_spi",
+    "arduino_i2c",
+    "arduino_adc_window",
+    "arduino_ac",
+    "arduino_uart",
+    "arduino_adc_scan",
+};
+
+int
+arduino_stats_init(void)
+{
+    int i;
+    int rc;
+
+    for (i = 0; i < INTERFACE_MAX; i++) {
+        rc = stats_init(STATS_HDR(arduino_stats[i]),
+                        STATS_SIZE_INIT_PARMS(arduino_stats[i], STATS_SIZE_32),
+                        STATS_NAME_INIT_PARMS(arduino_stats));
+        if (rc) {
+            return rc;
+        }
+        rc = stats_register(arduino_stats_names[i], 
+                            STATS_HDR(arduino_stats[i]));
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+uint32_t
+arduino_stats_start(void)
+{
+    return bsp_usec_get32();
+}
+
+void
+arduino_stats_record(int type, int op, uint32_t start, int rc, int bus_bytes)
+{
+    STATS_SECT_DECL(arduino_stats) *pstats;
+    uint32_t usecs;
+    int bucket;
+
+    if (type < 0 || type >= INTERFACE_MAX) {
+        return;
+    }
+    pstats = &arduino_stats[type];
+    
+    usecs = bsp_usec_get32() - start;
+    
+    switch (op) {
+        case ARDUINO_OP_SET:
+            STATS_INC(*pstats, set);
+            break;
+        case ARDUINO_OP_READ:
+            STATS_INC(*pstats, read);
+            break;
+        case ARDUINO_OP_WRITE:
+            STATS_INC(*pstats, write);
+            break;
+        default:
+            break;
+    }
+
+    if (rc) {
+        STATS_INC(*pstats, errors);
+    } else if (bus_bytes) {
+        STATS_INCN(*pstats, bus_bytes, bus_bytes);
+    }
+
+    /* buckets are powers of 4 starting at 4 usecs, no divide needed */
+    usecs >>= 2;
+    for (bucket = 0; usecs && bucket < ARDUINO_STATS_LAT_BUCKETS - 1; 
+         bucket++) {
+        usecs >>= 2;
+    }
+    switch (bucket) {
+        case 0:
+            STATS_INC(*pstats, lat_lt_4us);
+            break;
+        case 1:
+            STATS_INC(*pstats, lat_lt_16us);
+            break;
+        case 2:
+            STATS_INC(*pstats, lat_lt_64us);
+            break;
+        case 3:
+            STATS_INC(*pstats, lat_lt_256us);
+            break;
+        case 4:
+            STATS_INC(*pstats, lat_lt_1ms);
+            break;
+        case 5:
+            STATS_INC(*pstats, lat_lt_4ms);
+            break;
+        default:
+            STATS_INC(*pstats, lat_ge_4ms);
+            break;
+    }
+}
+
+#ifdef ARDUINO_TEST_PROFILE
+static uint32_t arduino_prof_usecs[ARDUINO_PHASE_MAX];
+static uint32_t arduino_prof_last;
+static int arduino_prof_phase;
+
+int
+arduino_prof_switch(int phase)
+{
+    uint32_t now = bsp_usec_get32();
+    int prev = arduino_prof_phase;
+
+    arduino_prof_usecs[prev] += now - arduino_prof_last;
+    arduino_prof_last = now;
+    arduino_prof_phase = phase;
+    return prev;
+}
+
+void
+arduino_test_prof_reset(void)
+{
+    memset(arduino_prof_usecs, 0, sizeof(arduino_prof_usecs));
+    arduino_prof_last = bsp_usec_get32();
+}
+
+uint32_t
+arduino_test_prof_usecs(int phase)
+{
+    if (phase < 0 || phase >= ARDUINO_PHASE_MAX) {
+        return 0;
+    }
+    /* charge the time up to now to the current phase */
+    arduino_prof_switch(arduino_prof_phase);
+    return arduino_prof_usecs[phase];
+}
+#endif
@@ -0,0 +1,118 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <string.h>
+#include "arduino_test_priv.h"
+
+/* 
+ * Pin operations run on a small high priority task owned by this 
+ * library.  The shell and newtmgr only queue a request and sleep until
+ * it is done, so the timing of the HAL calls does not depend on how 
+ * fast the console drains.  Until the task is started, and for calls
+ * made from the task itself, requests run in the caller.
+ */
+
+#define ARDUINO_TASK_EV_REQ     (OS_EVENT_T_PERUSER)
+
+struct arduino_task_req
+{
+    struct os_event atr_ev;
+    struct os_sem   atr_done;
+    struct arduino_pin_req *atr_pin;
+    int             atr_rc;
+};
+
+static struct os_task arduino_task;
+static struct os_eventq arduino_task_evq;
+static int arduino_task_running;
+
+int
+arduino_task_call(struct arduino_pin_req *req)
+{
+    struct arduino_task_req treq;
+    int rc;
+
+    if (!arduino_task_running || !os_started() ||
+        os_sched_get_current_task() == &arduino_task) {
+        return arduino_pin_exec(req);
+    }
+    /* reading a scanned adc is a memory load, not worth a task switch.
+     * The type is checked again under the pin lock */
+    if (req->apr_op == ARDUINO_OP_READ && !req->apr_buf && 
+        req->apr_entry >= 0 && req->apr_entry < ARDUINO_NUM_DEVS &&
+        interface_map[req->apr_entry].type == INTERFACE_ADC_SCAN) {
+        return arduino_pin_exec(req);
+    }
+    /* a paced block read sleeps until the trigger has filled it, the 
+     * task stays free for the other pins meanwhile.  The ADC is claimed
+     * for it, so HAL reads of other pins on the task cannot interleave.
+     * A back to back block goes through the HAL and stays on the task */
+    if (req->apr_op == ARDUINO_OP_READ && req->apr_buf && req->apr_value) {
+        return arduino_pin_exec(req);
+    }
+
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_HAL);
+    memset(&treq, 0, sizeof(treq));
+    treq.atr_ev.ev_type = ARDUINO_TASK_EV_REQ;
+    treq.atr_ev.ev_arg = &treq;
+    treq.atr_pin = req;
+    os_sem_init(&treq.atr_done, 0);
+
+    os_eventq_put(&arduino_task_evq, &treq.atr_ev);
+    os_sem_pend(&treq.atr_done, OS_WAIT_FOREVER);
+    rc = treq.atr_rc;
+    ARDUINO_PROF_EXIT();
+    return rc;
+}
+
+static void
+arduino_task_handler(void *arg)
+{
+    struct arduino_task_req *treq;
+    struct os_event *ev;
+
+    while (1) {
+        ev = os_eventq_get(&arduino_task_evq);
+        switch (ev->ev_type) {
+            case ARDUINO_TASK_EV_REQ:
+                treq = ev->ev_arg;
+                treq->atr_rc = arduino_pin_exec(treq->atr_pin);
+                os_sem_release(&treq->atr_done);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int
+arduino_test_task_init(uint8_t prio, os_stack_t *stack, uint16_t stack_size)
+{
+    int rc;
+
+    os_eventq_init(&arduino_task_evq);
+    rc = os_task_init(&arduino_task, "arduino", arduino_task_handler, NULL,
+                      prio, OS_WAIT_FOREVER, stack, stack_size);
+    if (rc) {
+        return rc;
+    }
+    arduino_task_running = 1;
+    return 0;
+}
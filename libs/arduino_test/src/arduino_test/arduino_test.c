@@ -20,28 +20,31 @@
 #include <os/os.h>
 #include <console/console.h>
 #include <arduino_test/arduino_test.h>
+#include <arduino_test/arduino_codec.h>
 #include <hal/hal_adc.h>
 #include <hal/hal_pwm.h>
 #include <hal/hal_gpio.h>
 #include <hal/hal_dac.h>
 #include <hal/hal_spi.h>
 #include <hal/hal_i2c.h>
+#include <bsp/bsp.h>
+#include <bsp/bsp_usec.h>
+#include <bsp/adc_window.h>
+#include <bsp/adc_scan.h>
+#include <bsp/adc_trig.h>
+#include <bsp/pin_snap.h>
+#include <bsp/acmp.h>
+#include <bsp/uart_dma.h>
 #include <shell/shell.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
-
-struct arduino_pin_map_entry 
-{
-    char     *name;
-    uint8_t   sysid;
-    uint8_t   entry_id;
-    char     *desc;
-};
+#include "arduino_test_priv.h"
 
 /* maps the pin names to the sys id and to an index to reference dynamic data */
-static const struct arduino_pin_map_entry 
-pin_map[] = 
+const struct arduino_pin_map_entry 
+pin_map[ARDUINO_NUM_DEVS] = 
 {
     {"A0", SODAQ_AUTONOMO_A0, 0, "Analog/Digital Port Pin A0"},
     {"A1", SODAQ_AUTONOMO_A1, 1, "Analog/Digital Port Pin A1"},
@@ -64,67 +67,39 @@ pin_map[] =
     {"SPI0", SODAQ_AUTONOMO_SPI_ICSP, 18, "SPI port on 6-pin SPI connector"},
     {"SPI1", SODAQ_AUTONOMO_SPI_ALT, 19, "SPI port on A3-MOSI,A4-CLK,D9-MISO"},
     {"I2C", SODAQ_AUTONOMO_I2C, 20, "I2C Port on SCL and SDA"},
+    {"BEE", SODAQ_AUTONOMO_BEE_UART, 21, "UART on the Bee socket"},
 };
 
-#define ARDUINO_NUM_DEVS  (sizeof(pin_map)/sizeof(struct arduino_pin_map_entry))
-
-/* the types of things we can configure this to */
-enum interface_type
-{
-    INTERFACE_UNINITIALIZED = 0,
-    INTERFACE_GPIO_OUT,
-    INTERFACE_GPIO_IN,
-    INTERFACE_ADC,
-    INTERFACE_DAC,
-    INTERFACE_PWM_DUTY,
-    INTERFACE_PWM_FREQ,
-    INTERFACE_SPI,
-    INTERFACE_I2C,
-};
-
-typedef struct 
-{
-    char    *name;
-    uint8_t  entry_id;
-    int      min_value;
-    int      max_value;
-    char *  desc; 
-} interface_into_t;
-
-const interface_into_t interface_info[] =
+const interface_into_t interface_info[INTERFACE_MAX] =
 {
     {"none",     INTERFACE_UNINITIALIZED, 0, -1,     "Unused Pin"},
     {"gpio_out", INTERFACE_GPIO_OUT,      0, 1,      "Binary Output Port"},
     {"gpio_in",  INTERFACE_GPIO_IN,       0, -1,     "Binary Input Port"},
-    {"adc",      INTERFACE_ADC,           0, -1,     "Analog to Digital Input"},
+    {"adc",      INTERFACE_ADC,           0, ARDUINO_FILTER_VALUE_MAX,
+                                            "Analog to Digital Input"},
     {"dac",      INTERFACE_DAC,           0, 2048,   "Digital to Analog Output"},
     {"pwm_duty", INTERFACE_PWM_DUTY,      0, 65535,  "Pulse Width Mod. by Duty Cycle" },
     {"pwm_freq", INTERFACE_PWM_FREQ,      60, 10000, "PWM as Frequency Generator" },
     {"spi",      INTERFACE_SPI,           0, 255,    "8-bit SPI" },
     {"i2c",      INTERFACE_I2C,           0, 255,    "8-bit I2C" },
+    {"adc_window", INTERFACE_ADC_WINDOW,  0, ADC_WINDOW_MAX, 
+                                            "ADC Window Comparator Alarm" },
+    {"ac",       INTERFACE_AC,            0, ACMP_SCALE_MAX, 
+                                            "Analog Comparator" },
+    {"uart",     INTERFACE_UART,          0, 255,    "8-bit UART with DMA" },
+    {"adc_scan", INTERFACE_ADC_SCAN,      0, -1,     "ADC Scanned in Background" },
 };
 
-#define INTERFACE_CNT   (sizeof(interface_info)/sizeof(interface_into_t))
-
-/* The dynamic data that says what each pin is doing */
-typedef struct
-{
-    int type;
-    int value;
-    union
-    {
-        int    gpio_pin;
-        struct hal_adc *padc;
-        struct hal_dac *pdac;
-        struct hal_pwm *ppwm;
-        struct hal_spi *pspi;
-        struct hal_i2c *pi2c;
-        void           *pany;
-    };
-} interfaces_t;
+/* the uart function always runs at this rate */
+#define ARDUINO_UART_BAUD   (115200)
 
 /* internal state for this CPI */
-static interfaces_t interface_map[ARDUINO_NUM_DEVS];
+interfaces_t interface_map[ARDUINO_NUM_DEVS];
+
+/* one lock per pin, so clients working on different pins never wait
+ * for each other.  The output buffer has its own lock */
+static struct os_mutex arduino_pin_mutex[ARDUINO_NUM_DEVS];
+static struct os_mutex arduino_out_mutex;
 
 static int arduino_test_cli_cmd(int argc, char **argv);
 
@@ -134,29 +109,52 @@ static struct shell_cmd arduino_test_cmd_struct =
     .sc_cmd_func = arduino_test_cli_cmd
 };
 
-static int
-arduino_pinstr_to_entry(char *pinstr)
+void
+arduino_pin_lock(int entry_id)
+{
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_LOCK);
+    os_mutex_pend(&arduino_pin_mutex[entry_id], OS_WAIT_FOREVER);
+    ARDUINO_PROF_EXIT();
+}
+
+void
+arduino_pin_unlock(int entry_id)
+{
+    os_mutex_release(&arduino_pin_mutex[entry_id]);
+}
+
+int
+arduino_pinstr_to_entry(const char *pinstr)
 {
     int i;
+    int entry_id = -1;
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_LOOKUP);
 
     for (i = 0; i < ARDUINO_NUM_DEVS; i++) {
         if (strcmp(pinstr, pin_map[i].name) == 0) {
-            return pin_map[i].entry_id;
+            entry_id = pin_map[i].entry_id;
+            break;
         }
     }
-    return -1;
+    ARDUINO_PROF_EXIT();
+    return entry_id;
 }
 
-static int 
-arduino_devstr_to_dev(char *devstr)
+int 
+arduino_devstr_to_dev(const char *devstr)
 {
     int i;
-    for (i = 0; i < INTERFACE_CNT; i++) {
+    int dev = -1;
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_LOOKUP);
+
+    for (i = 0; i < INTERFACE_MAX; i++) {
         if (strcmp(devstr, interface_info[i].name) == 0) {
-            return i;
+            dev = i;
+            break;
         }
     }
-    return -1;
+    ARDUINO_PROF_EXIT();
+    return dev;
 }
 
 static int
@@ -170,6 +168,9 @@ arduino_free_device(int entry_id) {
         case INTERFACE_GPIO_OUT:
             /* just set as input */
             rc = hal_gpio_init_in(pmap->sysid, GPIO_PULL_NONE);
+            if (rc == 0) {
+                memset(pint, 0, sizeof(*pint));
+            }
             break;
         case INTERFACE_I2C:
         case INTERFACE_SPI:
@@ -177,6 +178,7 @@ arduino_free_device(int entry_id) {
         case INTERFACE_PWM_DUTY:
         case INTERFACE_PWM_FREQ:
         case INTERFACE_ADC:
+            free(pint->pfilt);
             /* TODO special code to set all pins to inputs. */
             /* This code looks a bit weird, but assumes that all the 
              * pointers are in the union and this just frees any of
@@ -184,6 +186,31 @@ arduino_free_device(int entry_id) {
             free(pint->pany);
             memset(pint,0, sizeof(*pint));
             break;
+        case INTERFACE_ADC_WINDOW:
+            rc = adc_window_stop();
+            if (rc == 0) {
+                memset(pint, 0, sizeof(*pint));
+            }
+            break;
+        case INTERFACE_AC:
+            rc = acmp_close(pint->comp);
+            if (rc == 0) {
+                memset(pint, 0, sizeof(*pint));
+            }
+            break;
+        case INTERFACE_ADC_SCAN:
+            rc = adc_scan_remove(pmap->sysid);
+            if (rc == 0) {
+                memset(pint, 0, sizeof(*pint));
+            }
+            break;
+        case INTERFACE_UART:
+            /* the port belongs to the BSP, it is only stopped */
+            rc = uart_dma_stop(pint->puart);
+            if (rc == 0) {
+                memset(pint, 0, sizeof(*pint));
+            }
+            break;
         default:
             /* nothing to do here */
             rc = 0;
@@ -192,21 +219,115 @@ arduino_free_device(int entry_id) {
     return rc;
 }
 
+/* runs in interrupt context when an adc_window value crosses its band */
+static void
+arduino_window_cb(void *arg, int value, int inside)
+{
+    int entry_id = (intptr_t) arg;
+
+    /* the monitor starts on the whole range, that is not a band */
+    if (interface_map[entry_id].value == 0) {
+        return;
+    }
+    arduino_event_post(entry_id, 
+            inside ? ARDUINO_EVENT_WINDOW_IN : ARDUINO_EVENT_WINDOW_OUT,
+            value);
+}
+
+/* runs in interrupt context when the output of an ac pin changes */
+static void
+arduino_ac_cb(void *arg, int state)
+{
+    arduino_event_post((intptr_t) arg, 
+            state ? ARDUINO_EVENT_AC_RISE : ARDUINO_EVENT_AC_FALL, state);
+}
+
+/* runs in interrupt context when a uart pin stops receiving */
+static void
+arduino_uart_cb(void *arg, int avail)
+{
+    arduino_event_post((intptr_t) arg, ARDUINO_EVENT_UART_IDLE, avail);
+}
+
+static void
+arduino_ac_cfg(int entry_id, int value, struct acmp_cfg *cfg)
+{
+    cfg->ref = ARDUINO_AC_REF(value);
+    cfg->scale = ARDUINO_AC_SCALE(value);
+    cfg->hyst = (value & ARDUINO_AC_HYST) != 0;
+    cfg->out = (value & ARDUINO_AC_EVENT) ? ACMP_OUT_EVENT : ACMP_OUT_IRQ;
+    cfg->cb = arduino_ac_cb;
+    cfg->arg = (void *)(intptr_t) entry_id;
+}
+
+/* looks up the reference and resolution of the pin once so that 
+ * converting a raw value later is a single multiply and shift */
+static void
+arduino_cache_scale(interfaces_t *pint)
+{
+    int bits = 0;
+    int ref = 0;
+
+    switch (pint->type) {
+        case INTERFACE_ADC:
+            bits = hal_adc_get_bits(pint->padc);
+            ref = hal_adc_get_ref_mv(pint->padc);
+            break;
+        case INTERFACE_ADC_SCAN:
+            bits = ADC_SCAN_BITS;
+            ref = ADC_SCAN_REF_MV;
+            break;
+        case INTERFACE_DAC:
+            bits = hal_dac_get_bits(pint->pdac);
+            ref = hal_dac_get_ref_mv(pint->pdac);
+            break;
+        case INTERFACE_PWM_DUTY:
+            /* duty cycle is a 16-bit fraction, report it in percent */
+            bits = 16;
+            ref = 100;
+            break;
+        default:
+            pint->scale = 1;
+            pint->shift = 0;
+            return;
+    }
+
+    if (bits > 0 && bits < 32 && ref > 0 && ref <= UINT16_MAX) {
+        pint->scale = ref;
+        pint->shift = bits;
+    } else {
+        /* unknown reference, converts everything to 0 */
+        pint->scale = 0;
+        pint->shift = 0;
+    }
+}
+
+static inline int
+arduino_scale_value(const interfaces_t *pint, int value)
+{
+    return (int) (((uint32_t) value * pint->scale) >> pint->shift);
+}
+
 static int
-arduino_set_device(int entry_id, int devtype)
+arduino_set_device_locked(int entry_id, int devtype)
 {    
     int rc = -1;
+    uint32_t start = arduino_stats_start();
     const struct arduino_pin_map_entry *pmap = &pin_map[entry_id];
     interfaces_t *pint = &interface_map[entry_id];
 
     assert(entry_id < ARDUINO_NUM_DEVS);
 
     if (pint->type && (devtype != INTERFACE_UNINITIALIZED)) {
-        console_printf("Device already Initialized as %s -- set to %s to clear\n",
-                interface_info[entry_id].name,
-                "none");
+        /* in use, the caller says so, this may run on the I/O task */
+        rc = -3;
+        arduino_stats_record(devtype, ARDUINO_OP_SET, start, rc, 0);
+        return rc;
     }
 
+    /* a function that starts from a setting other than 0 sets it below */
+    pint->value = 0;
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_HAL);
     switch (devtype) {
         case INTERFACE_GPIO_OUT:
             rc = hal_gpio_init_out(pmap->sysid, 0);
@@ -225,6 +346,12 @@ arduino_set_device(int entry_id, int devtype)
         case INTERFACE_ADC:
         {
             struct hal_adc *padc;
+
+            /* creating the channel resets the ADC under its owner */
+            if (bsp_adc_busy()) {
+                rc = -2;
+                break;
+            }
             padc = hal_adc_init(pmap->sysid);
             if (NULL != padc) {
                 rc = 0;
@@ -233,6 +360,51 @@ arduino_set_device(int entry_id, int devtype)
             }
             break;
         }
+        case INTERFACE_ADC_WINDOW:
+            /* no band until one is written, the value stays 0 */
+            rc = adc_window_start(pmap->sysid, 0, ADC_WINDOW_MAX, 
+                                  arduino_window_cb, 
+                                  (void *)(intptr_t) entry_id);
+            if (rc == 0) {
+                pint->type = INTERFACE_ADC_WINDOW;
+            }
+            break;
+        case INTERFACE_ADC_SCAN:
+            rc = adc_scan_add(pmap->sysid);
+            if (rc == 0) {
+                pint->type = INTERFACE_ADC_SCAN;
+            }
+            break;
+        case INTERFACE_AC:
+        {
+            struct acmp_cfg cfg;
+            int value = ARDUINO_AC_PACK(ACMP_REF_SCALE, ACMP_SCALE_MAX / 2);
+
+            /* starts at half of VDD */
+            arduino_ac_cfg(entry_id, value, &cfg);
+            rc = acmp_open(pmap->sysid, &cfg);
+            if (rc >= 0) {
+                pint->comp = rc;
+                pint->value = value;
+                pint->type = INTERFACE_AC;
+                rc = 0;
+            }
+            break;
+        }
+        case INTERFACE_UART:
+        {
+            struct uart_dma *puart;
+            puart = bsp_get_uart_dma(pmap->sysid);
+            if (NULL != puart) {
+                rc = uart_dma_start(puart, ARDUINO_UART_BAUD, arduino_uart_cb,
+                                    (void *)(intptr_t) entry_id);
+                if (rc == 0) {
+                    pint->puart = puart;
+                    pint->type = INTERFACE_UART;
+                }
+            }
+            break;
+        }
         case INTERFACE_DAC:
         {
             struct hal_dac *pdac;
@@ -325,30 +497,85 @@ arduino_set_device(int entry_id, int devtype)
     }
 
     if (0 == rc) {
-       pint->value = 0; 
+       arduino_cache_scale(pint);
     }
+    ARDUINO_PROF_EXIT();
+    arduino_stats_record(devtype, ARDUINO_OP_SET, start, rc, 0);
     return rc;
 }
 
+/* the limits of a band apply to both of its ends, those of a 
+ * comparator to its scale, an adc pin has its filter checked */
+int
+arduino_value_in_range(int type, int value)
+{
+    const interface_into_t *pinfo = &interface_info[type];
+
+    if (type == INTERFACE_ADC_WINDOW) {
+        return ARDUINO_WINDOW_LOWER(value) >= pinfo->min_value &&
+               ARDUINO_WINDOW_UPPER(value) <= pinfo->max_value;
+    }
+    if (type == INTERFACE_ADC) {
+        /* bits outside the fields would be dropped by the unpacking */
+        return value >= pinfo->min_value && value <= pinfo->max_value &&
+               value == ARDUINO_FILTER_PACK(ARDUINO_FILTER_KIND(value),
+                                            ARDUINO_FILTER_PARAM(value),
+                                            ARDUINO_FILTER_DECIM(value)) &&
+               arduino_filter_valid(ARDUINO_FILTER_KIND(value),
+                                    ARDUINO_FILTER_PARAM(value),
+                                    ARDUINO_FILTER_DECIM(value));
+    }
+    if (type == INTERFACE_AC) {
+        return !(value & ~(0xff | ARDUINO_AC_HYST | ARDUINO_AC_EVENT)) &&
+               ARDUINO_AC_REF(value) <= ACMP_REF_DAC &&
+               ARDUINO_AC_SCALE(value) <= pinfo->max_value;
+    }
+    return value >= pinfo->min_value && value <= pinfo->max_value;
+}
+
 static int
-arduino_write(int entry_id, int value)
+arduino_write_locked(int entry_id, int value)
 {
     int rc = -1;
+    int bus_bytes = 0;
     interfaces_t *pint = &interface_map[entry_id];
+    uint32_t start = arduino_stats_start();
     
-    if ((value > interface_info[pint->type].max_value) ||
-       (value < interface_info[pint->type].min_value)) {
-        console_printf("Value %d out of range for device \n", value);
+    if (!arduino_value_in_range(pint->type, value)) {
+        rc = -3;
+        arduino_stats_record(pint->type, ARDUINO_OP_WRITE, start, rc, 0);
         return rc;
     }
 
+    pint->stamp = bsp_usec_get32();
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_HAL);
     switch (pint->type) {
         case INTERFACE_UNINITIALIZED:
         case INTERFACE_GPIO_IN:
-        case INTERFACE_ADC:
         default:
             /* these don't support write */
             break;
+        case INTERFACE_ADC:
+            /* sets the filter the conversions go through */
+            rc = 0;
+            if (value == 0) {
+                free(pint->pfilt);
+                pint->pfilt = NULL;
+            } else {
+                if (pint->pfilt == NULL) {
+                    pint->pfilt = malloc(sizeof(*pint->pfilt));
+                }
+                if (pint->pfilt == NULL) {
+                    rc = -2;
+                    break;
+                }
+                arduino_test_filter_init(pint->pfilt, 
+                                         ARDUINO_FILTER_KIND(value),
+                                         ARDUINO_FILTER_PARAM(value),
+                                         ARDUINO_FILTER_DECIM(value));
+            }
+            pint->value = value;
+            break;
         case INTERFACE_GPIO_OUT:
             if (value) {
                 hal_gpio_set(pint->gpio_pin);
@@ -371,6 +598,36 @@ arduino_write(int entry_id, int value)
             hal_pwm_enable_duty_cycle(pint->ppwm, 0x8000);
             pint->value = value;
             break;    
+        case INTERFACE_ADC_WINDOW:
+            rc = adc_window_set(ARDUINO_WINDOW_LOWER(value), 
+                                ARDUINO_WINDOW_UPPER(value));
+            if (rc == 0) {
+                pint->value = value;
+            }
+            break;
+        case INTERFACE_AC:
+        {
+            struct acmp_cfg cfg;
+
+            arduino_ac_cfg(entry_id, value, &cfg);
+            rc = acmp_config(pint->comp, &cfg);
+            if (rc == 0) {
+                pint->value = value;
+            }
+            break;
+        }
+        case INTERFACE_UART:
+        {
+            uint8_t byte = value;
+
+            /* only fails when the transmit ring is full */
+            if (uart_dma_write(pint->puart, &byte, 1) == 1) {
+                rc = 0;
+                pint->value = value;
+                bus_bytes = 1;
+            }
+            break;
+        }
         case INTERFACE_SPI:
             rc = hal_spi_master_transfer(pint->pspi, (uint8_t) value);
             /* this method has a special return code */
@@ -378,6 +635,7 @@ arduino_write(int entry_id, int value)
                 /* store what we read back  */
                 pint->value = rc;
                 rc = 0;
+                bus_bytes = 1;
             }
             break;
         case INTERFACE_I2C:
@@ -402,17 +660,55 @@ arduino_write(int entry_id, int value)
             }            
             /* store the value to use later */
             pint->value = value;
+            /* address and data byte */
+            bus_bytes = 2;
         }
     }
 
+    ARDUINO_PROF_EXIT();
+    arduino_stats_record(pint->type, ARDUINO_OP_WRITE, start, rc, bus_bytes);
     return rc;
 }
 
+/* 
+ * Takes one conversion per step of the decimator, so a read returns the
+ * one output of the filter they produce.  The samples are moved to Q15 
+ * and back using the resolution cached in shift.
+ */
+static int
+arduino_read_filtered(interfaces_t *pint, int *value)
+{
+    int qshift = pint->shift ? 15 - pint->shift : 0;
+    int16_t sample;
+    int16_t out;
+    int raw;
+    int i;
+
+    for (i = 0; i < pint->pfilt->decim; i++) {
+        raw = hal_adc_read(pint->padc);
+        if (raw < 0) {
+            return -1;
+        }
+        sample = raw << qshift;
+        if (arduino_test_filter_run(pint->pfilt, &sample, 1, &out)) {
+            *value = (out + ((1 << qshift) >> 1)) >> qshift;
+        }
+    }
+    return 0;
+}
+
+/* peek reads without side effects, for now only a uart pin has any */
 static int
-arduino_read(int entry_id, int *value) 
+arduino_read_locked(int entry_id, int *value, int peek) 
 {
     int rc = -1;
+    int bus_bytes = 0;
     interfaces_t *pint = &interface_map[entry_id];
+    uint32_t start = arduino_stats_start();
+
+    /* taken before the conversion or transfer starts */
+    pint->stamp = bsp_usec_get32();
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_HAL);
     
     switch (pint->type) {
         case INTERFACE_UNINITIALIZED:
@@ -430,11 +726,60 @@ arduino_read(int entry_id, int *value)
             rc = 0;
             break;
         case INTERFACE_ADC:
+            /* a conversion would take the ADC from the driver that owns
+             * it */
+            if (bsp_adc_busy()) {
+                rc = -2;
+                break;
+            }
+            if (pint->pfilt) {
+                rc = arduino_read_filtered(pint, value);
+                break;
+            }
             *value = hal_adc_read(pint->padc);            
             if(*value >= 0) {
                 rc = 0;
             }
             break; 
+        case INTERFACE_ADC_WINDOW:
+            /* the monitor converts continuously, take its latest */
+            *value = adc_window_value();
+            if (*value >= 0) {
+                rc = 0;
+            }
+            break;
+        case INTERFACE_ADC_SCAN:
+            /* no conversion, the stamp is when the value was taken */
+            rc = adc_scan_read(pin_map[entry_id].sysid, value, &pint->stamp);
+            break;
+        case INTERFACE_AC:
+            *value = acmp_state(pint->comp);
+            if (*value >= 0) {
+                rc = 0;
+            }
+            break;
+        case INTERFACE_UART:
+        {
+            uint8_t byte;
+            int cnt;
+
+            /* the next received byte, -1 if there is none */
+            if (peek) {
+                *value = uart_dma_peek(pint->puart);
+                rc = 0;
+                break;
+            }
+            cnt = uart_dma_read(pint->puart, &byte, 1);
+            if (cnt == 1) {
+                *value = byte;
+                bus_bytes = 1;
+            } else {
+                *value = -1;
+            }
+            /* an overrun lost bytes, the read fails once so it counts */
+            rc = cnt < 0 ? -3 : 0;
+            break;
+        }
         case INTERFACE_I2C:
         {
             uint8_t buf[8];
@@ -451,194 +796,1214 @@ arduino_read(int entry_id, int *value)
             rc = hal_i2c_master_read(pint->pi2c, &data);            
             hal_i2c_master_end(pint->pi2c);            
             *value = buf[0];
+            bus_bytes = 2;
             break;
         }            
     }
+    ARDUINO_PROF_EXIT();
+    arduino_stats_record(pint->type, ARDUINO_OP_READ, start, rc, bus_bytes);
     return rc;
 }
 
-static 
-void arduino_test_value_to_string(interfaces_t *pint, char *buf, int value) {
-    switch(pint->type) {
-        case INTERFACE_UNINITIALIZED:
-        {
-            sprintf(buf, "N/A");
-            break;
-        }
-        case INTERFACE_GPIO_OUT: 
-        {
-            sprintf(buf, "%s", (value ? "HIGH" : "LOW" ));
-            break;
-        }
-        case INTERFACE_PWM_DUTY:
-        {
-            int duty = (value * 100)/65536;
-            sprintf(buf, "%d %% Duty Cycle", duty);
-            break;
-        }
-        case INTERFACE_DAC:
-        {           
-            int bits = hal_dac_get_bits(pint->pdac);
-            int ref = hal_dac_get_ref_mv(pint->pdac);                        
-            int mvolts = 0;
-            
-            if (bits > 0 && ref > 0) {
-                mvolts = (value * ref) / (1 << bits);
-            }
-            /* get the mv and bits */
-            sprintf(buf, "%d milli-volts", mvolts);
-            
-            break;
-        }
-        case INTERFACE_PWM_FREQ:                     
-        {
-            sprintf(buf, "%d Hz", value );
-            break;
-        }
-        case INTERFACE_GPIO_IN:
-        {
-            sprintf(buf, "%s", value ? "HIGH" : "LOW");
-            break;
-        }            
-        case INTERFACE_ADC:
-        {
-            int bits = hal_adc_get_bits(pint->padc);
-            int ref = hal_adc_get_ref_mv(pint->padc);                        
-            int mvolts = 0;
-            
-            if (bits > 0 && ref > 0) {
-                mvolts = (value * ref) / (1 << bits);
-            }
-            /* get the mv and bits */
-            sprintf(buf, "%d milli-volts", mvolts);
-            
-            break;
-        }
-        case INTERFACE_SPI:
-        {
-            sprintf(buf, "%d (0x%x)", value, value);
-            break;
-        }        
-        case INTERFACE_I2C:
-        {
-            sprintf(buf, "%d (0x%x)", value, value);
-            break;
-        }               
-    }    
-}
+/* a paced block in flight, filled by the trigger callback */
+struct arduino_sample_blk
+{
+    struct os_sem asb_done;
+    int16_t  *asb_buf;
+    int       asb_cnt;
+    int       asb_pos;
+    int       asb_drop;         /* bits the trigger has over the pin */
+    uint32_t  asb_missed;
+};
 
-static void 
-arduino_show(int entry_id) 
+static struct arduino_sample_blk arduino_sample_blk;
+static uint16_t arduino_sample_dma[ARDUINO_SAMPLE_MAX_CNT];
+static int arduino_sample_busy;
+
+/* back to back conversions through the HAL, for a short block */
+static int
+arduino_sample_now(interfaces_t *pint, int16_t *buf, int cnt, 
+                   uint32_t *usecs)
 {
+    uint32_t first = bsp_usec_get32();
+    uint32_t last = first;
+    int value;
     int i;
-    int min = 0;
-    int max = ARDUINO_NUM_DEVS;
-    char buf[32];
-    
-    if (entry_id >= 0) {
-        min = entry_id;
-        max = entry_id + 1;
-    }
-    
-    console_printf("    %5s%9s%10s%22s%s\n", 
-                "Pin", "Function", "Raw Value", "Decoded Value", "Description");
-    
-    for ( i = min; i < max; i++) {
-        int value;
-        interfaces_t *pint = &interface_map[i];
-        const interface_into_t *pinfo;
-        
-        pinfo = &interface_info[pint->type];
-        
-        if (arduino_read(i, &value) != 0) {
-            sprintf(buf, "N/A");
-        } else {
-            sprintf(buf, "%d", value);            
+
+    pint->stamp = first;
+    for (i = 0; i < cnt; i++) {
+        last = bsp_usec_get32();
+        value = hal_adc_read(pint->padc);
+        if (value < 0) {
+            return -1;
         }
-        console_printf("        %5s%9s%10s",
-                        pin_map[i].name, pinfo->name, buf);
-        
-        arduino_test_value_to_string(pint, buf, value);
-        console_printf(" ( %17s )", buf);
-        console_printf(" %s\n", pin_map[i].desc);
-    }    
+        buf[i] = value;
+    }
+    *usecs = last - first;
+    return 0;
 }
 
+/* interrupt context, each half of the DMA buffer is copied out before 
+ * the trigger wraps around to it */
 static void
-usage(void) 
+arduino_sample_half(void *arg, const uint16_t *samples, int cnt)
 {
+    struct arduino_sample_blk *blk = arg;
     int i;
-    char buf[256];
-    char *ptr;
-    
-    console_printf("cmd: arduino <set|write|read|show> <args>\n");
-    console_printf("cmd:   set <pin> <function>\n");
-    console_printf("          Sets a pin to a desired function.  Not \n");
-    console_printf("          all pins support all functions. This \n");
-    console_printf("          will return an error if the function is \n");
-    console_printf("          not supported or if the pin is already \n");
-    console_printf("          set to a function.\n");
-    console_printf("cmd:   read <pin>\n");
-    console_printf("          Reads the value from a pin. If the function is \n");
-    console_printf("          a read function, returns the value read.  If the \n");
-    console_printf("          function is a write function, reads the previously \n");
-    console_printf("          written value. For SPI this returns the data \n");
-    console_printf("          read in the previous transfer (write) \n");
-    console_printf("          For I2C this reads one byte from the address\n");
-    console_printf("          used in the last I2C write.  It no write \n");
-    console_printf("          has been performed, this value is undefined \n");
-    console_printf("cmd:   write <pin> <value>\n");
-    console_printf("          Write a value to a pin.  If the pin is set to a\n");
-    console_printf("          read only function, an error is returned. The \n");
-    console_printf("          legal value depends on the function of the pin.\n");
-    console_printf("          For SPI this writes <value> as a 8-bit number.\n");
-    console_printf("          For I2C this writes 0x17 to the address <value>\n");
-    console_printf("cmd:   show {pin}\n");
-    console_printf("          With argument pin, shows information about that\n");
-    console_printf("          specific pin. Otherwise, shows information about\n");
-    console_printf("          all pins \n");
-    console_printf("\n");        
-    console_printf("       Valid Pins\n");
-    ptr = buf;
-    ptr += sprintf(buf, "          ");
-    for (i = 0; i < ARDUINO_NUM_DEVS; i++) {
-        ptr += sprintf(ptr, "%s ", pin_map[i].name);
-        if (i && ((i & 15) == 0)) {
-            console_printf("%s\n", buf);
-            ptr = buf;
-            ptr += sprintf(buf, "          ");            
-        }
+
+    if (blk->asb_pos >= blk->asb_cnt) {
+        return;
     }
-    
-    if (~i || ((i & 15) != 0)) {
-        console_printf("%s\n", buf);
+    for (i = 0; i < cnt && blk->asb_pos < blk->asb_cnt; i++) {
+        blk->asb_buf[blk->asb_pos++] = samples[i] >> blk->asb_drop;
     }
-    
-    console_printf("\n");
-    console_printf("       Valid Functions\n");
-    console_printf("          %9s%8s%8s %s\n",
-                    "name", "min_val", "max_val", "Description");
-    for (i = 0; i < INTERFACE_CNT; i++) {
-        console_printf( "          %9s%8d%8d %s\n",
-                interface_info[i].name,
-                interface_info[i].min_value,
-                interface_info[i].max_value,
-                interface_info[i].desc);
+    if (blk->asb_pos == blk->asb_cnt) {
+        blk->asb_missed = adc_trig_missed();
+        os_sem_release(&blk->asb_done);
     }
 }
 
+/* 
+ * A paced block is started by adc_trig on the tick of the microsecond
+ * clock, and the caller sleeps until the callback has the last
+ * conversion.  There is one DMA buffer, so a second block at the same 
+ * time gets -2 like any other user of a busy ADC.
+ */
 static int
-arduino_test_cli_cmd(int argc, char **argv)
+arduino_sample_trig(int entry_id, int16_t *buf, int cnt, uint32_t *usecs)
 {
+    interfaces_t *pint = &interface_map[entry_id];
+    struct arduino_sample_blk *blk = &arduino_sample_blk;
+    struct adc_trig_cfg cfg;
+    uint32_t interval = *usecs;
+    uint32_t wait;
+    os_sr_t sr;
+    int busy;
     int rc;
-    if (argc == 1) {
-        usage();
-        return 0;
+
+    OS_ENTER_CRITICAL(sr);
+    busy = arduino_sample_busy;
+    arduino_sample_busy = 1;
+    OS_EXIT_CRITICAL(sr);
+    if (busy) {
+        return -2;
     }
 
-    if (!strcmp(argv[1], "set")) {
-        int entry;
-        int dev;
+    os_sem_init(&blk->asb_done, 0);
+    blk->asb_buf = buf;
+    blk->asb_cnt = cnt;
+    blk->asb_pos = 0;
+    blk->asb_drop = (pint->shift && pint->shift < ADC_TRIG_BITS) ? 
+                    ADC_TRIG_BITS - pint->shift : 0;
+    blk->asb_missed = 0;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.adc_pin = pin_map[entry_id].sysid;
+    cfg.src = ADC_TRIG_TIMER;
+    cfg.period = interval;
+    cfg.buf = arduino_sample_dma;
+    /* an odd block waits for one conversion more */
+    cfg.buf_cnt = (cnt + 1) & ~1;
+    cfg.cb = arduino_sample_half;
+    cfg.arg = blk;
+
+    rc = adc_trig_start(&cfg);
+    if (rc == 0) {
+        pint->stamp = bsp_usec_get32() + interval;
+        /* the block and a quarter for ticks held off */
+        wait = (uint64_t) cfg.buf_cnt * interval * 5 / 4 * 
+               OS_TICKS_PER_SEC / 1000000 + 2;
+        os_sem_pend(&blk->asb_done, wait);
+        /* the sim model takes the conversions due by now in here */
+        adc_trig_samples();
+        adc_trig_stop();
+        if (blk->asb_pos < cnt) {
+            rc = -1;
+        } else {
+            *usecs = (cnt - 1 + blk->asb_missed) * interval;
+        }
+    }
+    arduino_sample_busy = 0;
+    return rc;
+}
+
+/* the filter of the pin is left out, it would smear the spectrum */
+static int
+arduino_sample_locked(int entry_id, int16_t *buf, int cnt, uint32_t *usecs)
+{
+    interfaces_t *pint = &interface_map[entry_id];
+    uint32_t start = arduino_stats_start();
+    int rc;
+
+    if (pint->type != INTERFACE_ADC || bsp_adc_busy()) {
+        return -2;
+    }
+    if (cnt <= 0 || cnt > ARDUINO_SAMPLE_MAX_CNT) {
+        return -1;
+    }
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_HAL);
+    if (*usecs == 0) {
+        rc = arduino_sample_now(pint, buf, cnt, usecs);
+    } else {
+        rc = arduino_sample_trig(entry_id, buf, cnt, usecs);
+    }
+    ARDUINO_PROF_EXIT();
+    arduino_stats_record(pint->type, ARDUINO_OP_READ, start, rc, 0);
+    return rc;
+}
+
+/* 
+ * One pass towards a board setup.  Every pin that changes function is
+ * released before any is set up, so a port shared by several pins, like
+ * SPI1 on A3 and A4, is free by then.  Pins that keep their function are
+ * only written, those that keep their setup are not touched at all.
+ */
+static int
+arduino_setup_pass(const struct arduino_conf_pin *want, int *changed)
+{
+    interfaces_t *pint;
+    int entry_id;
+    int cnt = 0;
+    int rc = 0;
+
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        pint = &interface_map[entry_id];
+        if (pint->type == want[entry_id].type) {
+            continue;
+        }
+        cnt++;
+        if (pint->type != INTERFACE_UNINITIALIZED) {
+            rc = arduino_set_device_locked(entry_id, 
+                                           INTERFACE_UNINITIALIZED);
+            if (rc) {
+                return rc;
+            }
+        }
+    }
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS && !rc; entry_id++) {
+        pint = &interface_map[entry_id];
+        if (pint->type != want[entry_id].type) {
+            rc = arduino_set_device_locked(entry_id, want[entry_id].type);
+        } else if (arduino_conf_has_value(pint->type) && 
+                   pint->value != want[entry_id].value) {
+            /* a pin that only gets a new value was not counted above */
+            cnt++;
+        } else {
+            continue;
+        }
+        if (!rc && arduino_conf_has_value(pint->type) && 
+            pint->value != want[entry_id].value) {
+            rc = arduino_write_locked(entry_id, want[entry_id].value);
+        }
+    }
+    if (changed) {
+        *changed = cnt;
+    }
+    return rc;
+}
+
+/* all pins are locked in order, so no client sees half of a setup and
+ * two of these cannot deadlock */
+static int
+arduino_setup_all(const struct arduino_conf_pin *want, int *changed)
+{
+    struct arduino_conf_pin old[ARDUINO_NUM_DEVS];
+    int entry_id;
+    int rc;
+
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        arduino_pin_lock(entry_id);
+        arduino_conf_current(entry_id, &old[entry_id]);
+    }
+    rc = 0;
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        /* the pins of the control loop cannot change under it */
+        if (arduino_ctl_uses(entry_id) && 
+            (want[entry_id].type != old[entry_id].type || 
+             want[entry_id].value != old[entry_id].value)) {
+            rc = -3;
+        }
+    }
+    if (rc == 0) {
+        rc = arduino_setup_pass(want, changed);
+        if (rc) {
+            (void) arduino_setup_pass(old, NULL);
+        }
+    }
+    for (entry_id = ARDUINO_NUM_DEVS - 1; entry_id >= 0; entry_id--) {
+        arduino_pin_unlock(entry_id);
+    }
+    return rc;
+}
+
+/* 
+ * The plain adc pins are converted in a pass of their own.  If another 
+ * driver owns the ADC they are left out and the snapshot says so, their
+ * HAL channels cannot be used then either.  An adc_scan pin gives the 
+ * value of the last pass.  The pins of the control loop are left out.
+ */
+static int
+arduino_snapshot_all(struct arduino_codec_snapshot *ps)
+{
+    int gpio_pins[ARDUINO_NUM_DEVS];
+    enum system_device_id adc_pins[ARDUINO_CODEC_SNAPSHOT_ADC];
+    int adc_values[ARDUINO_CODEC_SNAPSHOT_ADC];
+    uint8_t adc_entry[ARDUINO_CODEC_SNAPSHOT_ADC];
+    uint8_t scan_entry[ARDUINO_CODEC_SNAPSHOT_ADC];
+    interfaces_t *pint;
+    uint32_t levels;
+    uint32_t first = 0;
+    uint32_t oldest;
+    uint32_t prev = 0;
+    uint32_t stamp;
+    int passes = 0;
+    int scanned = 0;
+    int have;
+    int gpio_cnt = 0;
+    int adc_cnt = 0;
+    int scan_cnt = 0;
+    int entry_id;
+    int value;
+    int rc;
+    int i;
+    int j;
+    int k;
+
+    memset(ps, 0, sizeof(*ps));
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        arduino_pin_lock(entry_id);
+    }
+    for (entry_id = 0; entry_id < ARDUINO_NUM_DEVS; entry_id++) {
+        pint = &interface_map[entry_id];
+        if (arduino_ctl_uses(entry_id)) {
+            continue;
+        }
+        if (pint->type == INTERFACE_GPIO_IN) {
+            gpio_pins[gpio_cnt++] = pint->gpio_pin;
+            ps->gpio_mask |= 1UL << entry_id;
+        } else if ((pint->type == INTERFACE_ADC || 
+                    pint->type == INTERFACE_ADC_SCAN) &&
+                   adc_cnt + scan_cnt < ARDUINO_CODEC_SNAPSHOT_ADC) {
+            if (pint->type == INTERFACE_ADC) {
+                adc_entry[adc_cnt] = entry_id;
+                adc_pins[adc_cnt++] = pin_map[entry_id].sysid;
+            } else {
+                scan_entry[scan_cnt++] = entry_id;
+            }
+            ps->adc_mask |= 1UL << entry_id;
+        }
+    }
+
+    rc = pin_snap_gpio(gpio_pins, gpio_cnt, &levels, &ps->stamp);
+    for (i = 0; i < ARDUINO_NUM_DEVS && !rc; i++) {
+        if (ps->gpio_mask & (1UL << i)) {
+            if (levels & 1) {
+                ps->gpio_levels |= 1UL << i;
+            }
+            levels >>= 1;
+        }
+    }
+    if (!rc && adc_cnt) {
+        rc = pin_snap_adc(adc_pins, adc_cnt, adc_values, &first);
+        if (rc == 0) {
+            passes = 1;
+        } else if (rc == -2) {
+            for (i = 0; i < adc_cnt; i++) {
+                ps->adc_mask &= ~(1UL << adc_entry[i]);
+            }
+            ps->flags |= ARDUINO_CODEC_SNAP_ADC_BUSY;
+            adc_cnt = 0;
+            rc = 0;
+        }
+    }
+
+    /* the values go in entry id order, the delta is to the oldest 
+     * conversion */
+    oldest = first;
+    have = passes > 0;
+    for (i = 0, j = 0, k = 0; i < ARDUINO_NUM_DEVS && !rc; i++) {
+        if (!(ps->adc_mask & (1UL << i))) {
+            continue;
+        }
+        if (j < adc_cnt && adc_entry[j] == i) {
+            ps->adc[j + k] = adc_values[j];
+            j++;
+            continue;
+        }
+        entry_id = scan_entry[k];
+        rc = adc_scan_read(pin_map[entry_id].sysid, &value, &stamp);
+        /* the adc_scan pins share a pass unless one ended in between */
+        if (scanned++ == 0 || stamp != prev) {
+            passes++;
+        }
+        prev = stamp;
+        if (!have || (int32_t) (stamp - oldest) < 0) {
+            oldest = stamp;
+            have = 1;
+        }
+        ps->adc[j + k] = value;
+        k++;
+    }
+    if (have) {
+        ps->adc_delta = (int32_t) (oldest - ps->stamp);
+    }
+    if (passes == 1) {
+        ps->flags |= ARDUINO_CODEC_SNAP_ONE_PASS;
+    }
+
+    for (entry_id = ARDUINO_NUM_DEVS - 1; entry_id >= 0; entry_id--) {
+        arduino_pin_unlock(entry_id);
+    }
+    return rc;
+}
+
+int
+arduino_pin_exec(struct arduino_pin_req *req)
+{
+    int entry_id = req->apr_entry;
+    int rc;
+
+    if (req->apr_setup) {
+        return arduino_setup_all(req->apr_setup, &req->apr_value);
+    }
+    if (req->apr_snapshot) {
+        return arduino_snapshot_all(req->apr_snapshot);
+    }
+    if (entry_id < 0 || entry_id >= ARDUINO_NUM_DEVS) {
+        return -1;
+    }
+
+    arduino_pin_lock(entry_id);
+    if (req->apr_type_mask && 
+        !(req->apr_type_mask & (1UL << interface_map[entry_id].type))) {
+        rc = -2;
+    } else if (arduino_ctl_uses(entry_id)) {
+        /* the control loop drives it from an interrupt */
+        rc = arduino_ctl_pin_op(req);
+    } else {
+        switch (req->apr_op) {
+            case ARDUINO_OP_SET:
+                rc = arduino_set_device_locked(entry_id, req->apr_arg);
+                break;
+            case ARDUINO_OP_WRITE:
+                rc = arduino_write_locked(entry_id, req->apr_arg);
+                break;
+            case ARDUINO_OP_READ:
+                if (req->apr_buf) {
+                    rc = arduino_sample_locked(entry_id, req->apr_buf, 
+                            req->apr_arg, (uint32_t *) &req->apr_value);
+                    break;
+                }
+                rc = arduino_read_locked(entry_id, &req->apr_value, 
+                                         req->apr_arg);
+                break;
+            default:
+                rc = -1;
+                break;
+        }
+    }
+    req->apr_stamp = interface_map[entry_id].stamp;
+    if (req->apr_snap) {
+        *req->apr_snap = interface_map[entry_id];
+    }
+    arduino_pin_unlock(entry_id);
+    return rc;
+}
+
+int
+arduino_set_device(int entry_id, int devtype)
+{
+    struct arduino_pin_req req = { 0 };
+
+    req.apr_op = ARDUINO_OP_SET;
+    req.apr_entry = entry_id;
+    req.apr_arg = devtype;
+    return arduino_task_call(&req);
+}
+
+int
+arduino_set_all(const struct arduino_conf_pin *want, int *changed)
+{
+    struct arduino_pin_req req = { 0 };
+    int rc;
+
+    req.apr_op = ARDUINO_OP_SET;
+    req.apr_setup = want;
+    rc = arduino_task_call(&req);
+    if (changed) {
+        *changed = req.apr_value;
+    }
+    return rc;
+}
+
+int
+arduino_snapshot(struct arduino_codec_snapshot *ps)
+{
+    struct arduino_pin_req req = { 0 };
+
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_snapshot = ps;
+    return arduino_task_call(&req);
+}
+
+int
+arduino_test_snapshot(uint8_t *buf, int size)
+{
+    struct arduino_codec_snapshot snap;
+    int rc;
+
+    rc = arduino_snapshot(&snap);
+    if (rc) {
+        return rc;
+    }
+    return arduino_codec_encode_snapshot(&snap, buf, size);
+}
+
+int
+arduino_write(int entry_id, int value)
+{
+    struct arduino_pin_req req = { 0 };
+
+    req.apr_op = ARDUINO_OP_WRITE;
+    req.apr_entry = entry_id;
+    req.apr_arg = value;
+    return arduino_task_call(&req);
+}
+
+int
+arduino_read(int entry_id, int *value, uint32_t *stamp) 
+{
+    struct arduino_pin_req req = { 0 };
+    int rc;
+
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_entry = entry_id;
+    rc = arduino_task_call(&req);
+    if (rc == 0) {
+        *value = req.apr_value;
+        if (stamp) {
+            *stamp = req.apr_stamp;
+        }
+    }
+    return rc;
+}
+
+/* 
+ * Console output for show and usage is rendered into a single static
+ * buffer and handed to the console in one call.  The M0+ is slow at
+ * printf style formatting, so the few formats we need are done by hand.
+ * The buffer is flushed early only if the rendered text does not fit.
+ */
+#ifndef ARDUINO_OUTBUF_SIZE
+#define ARDUINO_OUTBUF_SIZE     (2048)
+#endif
+
+static char arduino_outbuf[ARDUINO_OUTBUF_SIZE];
+static int arduino_outbuf_len;
+
+static void
+arduino_out_flush(void)
+{
+    if (arduino_outbuf_len) {
+        ARDUINO_PROF_ENTER(ARDUINO_PHASE_CONSOLE);
+        console_write(arduino_outbuf, arduino_outbuf_len);
+        arduino_outbuf_len = 0;
+        ARDUINO_PROF_EXIT();
+    }
+}
+
+static void
+arduino_out_mem(const char *str, int len)
+{
+    int cnt;
+
+    while (len > 0) {
+        if (arduino_outbuf_len == ARDUINO_OUTBUF_SIZE) {
+            arduino_out_flush();
+        }
+        cnt = ARDUINO_OUTBUF_SIZE - arduino_outbuf_len;
+        if (cnt > len) {
+            cnt = len;
+        }
+        memcpy(&arduino_outbuf[arduino_outbuf_len], str, cnt);
+        arduino_outbuf_len += cnt;
+        str += cnt;
+        len -= cnt;
+    }
+}
+
+static void
+arduino_out_str(const char *str)
+{
+    arduino_out_mem(str, strlen(str));
+}
+
+/* right justifies str in a field of width characters like %<width>s */
+static void
+arduino_out_field(const char *str, int width)
+{
+    int len = strlen(str);
+
+    while (width-- > len) {
+        arduino_out_mem(" ", 1);
+    }
+    arduino_out_mem(str, len);
+}
+
+/* writes the decimal form of value into buf, returns the length */
+int
+arduino_fmt_uint(char *buf, uint32_t value)
+{
+    char tmp[10];
+    int len = 0;
+    int i = 0;
+
+    do {
+        tmp[i++] = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+
+    while (i) {
+        buf[len++] = tmp[--i];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+int
+arduino_fmt_int(char *buf, int value)
+{
+    if (value < 0) {
+        buf[0] = '-';
+        return 1 + arduino_fmt_uint(buf + 1, -(uint32_t) value);
+    }
+    return arduino_fmt_uint(buf, value);
+}
+
+/* the names of the comparator references, by enum acmp_ref */
+static const char * const arduino_ac_refs[] = { "", "bandgap", "dac" };
+
+/* by enum arduino_test_filter_kind */
+static const char * const arduino_filter_names[] = {
+    "none", "avg", "iir", "median"
+};
+
+int
+arduino_fmt_value(char *buf, int type, int value)
+{
+    int len;
+
+    switch (type) {
+        case INTERFACE_ADC_WINDOW:
+            if (value == 0) {
+                break;
+            }
+            len = arduino_fmt_int(buf, ARDUINO_WINDOW_LOWER(value));
+            buf[len++] = ':';
+            return len + arduino_fmt_int(buf + len, 
+                                         ARDUINO_WINDOW_UPPER(value));
+        case INTERFACE_AC:
+            if (ARDUINO_AC_REF(value) == ACMP_REF_SCALE) {
+                len = arduino_fmt_int(buf, ARDUINO_AC_SCALE(value));
+            } else {
+                strcpy(buf, arduino_ac_refs[ARDUINO_AC_REF(value)]);
+                len = strlen(buf);
+            }
+            if (value & ARDUINO_AC_HYST) {
+                strcpy(buf + len, ":hyst");
+                len += 5;
+            }
+            if (value & ARDUINO_AC_EVENT) {
+                strcpy(buf + len, ":event");
+                len += 6;
+            }
+            return len;
+        case INTERFACE_ADC:
+            strcpy(buf, arduino_filter_names[ARDUINO_FILTER_KIND(value)]);
+            len = strlen(buf);
+            if (ARDUINO_FILTER_KIND(value) != ARDUINO_FILTER_NONE) {
+                buf[len++] = ':';
+                len += arduino_fmt_int(buf + len, ARDUINO_FILTER_PARAM(value));
+            }
+            if (ARDUINO_FILTER_DECIM(value) > 1) {
+                buf[len++] = ':';
+                len += arduino_fmt_int(buf + len, ARDUINO_FILTER_DECIM(value));
+            }
+            return len;
+        default:
+            break;
+    }
+    return arduino_fmt_int(buf, value);
+}
+
+static int
+arduino_parse_band(const char *str, int *value)
+{
+    char *eptr;
+    long lower;
+    long upper;
+
+    lower = strtol(str, &eptr, 0);
+    if (eptr == str) {
+        return -1;
+    }
+    if (*eptr == '\0') {
+        *value = lower;
+        return 0;
+    }
+    if (*eptr != ':') {
+        return -1;
+    }
+    str = eptr + 1;
+    upper = strtol(str, &eptr, 0);
+    if (eptr == str || *eptr != '\0' || lower < 0 || upper > 0x7fff || 
+        lower >= upper) {
+        return -1;
+    }
+    /* upper is at least 1 so a band is never 0 */
+    *value = ARDUINO_WINDOW_PACK(lower, upper);
+    return 0;
+}
+
+static int
+arduino_parse_ac(const char *str, int *value)
+{
+    const char *next;
+    char *eptr;
+    long scale;
+    int len;
+    int ref;
+
+    next = strchr(str, ':');
+    len = next ? next - str : (int) strlen(str);
+    for (ref = ACMP_REF_BANDGAP; ref <= ACMP_REF_DAC; ref++) {
+        if (len == (int) strlen(arduino_ac_refs[ref]) &&
+            !strncmp(str, arduino_ac_refs[ref], len)) {
+            break;
+        }
+    }
+    if (ref > ACMP_REF_DAC) {
+        scale = strtol(str, &eptr, 0);
+        if (eptr == str || eptr != str + len || scale < 0 || 
+            scale > ACMP_SCALE_MAX) {
+            return -1;
+        }
+        *value = ARDUINO_AC_PACK(ACMP_REF_SCALE, scale);
+    } else {
+        *value = ARDUINO_AC_PACK(ref, 0);
+    }
+
+    while (next) {
+        str = next + 1;
+        next = strchr(str, ':');
+        len = next ? next - str : (int) strlen(str);
+        if (len == 4 && !strncmp(str, "hyst", 4)) {
+            *value |= ARDUINO_AC_HYST;
+        } else if (len == 5 && !strncmp(str, "event", 5)) {
+            *value |= ARDUINO_AC_EVENT;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+arduino_parse_filter(const char *str, int *value)
+{
+    const char *next;
+    char *eptr;
+    long num[2] = { 0, 1 };
+    int kind;
+    int len;
+    int i;
+
+    next = strchr(str, ':');
+    len = next ? next - str : (int) strlen(str);
+    for (kind = 0; kind < ARDUINO_FILTER_KIND_MAX; kind++) {
+        if (len == (int) strlen(arduino_filter_names[kind]) &&
+            !strncmp(str, arduino_filter_names[kind], len)) {
+            break;
+        }
+    }
+    if (kind == ARDUINO_FILTER_KIND_MAX) {
+        return -1;
+    }
+
+    /* none only takes the decimation */
+    for (i = (kind == ARDUINO_FILTER_NONE); next && i < 2; i++) {
+        str = next + 1;
+        num[i] = strtol(str, &eptr, 0);
+        if (eptr == str || (*eptr != '\0' && *eptr != ':')) {
+            return -1;
+        }
+        next = *eptr ? eptr : NULL;
+    }
+    if (next || !arduino_filter_valid(kind, num[0], num[1])) {
+        return -1;
+    }
+    *value = ARDUINO_FILTER_PACK(kind, num[0], num[1]);
+    return 0;
+}
+
+int
+arduino_parse_value(int type, const char *str, int *value)
+{
+    char *eptr;
+
+    switch (type) {
+        case INTERFACE_ADC_WINDOW:
+            return arduino_parse_band(str, value);
+        case INTERFACE_AC:
+            return arduino_parse_ac(str, value);
+        case INTERFACE_ADC:
+            return arduino_parse_filter(str, value);
+        default:
+            *value = strtol(str, &eptr, 0);
+            if (eptr == str || *eptr != '\0') {
+                return -1;
+            }
+            return 0;
+    }
+}
+
+/* writes the lowercase hex form of value into buf, returns the length */
+static int
+arduino_fmt_hex(char *buf, unsigned int value)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    char tmp[8];
+    int len = 0;
+    int i = 0;
+
+    do {
+        tmp[i++] = hexdigits[value & 0xf];
+        value >>= 4;
+    } while (value);
+
+    while (i) {
+        buf[len++] = tmp[--i];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+static void
+arduino_out_int(int value, int width)
+{
+    char buf[12];
+
+    arduino_fmt_int(buf, value);
+    arduino_out_field(buf, width);
+}
+
+/* prints "<Verb> <what>[<sep><arg>]" or "Unable to <verb> ..., err=<rc>" 
+ * for the outcome of a command, verb is lower case */
+static void
+arduino_out_result(int rc, const char *verb, const char *what, 
+                   const char *sep, const char *arg)
+{
+    char buf[12];
+    
+    os_mutex_pend(&arduino_out_mutex, OS_WAIT_FOREVER);
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_FORMAT);
+
+    if (rc) {
+        arduino_out_str("Unable to ");
+        arduino_out_str(verb);
+    } else {
+        buf[0] = verb[0] - 'a' + 'A';
+        buf[1] = '\0';
+        arduino_out_str(buf);
+        arduino_out_str(verb + 1);
+    }
+    arduino_out_str(what);
+    if (sep) {
+        arduino_out_str(sep);
+        arduino_out_str(arg);
+    }
+    if (rc) {
+        arduino_out_str(", err=");
+        arduino_fmt_int(buf, rc);
+        arduino_out_str(buf);
+    }
+    arduino_out_str("\n");
+    arduino_out_flush();
+    ARDUINO_PROF_EXIT();
+    os_mutex_release(&arduino_out_mutex);
+}
+
+static 
+void arduino_test_value_to_string(interfaces_t *pint, char *buf, int value) {
+    char *ptr = buf;
+
+    switch(pint->type) {
+        case INTERFACE_UNINITIALIZED:
+        default:
+        {
+            strcpy(buf, "N/A");
+            break;
+        }
+        case INTERFACE_GPIO_OUT: 
+        case INTERFACE_GPIO_IN:
+        {
+            strcpy(buf, value ? "HIGH" : "LOW");
+            break;
+        }
+        case INTERFACE_PWM_DUTY:
+        {
+            ptr += arduino_fmt_int(ptr, arduino_scale_value(pint, value));
+            strcpy(ptr, " % Duty Cycle");
+            break;
+        }
+        case INTERFACE_DAC:
+        {
+            ptr += arduino_fmt_int(ptr, arduino_scale_value(pint, value));
+            strcpy(ptr, " milli-volts");
+            break;
+        }
+        case INTERFACE_PWM_FREQ:                     
+        {
+            ptr += arduino_fmt_int(ptr, value);
+            strcpy(ptr, " Hz");
+            break;
+        }
+        case INTERFACE_ADC:
+        case INTERFACE_ADC_SCAN:
+        {
+            ptr += arduino_fmt_int(ptr, arduino_scale_value(pint, value));
+            strcpy(ptr, " milli-volts");
+            break;
+        }
+        case INTERFACE_SPI:
+        case INTERFACE_I2C:
+        {
+            ptr += arduino_fmt_int(ptr, value);
+            strcpy(ptr, " (0x");
+            ptr += 4;
+            ptr += arduino_fmt_hex(ptr, value);
+            strcpy(ptr, ")");
+            break;
+        }               
+        case INTERFACE_ADC_WINDOW:
+        {
+            ptr += arduino_fmt_int(ptr, value);
+            if (pint->value == 0) {
+                strcpy(ptr, " no band");
+                break;
+            }
+            if (value > ARDUINO_WINDOW_LOWER(pint->value) && 
+                value < ARDUINO_WINDOW_UPPER(pint->value)) {
+                strcpy(ptr, " in ");
+                ptr += 4;
+            } else {
+                strcpy(ptr, " out ");
+                ptr += 5;
+            }
+            arduino_fmt_value(ptr, pint->type, pint->value);
+            break;
+        }
+        case INTERFACE_AC:
+        {
+            strcpy(ptr, value ? "HIGH vs " : "LOW vs ");
+            ptr += strlen(ptr);
+            switch (ARDUINO_AC_REF(pint->value)) {
+                case ACMP_REF_SCALE:
+                    ptr += arduino_fmt_int(ptr, (ACMP_VDD_MV * 
+                            (ARDUINO_AC_SCALE(pint->value) + 1)) >> 6);
+                    strcpy(ptr, " mV");
+                    break;
+                case ACMP_REF_BANDGAP:
+                    ptr += arduino_fmt_int(ptr, ACMP_BANDGAP_MV);
+                    strcpy(ptr, " mV");
+                    break;
+                default:
+                    strcpy(ptr, "DAC");
+                    break;
+            }
+            if (pint->value & ARDUINO_AC_HYST) {
+                strcat(ptr, " hyst");
+            }
+            break;
+        }
+        case INTERFACE_UART:
+        {
+            if (value < 0) {
+                strcpy(buf, "nothing received");
+                break;
+            }
+            ptr += arduino_fmt_int(ptr, value);
+            strcpy(ptr, " (0x");
+            ptr += 4;
+            ptr += arduino_fmt_hex(ptr, value);
+            strcpy(ptr, ")");
+            break;
+        }
+    }    
+}
+
+static void 
+arduino_show(int entry_id) 
+{
+    int i;
+    int min = 0;
+    int max = ARDUINO_NUM_DEVS;
+    char buf[32];
+    
+    os_mutex_pend(&arduino_out_mutex, OS_WAIT_FOREVER);
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_FORMAT);
+    
+    if (entry_id >= 0) {
+        min = entry_id;
+        max = entry_id + 1;
+    }
+    
+    arduino_out_str("    ");
+    arduino_out_field("Pin", 5);
+    arduino_out_field("Function", 9);
+    arduino_out_field("Raw Value", 10);
+    arduino_out_field("Decoded Value", 22);
+    arduino_out_str("Description\n");
+    
+    for ( i = min; i < max; i++) {
+        struct arduino_pin_req req = { 0 };
+        int value;
+        int rc;
+        interfaces_t pin;
+        const interface_into_t *pinfo;
+        
+        /* format from a copy so the pin is locked only while reading */
+        req.apr_op = ARDUINO_OP_READ;
+        req.apr_entry = i;
+        req.apr_arg = 1;
+        req.apr_snap = &pin;
+        rc = arduino_task_call(&req);
+        value = req.apr_value;
+
+        pinfo = &interface_info[pin.type];
+        
+        arduino_out_str("        ");
+        arduino_out_field(pin_map[i].name, 5);
+        arduino_out_field(pinfo->name, 9);
+        if (rc != 0) {
+            arduino_out_field("N/A", 10);
+        } else {
+            arduino_out_int(value, 10);
+        }
+        
+        arduino_test_value_to_string(&pin, buf, value);
+        arduino_out_str(" ( ");
+        arduino_out_field(buf, 17);
+        arduino_out_str(" ) ");
+        arduino_out_str(pin_map[i].desc);
+        arduino_out_str("\n");
+    }    
+    arduino_out_flush();
+    ARDUINO_PROF_EXIT();
+    os_mutex_release(&arduino_out_mutex);
+}
+
+/* by enum arduino_test_event_kind */
+static const char * const arduino_event_names[] = {
+    " out", " in", " rise", " fall", " idle"
+};
+
+/* prints "Pin <pin> <kind> value <value> at <usecs> us" for each
+ * queued event */
+static void
+arduino_show_events(void)
+{
+    static uint32_t last_drops;
+    struct arduino_test_event ev;
+    char buf[12];
+    uint32_t drops;
+
+    os_mutex_pend(&arduino_out_mutex, OS_WAIT_FOREVER);
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_FORMAT);
+
+    while (arduino_test_event_get(&ev) == 0) {
+        arduino_out_str("Pin ");
+        arduino_out_str(pin_map[ev.entry_id].name);
+        arduino_out_str(arduino_event_names[ev.kind]);
+        arduino_out_str(" value ");
+        arduino_fmt_int(buf, ev.value);
+        arduino_out_str(buf);
+        arduino_out_str(" at ");
+        arduino_fmt_uint(buf, ev.usecs);
+        arduino_out_str(buf);
+        arduino_out_str(" us\n");
+    }
+    /* the ones lost since the last time */
+    drops = arduino_test_event_drops();
+    if (drops != last_drops) {
+        arduino_out_str("Dropped ");
+        arduino_fmt_uint(buf, drops - last_drops);
+        last_drops = drops;
+        arduino_out_str(buf);
+        arduino_out_str(" events\n");
+    }
+    arduino_out_flush();
+    ARDUINO_PROF_EXIT();
+    os_mutex_release(&arduino_out_mutex);
+}
+
+static const char usage_text[] =
+    "cmd: arduino <set|write|read|show|snap|events|spectrum|cal|log|agg|\n"
+    "          ctl|macro|profile|save> <args>\n"
+    "cmd:   set <pin> <function>\n"
+    "          Sets a pin to a desired function.  Not \n"
+    "          all pins support all functions. This \n"
+    "          will return an error if the function is \n"
+    "          not supported or if the pin is already \n"
+    "          set to a function.\n"
+    "cmd:   read <pin>\n"
+    "          Reads the value from a pin. If the function is \n"
+    "          a read function, returns the value read.  If the \n"
+    "          function is a write function, reads the previously \n"
+    "          written value. For SPI this returns the data \n"
+    "          read in the previous transfer (write) \n"
+    "          For I2C this reads one byte from the address\n"
+    "          used in the last I2C write.  It no write \n"
+    "          has been performed, this value is undefined \n"
+    "          For an adc with a filter this takes one sample\n"
+    "          per step of the decimation and returns the output.\n"
+    "          For adc_scan this returns the latest value of\n"
+    "          the background scan without a conversion.\n"
+    "          For uart this takes the next received byte, \n"
+    "          -1 if nothing is waiting.\n"
+    "          Prints the time the read started at, in \n"
+    "          microseconds of the BSP clock.\n"
+    "cmd:   write <pin> <value>\n"
+    "          Write a value to a pin.  If the pin is set to a\n"
+    "          read only function, an error is returned. The \n"
+    "          legal value depends on the function of the pin.\n"
+    "          For SPI this writes <value> as a 8-bit number.\n"
+    "          For I2C this writes 0x17 to the address <value>\n"
+    "          For adc_window <value> is the band <lower>:<upper>\n"
+    "          in raw counts, crossing it queues an event.\n"
+    "          For ac <value> is the reference, a step of VDD/64\n"
+    "          0..63, bandgap or dac, then :hyst to add\n"
+    "          hysteresis and :event to send changes to EVSYS\n"
+    "          instead of queueing events.\n"
+    "          For adc <value> is the filter the conversions go\n"
+    "          through, none, avg:<len>, iir:<alpha in Q15> or\n"
+    "          median:<len>, then :<n> to decimate by n.\n"
+    "          For uart this sends <value> as one byte at \n"
+    "          115200 baud.\n"
+    "cmd:   show {pin}\n"
+    "          With argument pin, shows information about that\n"
+    "          specific pin. Otherwise, shows information about\n"
+    "          all pins \n"
+    "cmd:   snap [log]\n"
+    "          Reads all gpio_in pins in one port read and all\n"
+    "          adc and adc_scan pins in one ADC pass, and prints\n"
+    "          the record with its time. log also appends it to\n"
+    "          the sample log.\n"
+    "cmd:   events\n"
+    "          Prints and removes the queued pin events, like\n"
+    "          adc_window crossings, ac changes and uart idle\n"
+    "          lines, oldest first.\n"
+    "cmd:   spectrum <pin> <rate> <samples> <freq> [<freq> ...]\n"
+    "          Takes <samples>, a power of 2 up to 256, from an\n"
+    "          adc pin at <rate> Hz, up to 20000, and prints the\n"
+    "          amplitude at up to 8 frequencies.\n"
+    "cmd:   cal [off|<pin> <mV>]\n"
+    "          Measures a known voltage on an adc pin. After a\n"
+    "          second one the ADC corrects its gain and offset\n"
+    "          in hardware. Without arguments shows the\n"
+    "          correction, off removes it.\n"
+    "cmd:   log <pin> <rate> <samples> [records]\n"
+    "          Takes [records] blocks of <samples>, up to 256,\n"
+    "          from an adc pin at <rate> Hz, up to 20000, into\n"
+    "          the sample log in flash, one record per block.\n"
+    "cmd:   log <show [n]|info|erase>\n"
+    "          Prints the last [n] records of the sample log or\n"
+    "          its use, or erases it.\n"
+    "cmd:   agg [<pin> <period ms> <window s>|<pin> off]\n"
+    "          Reads a pin every <period ms> and logs the count,\n"
+    "          min, max and mean of each window to the sample\n"
+    "          log. Without arguments shows the pins and their\n"
+    "          window so far.\n"
+    "cmd:   ctl <in> <out> <rate> <setpoint> <kp> [<ki> [<kd>]]\n"
+    "          Runs a PID from the adc pin <in> to the dac or\n"
+    "          pwm_duty pin <out> at <rate> Hz in a timer\n"
+    "          interrupt. <setpoint> is in raw counts, the gains\n"
+    "          are decimal, ki per second and kd in seconds.\n"
+    "cmd:   ctl [sp <setpoint>|off]\n"
+    "          Shows the loop with its timing jitter and CPU\n"
+    "          share, moves the setpoint or stops it.\n"
+    "cmd:   macro add <name> <set|write|read|delay> <args>\n"
+    "          Compiles one set, write or read command, or a\n"
+    "          delay in ms, and appends it to the macro <name>\n"
+    "          in flash.\n"
+    "cmd:   macro <run|del> <name>, macro list\n"
+    "          Runs the steps of a macro in order, stopping at\n"
+    "          the first error, without printing reads.\n"
+    "cmd:   profile <save|load|del> <name>, profile list\n"
+    "          Saves the setup of all pins in flash as <name>,\n"
+    "          or checks a saved one and gives it to all pins\n"
+    "          at once. Pins that already have their setup are\n"
+    "          not touched, the switch time is printed.\n"
+    "cmd:   save\n"
+    "          Stores the function and output value of all pins\n"
+    "          and the ADC correction in flash, they are restored\n"
+    "          at the next boot. Only pins changed since the last\n"
+    "          save are written.\n"
+    "\n";
+
+static void
+usage(void) 
+{
+    int i;
+    
+    os_mutex_pend(&arduino_out_mutex, OS_WAIT_FOREVER);
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_FORMAT);
+    
+    arduino_out_mem(usage_text, sizeof(usage_text) - 1);
+    arduino_out_str("       Valid Pins\n");
+    arduino_out_str("          ");
+    for (i = 0; i < ARDUINO_NUM_DEVS; i++) {
+        arduino_out_str(pin_map[i].name);
+        arduino_out_str(" ");
+        if (i && ((i & 15) == 0)) {
+            arduino_out_str("\n          ");
+        }
+    }
+    arduino_out_str("\n");
+    
+    arduino_out_str("\n");
+    arduino_out_str("       Valid Functions\n");
+    arduino_out_str("          ");
+    arduino_out_field("name", 9);
+    arduino_out_field("min_val", 8);
+    arduino_out_field("max_val", 9);
+    arduino_out_str(" Description\n");
+    for (i = 0; i < INTERFACE_MAX; i++) {
+        arduino_out_str("          ");
+        arduino_out_field(interface_info[i].name, 9);
+        arduino_out_int(interface_info[i].min_value, 8);
+        arduino_out_int(interface_info[i].max_value, 9);
+        arduino_out_str(" ");
+        arduino_out_str(interface_info[i].desc);
+        arduino_out_str("\n");
+    }
+    arduino_out_flush();
+    ARDUINO_PROF_EXIT();
+    os_mutex_release(&arduino_out_mutex);
+}
+
+static int
+arduino_test_cli_exec(int argc, char **argv)
+{
+    int rc;
+    if (argc == 1) {
+        usage();
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "set")) {
+        int entry;
+        int dev;
         
         if (argc != 4) {
             usage();
@@ -662,11 +2027,16 @@ arduino_test_cli_cmd(int argc, char **argv)
         }
         
         rc = arduino_set_device(entry, dev);
-        if (rc) {
-            console_printf("Unable to set pin %s to %s, err=%d\n", argv[2], argv[3], rc);
-        } else {
-            console_printf("Set pin %s to %s\n", argv[2], argv[3]);            
-        }  
+        if (rc == -3) {
+            console_printf("Device already Initialized as %s -- set to %s "
+                           "to clear\n", 
+                           interface_info[interface_map[entry].type].name,
+                           "none");
+        } else if (rc == -4) {
+            console_printf("Pin %s in use by ctl, stop ctl first\n", 
+                           argv[2]);
+        }
+        arduino_out_result(rc, "set pin ", argv[2], " to ", argv[3]);
     } else if (!strcmp(argv[1], "write")) { 
         int entry;
         int value;
@@ -684,37 +2054,65 @@ arduino_test_cli_cmd(int argc, char **argv)
             return -1;                                
         }
 
-        value = atoi(argv[3]);
+        if (arduino_parse_value(interface_map[entry].type, argv[3], 
+                                &value)) {
+            console_printf("Invalid value %s \n", argv[3]);
+            usage();
+            return -1;
+        }
 
         rc = arduino_write(entry, value);
-        if (rc) {
-            console_printf("Unable to write %s to %d, err=%d\n", argv[2], value, rc);
-        } else {
-            console_printf("Write pin %s to %d\n", argv[2], value);            
-        }               
+        {
+            char buf[24];
+
+            arduino_fmt_value(buf, interface_map[entry].type, value);
+            if (rc == -3) {
+                console_printf("Value %s out of range for device \n", buf);
+            } else if (rc == -4) {
+                console_printf("Pin %s in use by ctl, stop ctl first\n", 
+                               argv[2]);
+            }
+            arduino_out_result(rc, rc ? "write " : "write pin ", argv[2], 
+                               " to ", buf);
+        }
     }  else if (!strcmp(argv[1], "read")) { 
         int entry;
         int value;
+        uint32_t stamp;
 
-        entry = arduino_pinstr_to_entry(argv[2]);
-        
         if (argc != 3) {
             usage();
             return 0;
         }
         
+        entry = arduino_pinstr_to_entry(argv[2]);
+        
         if (entry < 0) {
             console_printf("Invalid pin %s \n", argv[2]);
             usage();
             return -1;                                
         }
 
-        rc = arduino_read(entry, &value);
+        rc = arduino_read(entry, &value, &stamp);
         if (rc) {
-            console_printf("Unable to read %s, err=%d\n", argv[2], rc);
+            arduino_out_result(rc, "read ", argv[2], NULL, NULL);
         } else {
-            console_printf("Read pin %s value %d\n", argv[2], value);            
-        }              
+            char buf[48];
+            char *ptr = buf;
+
+            ptr += arduino_fmt_int(ptr, value);
+            strcpy(ptr, " at ");
+            ptr += 4;
+            ptr += arduino_fmt_uint(ptr, stamp);
+            strcpy(ptr, " us");
+            if (interface_map[entry].type == INTERFACE_ADC_SCAN) {
+                strcpy(ptr + 3, ", age ");
+                ptr += 9;
+                ptr += arduino_fmt_uint(ptr, bsp_usec_get32() - stamp);
+                strcpy(ptr, " us");
+            }
+            arduino_out_result(rc, "read pin ", argv[2], " value ", buf);
+        }
     } else if (!strcmp(argv[1], "show")) {
         int entry_id = -1;
         if (argc == 3) {
@@ -730,15 +2128,188 @@ arduino_test_cli_cmd(int argc, char **argv)
             return -1;             
         }                  
         arduino_show(entry_id);
+    } else if (!strcmp(argv[1], "snap")) {
+        if (arduino_snap_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "events")) {
+        arduino_show_events();
+    } else if (!strcmp(argv[1], "spectrum")) {
+        if (arduino_spectrum_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "cal")) {
+        if (arduino_cal_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "log")) {
+        if (arduino_log_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "agg")) {
+        if (arduino_agg_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "ctl")) {
+        if (arduino_ctl_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "macro")) {
+        if (arduino_macro_cmd(argc - 1, argv + 1) == -1) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "profile")) {
+        if (arduino_profile_cmd(argc - 1, argv + 1)) {
+            usage();
+            return -1;
+        }
+    } else if (!strcmp(argv[1], "save")) {
+        rc = arduino_conf_save();
+        if (rc) {
+            console_printf("Unable to save pin setup, err=%d\n", rc);
+        } else {
+            console_printf("Saved pin setup\n");
+        }
     }else if ( !strcmp(argv[1], "?") || !strcmp(argv[1], "help")) {
         usage();
     }
     return 0;
 }
 
+static int
+arduino_test_cli_cmd(int argc, char **argv)
+{
+    int rc;
+    ARDUINO_PROF_ENTER(ARDUINO_PHASE_PARSE);
+
+    rc = arduino_test_cli_exec(argc, argv);
+    ARDUINO_PROF_EXIT();
+    return rc;
+}
+
+int
+arduino_test_cmd(int argc, char **argv)
+{
+    return arduino_test_cli_cmd(argc, argv);
+}
+
+int
+arduino_test_pin_lookup(const char *pinstr)
+{
+    return arduino_pinstr_to_entry(pinstr);
+}
+
+/* reads a pin whose type is in type_mask and applies the cached 
+ * scale factor */
+static int
+arduino_read_scaled(int entry_id, uint32_t type_mask, int *out)
+{
+    struct arduino_pin_req req = { 0 };
+    interfaces_t pin;
+    int rc;
+
+    if (entry_id < 0 || entry_id >= ARDUINO_NUM_DEVS) {
+        return -1;
+    }
+
+    req.apr_op = ARDUINO_OP_READ;
+    req.apr_entry = entry_id;
+    req.apr_type_mask = type_mask;
+    req.apr_snap = &pin;
+    rc = arduino_task_call(&req);
+    if (rc == 0) {
+        *out = arduino_scale_value(&pin, req.apr_value);
+    }
+    return rc;
+}
+
+int
+arduino_test_read_stamped(int entry_id, int *value, uint32_t *usecs)
+{
+    if (entry_id < 0 || entry_id >= ARDUINO_NUM_DEVS) {
+        return -1;
+    }
+    return arduino_read(entry_id, value, usecs);
+}
+
+int
+arduino_test_read_mv(int entry_id, int *mvolts)
+{
+    return arduino_read_scaled(entry_id, 
+            (1UL << INTERFACE_ADC) | (1UL << INTERFACE_ADC_SCAN) | 
+            (1UL << INTERFACE_DAC), mvolts);
+}
+
+int
+arduino_test_read_percent(int entry_id, int *percent)
+{
+    return arduino_read_scaled(entry_id, 1UL << INTERFACE_PWM_DUTY, percent);
+}
+
 int
 arduino_test_init(void) 
 {
+    int rc;
+    int i;
+
+    for (i = 0; i < ARDUINO_NUM_DEVS; i++) {
+        os_mutex_init(&arduino_pin_mutex[i]);
+    }
+    os_mutex_init(&arduino_out_mutex);
+
+    rc = arduino_macro_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_spectrum_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_profile_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_log_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_agg_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_ctl_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_stats_init();
+    if (rc) {
+        return rc;
+    }
+
+    rc = arduino_nmgr_init();
+    if (rc) {
+        return rc;
+    }
+
+    /* restores the pins saved in the config */
+    rc = arduino_conf_init();
+    if (rc) {
+        return rc;
+    }
+
     shell_cmd_register(&arduino_test_cmd_struct);
     return 0;
 }
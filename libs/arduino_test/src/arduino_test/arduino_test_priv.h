@@ -0,0 +1,399 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ARDUINO_TEST_PRIV_H__
+#define __ARDUINO_TEST_PRIV_H__
+
+#include <stdint.h>
+#include <arduino_test/arduino_test.h>
+
+/* the types of things we can configure this to */
+enum interface_type
+{
+    INTERFACE_UNINITIALIZED = 0,
+    INTERFACE_GPIO_OUT,
+    INTERFACE_GPIO_IN,
+    INTERFACE_ADC,
+    INTERFACE_DAC,
+    INTERFACE_PWM_DUTY,
+    INTERFACE_PWM_FREQ,
+    INTERFACE_SPI,
+    INTERFACE_I2C,
+    INTERFACE_ADC_WINDOW,
+    INTERFACE_AC,
+    INTERFACE_UART,
+    INTERFACE_ADC_SCAN,
+    INTERFACE_MAX,
+};
+
+#define ARDUINO_NUM_DEVS  (22)
+
+struct arduino_pin_map_entry 
+{
+    char     *name;
+    uint8_t   sysid;
+    uint8_t   entry_id;
+    char     *desc;
+};
+
+typedef struct 
+{
+    char    *name;
+    uint8_t  entry_id;
+    int      min_value;
+    int      max_value;
+    char *  desc; 
+} interface_into_t;
+
+/* The dynamic data that says what each pin is doing */
+typedef struct
+{
+    int type;
+    int value;
+    /* raw value to engineering units is (value * scale) >> shift,
+     * cached when the pin is configured since the M0+ has no divider */
+    uint16_t scale;
+    uint8_t  shift;
+    /* bsp_usec_get32() when the pin was last read or written */
+    uint32_t stamp;
+    /* the conversions of an adc pin go through this if set */
+    struct arduino_test_filter *pfilt;
+    union
+    {
+        int    gpio_pin;
+        int    comp;
+        struct hal_adc *padc;
+        struct hal_dac *pdac;
+        struct hal_pwm *ppwm;
+        struct hal_spi *pspi;
+        struct hal_i2c *pi2c;
+        struct uart_dma *puart;
+        void           *pany;
+    };
+} interfaces_t;
+
+extern const struct arduino_pin_map_entry pin_map[ARDUINO_NUM_DEVS];
+extern const interface_into_t interface_info[INTERFACE_MAX];
+extern interfaces_t interface_map[ARDUINO_NUM_DEVS];
+
+/* serializes access to one pin, set/read/write take it themselves */
+void
+arduino_pin_lock(int entry_id);
+
+void
+arduino_pin_unlock(int entry_id);
+
+/* returns the entry id of the named pin, or -1 */
+int
+arduino_pinstr_to_entry(const char *pinstr);
+
+/* returns the interface type of the named function, or -1 */
+int
+arduino_devstr_to_dev(const char *devstr);
+
+/* returns -3 if the pin already has a function, set it to none first,
+ * and -4 if the control loop drives it, stop the loop first */
+int
+arduino_set_device(int entry_id, int devtype);
+
+/* returns -3 if the value is out of range for the function of the pin
+ * and -4 if the control loop drives it */
+int
+arduino_write(int entry_id, int value);
+
+/* stamp, if not NULL, gets the time of the read in microseconds */
+int
+arduino_read(int entry_id, int *value, uint32_t *stamp);
+
+/* the setup of one pin as it is saved, the value only for the types
+ * arduino_conf_has_value() takes */
+struct arduino_conf_pin
+{
+    uint8_t type;
+    int     value;
+};
+
+struct arduino_codec_snapshot;
+
+/* one pin operation, as run by the I/O task */
+struct arduino_pin_req
+{
+    uint8_t   apr_op;           /* ARDUINO_OP_xxx */
+    int       apr_entry;
+    int       apr_arg;          /* device type for set, value for write,
+                                 * non-zero for a read that only looks */
+    int       apr_value;        /* the value read */
+    uint32_t  apr_stamp;        /* when the pin was read or written */
+    uint32_t  apr_type_mask;    /* if set, only run on these types */
+    interfaces_t *apr_snap;     /* if set, gets a copy of the pin */
+    int16_t  *apr_buf;          /* if set, a read of an adc fills it with
+                                 * apr_arg raw conversions, one every
+                                 * apr_value usecs, and apr_value gets 
+                                 * the usecs from the first to the last.
+                                 * 0 usecs is back to back, otherwise it
+                                 * is at least ADC_TRIG_MIN_PERIOD */
+    const struct arduino_conf_pin *apr_setup;
+                                /* if set, all pins get this setup at once
+                                 * and apr_value the number changed */
+    struct arduino_codec_snapshot *apr_snapshot;
+                                /* if set, gets the gpio_in, adc and 
+                                 * adc_scan pins read at once */
+};
+
+/* the most conversions a read with apr_buf takes */
+#define ARDUINO_SAMPLE_MAX_CNT      (256)
+
+/* runs a request in the calling task, under the pin lock */
+int
+arduino_pin_exec(struct arduino_pin_req *req);
+
+/* runs a request on the I/O task if it is running, otherwise inline.
+ * A paced block read with apr_buf always runs in the caller, it sleeps
+ * until the block is in and only holds the lock of its pin */
+int
+arduino_task_call(struct arduino_pin_req *req);
+
+/* gives every pin the setup in want, one entry per pin, with all pins 
+ * locked.  Only the pins that differ are touched, if one fails the old
+ * setup is put back.  changed, if not NULL, gets the number of pins that
+ * were changed */
+int
+arduino_set_all(const struct arduino_conf_pin *want, int *changed);
+
+/* reads all pins at once into ps, see arduino_test_snapshot() */
+int
+arduino_snapshot(struct arduino_codec_snapshot *ps);
+
+/* returns 1 if value is legal for a pin of the given type */
+int
+arduino_value_in_range(int type, int value);
+
+/* the band of an adc_window pin is kept in its value */
+#define ARDUINO_WINDOW_PACK(lower, upper)   (((upper) << 16) | (lower))
+#define ARDUINO_WINDOW_LOWER(value)         ((value) & 0xffff)
+#define ARDUINO_WINDOW_UPPER(value)         (((value) >> 16) & 0xffff)
+
+/* the setup of an ac pin is kept in its value, the reference is one of
+ * enum acmp_ref and scale the step of the scaled VDD reference */
+#define ARDUINO_AC_PACK(ref, scale)         (((ref) << 6) | (scale))
+#define ARDUINO_AC_SCALE(value)             ((value) & 0x3f)
+#define ARDUINO_AC_REF(value)               (((value) >> 6) & 0x3)
+#define ARDUINO_AC_HYST                     (1 << 8)
+#define ARDUINO_AC_EVENT                    (1 << 9)
+
+/* the filter of an adc pin is kept in its value, 0 is none */
+#define ARDUINO_FILTER_PACK(kind, param, decim) \
+    (((kind) << 24) | (((decim) - 1) << 16) | (param))
+#define ARDUINO_FILTER_KIND(value)          (((value) >> 24) & 0x3)
+#define ARDUINO_FILTER_DECIM(value)         \
+    ((((value) >> 16) & (ARDUINO_FILTER_DECIM_MAX - 1)) + 1)
+#define ARDUINO_FILTER_PARAM(value)         ((value) & 0xffff)
+/* the largest value arduino_filter_valid() takes, a median of the 
+ * longest odd length at the highest decimation */
+#define ARDUINO_FILTER_VALUE_MAX            \
+    ARDUINO_FILTER_PACK(ARDUINO_FILTER_MEDIAN, ARDUINO_FILTER_MAX_LEN - 1, \
+                        ARDUINO_FILTER_DECIM_MAX)
+
+/* returns 1 if arduino_test_filter_init() takes these */
+int
+arduino_filter_valid(int kind, int param, int decim);
+
+/* parses a value of a pin of the given type as written on the shell, 
+ * "<int>", "<lower>:<upper>" for a band, 
+ * "<scale|bandgap|dac>[:hyst][:event]" for a comparator or
+ * "<none|avg|iir|median>[:<param>][:<decim>]" for a filter. Returns 0 or 
+ * -1 */
+int
+arduino_parse_value(int type, const char *str, int *value);
+
+/* formats a value of a pin of the given type the way it is parsed */
+int
+arduino_fmt_value(char *buf, int type, int value);
+
+/* queues an event from a pin, can be called from interrupt context */
+void
+arduino_event_post(int entry_id, int kind, int value);
+
+/* write the decimal form of value into buf, return the length */
+int
+arduino_fmt_int(char *buf, int value);
+
+int
+arduino_fmt_uint(char *buf, uint32_t value);
+
+/* 
+ * Macros and profiles are stored as "<dir>/<name>" with a header of 
+ * ARDUINO_FILE_HDR_LEN bytes that records the kind of file and the size
+ * of the pin and function tables, a file from a build where they differ
+ * is refused.
+ */
+#define ARDUINO_FILE_NAME_LEN       (12)
+#define ARDUINO_FILE_HDR_LEN        (4)
+#define ARDUINO_FILE_PATH_LEN(dir)  (sizeof(dir) + ARDUINO_FILE_NAME_LEN + 1)
+
+/* builds "<dir>/<name>" into path, returns -1 for a bad name */
+int
+arduino_file_path(const char *dir, const char *name, char *path);
+
+/* writes the header of a file of the given kind to buf */
+void
+arduino_file_hdr_put(uint8_t *buf, uint8_t kind);
+
+/* returns 0 if the len bytes in buf start with a header of the given 
+ * kind written by this build, -1 if not */
+int
+arduino_file_hdr_check(const uint8_t *buf, int len, uint8_t kind);
+
+/* runs "arduino macro <add|run|del|list> ...", argv[0] is "macro" */
+int
+arduino_macro_cmd(int argc, char **argv);
+
+int
+arduino_macro_init(void);
+
+/* runs "arduino spectrum <pin> <rate> <samples> <freq> ...", argv[0] is
+ * "spectrum" */
+int
+arduino_spectrum_cmd(int argc, char **argv);
+
+int
+arduino_spectrum_init(void);
+
+/* runs "arduino cal [off|<pin> <mV>]", argv[0] is "cal" */
+int
+arduino_cal_cmd(int argc, char **argv);
+
+/* runs "arduino log <pin> <rate> <samples> [records]" and "arduino log
+ * <show [n]|info|erase>", argv[0] is "log" */
+int
+arduino_log_cmd(int argc, char **argv);
+
+/* gives up to len bytes of the sample log from *off on to out, in pieces,
+ * and returns how many.  An offset is the sequence number of a block
+ * times the block size plus the place in it, so it stays valid while the
+ * log wraps.  *off is moved up to the oldest byte if it was erased, *end
+ * gets the offset after the newest */
+int
+arduino_log_export(uint32_t *off, int len, uint32_t *end,
+                   int (*out)(void *arg, const void *data, int len), 
+                   void *arg);
+
+/* opens the sample log in the BSP flash area */
+int
+arduino_log_init(void);
+
+/* runs "arduino agg [<pin> <period ms> <window s>|<pin> off]", argv[0]
+ * is "agg" */
+int
+arduino_agg_cmd(int argc, char **argv);
+
+int
+arduino_agg_init(void);
+
+/* runs "arduino ctl [<in> <out> <rate> <setpoint> <kp> [<ki> [<kd>]]]" 
+ * and "arduino ctl <sp <setpoint>|off>", argv[0] is "ctl" */
+int
+arduino_ctl_cmd(int argc, char **argv);
+
+int
+arduino_ctl_init(void);
+
+/* returns 1 if the control loop drives the pin */
+int
+arduino_ctl_uses(int entry_id);
+
+/* runs a request on a pin of the control loop, only reads are allowed,
+ * anything else returns -4 */
+int
+arduino_ctl_pin_op(struct arduino_pin_req *req);
+
+/* runs "arduino snap [log]", argv[0] is "snap" */
+int
+arduino_snap_cmd(int argc, char **argv);
+
+/* registers the newtmgr handlers */
+int
+arduino_nmgr_init(void);
+
+/* runs "arduino profile <save|load|del> <name>" and "arduino profile 
+ * list", argv[0] is "profile" */
+int
+arduino_profile_cmd(int argc, char **argv);
+
+int
+arduino_profile_init(void);
+
+/* returns 1 if the value of a pin of this type is part of its setup */
+int
+arduino_conf_has_value(int type);
+
+/* the setup of a pin right now */
+void
+arduino_conf_current(int entry_id, struct arduino_conf_pin *pcp);
+
+/* registers the config handler and restores the saved pin setup */
+int
+arduino_conf_init(void);
+
+/* writes pin configuration changed since the last save to flash */
+int
+arduino_conf_save(void);
+
+/* 
+ * Phase profiling for the benchmark app, compiled in only when 
+ * ARDUINO_TEST_PROFILE is defined.  Time is charged to the phase that
+ * is current, ENTER switches to a new phase and EXIT returns to the one
+ * that was current at the matching ENTER, so nested phases are not 
+ * counted twice.  Only one ENTER per block.
+ */
+#ifdef ARDUINO_TEST_PROFILE
+int
+arduino_prof_switch(int phase);
+
+#define ARDUINO_PROF_ENTER(phase)   \
+    int arduino_prof_prev = arduino_prof_switch(phase)
+#define ARDUINO_PROF_EXIT()         \
+    (void) arduino_prof_switch(arduino_prof_prev)
+#else
+#define ARDUINO_PROF_ENTER(phase)
+#define ARDUINO_PROF_EXIT()
+#endif
+
+/* the operations we keep statistics for */
+enum arduino_stats_op
+{
+    ARDUINO_OP_SET = 0,
+    ARDUINO_OP_READ,
+    ARDUINO_OP_WRITE,
+};
+
+/* registers one stats section per interface type */
+int
+arduino_stats_init(void);
+
+/* returns a timestamp to pass to arduino_stats_record */
+uint32_t
+arduino_stats_start(void);
+
+/* records one operation on an interface type, started at start, and 
+ * the number of bytes it moved on a bus */
+void
+arduino_stats_record(int type, int op, uint32_t start, int rc, int bus_bytes);
+
+#endif /* __ARDUINO_TEST_PRIV_H__ */
@@ -0,0 +1,258 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include <arduino_test/arduino_codec.h>
+
+/* 
+ * Host tests of the sample codec, run with newt test.  The codec only
+ * needs stdint, so they cover the edges the board rarely produces: the
+ * widest differences of int16 samples, buffers cut short at every byte
+ * and counts above what the caller has room for.
+ */
+
+#define ARDUINO_CODEC_TEST_CNT  (10)
+
+static const int16_t arduino_codec_test_samples[ARDUINO_CODEC_TEST_CNT] = {
+    INT16_MAX, INT16_MIN, INT16_MAX, 0, INT16_MIN, -1, 0, 1, 
+    INT16_MIN, INT16_MIN,
+};
+
+static uint8_t arduino_codec_test_buf[ARDUINO_CODEC_MAX_LEN(256)];
+
+/* encodes the test samples, returns the length */
+static int
+arduino_codec_test_block(void)
+{
+    struct arduino_codec_hdr hdr;
+
+    hdr.entry_id = 21;
+    hdr.cnt = ARDUINO_CODEC_TEST_CNT;
+    hdr.stamp = UINT32_MAX;
+    hdr.period = UINT32_MAX;
+    return arduino_codec_encode(&hdr, arduino_codec_test_samples, 
+                                arduino_codec_test_buf, 
+                                ARDUINO_CODEC_MAX_LEN(ARDUINO_CODEC_TEST_CNT));
+}
+
+TEST_CASE(arduino_codec_test_extremes)
+{
+    struct arduino_codec_hdr hdr;
+    int16_t samples[ARDUINO_CODEC_TEST_CNT];
+    int len;
+    int rc;
+
+    len = arduino_codec_test_block();
+    TEST_ASSERT_FATAL(len > 0);
+    TEST_ASSERT(len <= ARDUINO_CODEC_MAX_LEN(ARDUINO_CODEC_TEST_CNT));
+
+    memset(samples, 0, sizeof(samples));
+    rc = arduino_codec_decode(arduino_codec_test_buf, len, &hdr, samples,
+                              ARDUINO_CODEC_TEST_CNT);
+    TEST_ASSERT(rc == len);
+    TEST_ASSERT(hdr.entry_id == 21);
+    TEST_ASSERT(hdr.cnt == ARDUINO_CODEC_TEST_CNT);
+    TEST_ASSERT(hdr.stamp == UINT32_MAX);
+    TEST_ASSERT(hdr.period == UINT32_MAX);
+    TEST_ASSERT(memcmp(samples, arduino_codec_test_samples, 
+                       sizeof(samples)) == 0);
+}
+
+TEST_CASE(arduino_codec_test_truncated)
+{
+    struct arduino_codec_hdr hdr;
+    int16_t samples[ARDUINO_CODEC_TEST_CNT];
+    int len;
+    int cut;
+    int rc;
+
+    len = arduino_codec_test_block();
+    TEST_ASSERT_FATAL(len > 0);
+
+    for (cut = 0; cut < len; cut++) {
+        rc = arduino_codec_decode(arduino_codec_test_buf, cut, &hdr, 
+                                  samples, ARDUINO_CODEC_TEST_CNT);
+        TEST_ASSERT(rc == -1);
+    }
+    /* the header alone is 6 bytes, the period 5 and the count 1 */
+    for (cut = 0; cut < 12; cut++) {
+        rc = arduino_codec_decode_hdr(arduino_codec_test_buf, cut, &hdr);
+        TEST_ASSERT(rc == -1);
+    }
+    TEST_ASSERT(arduino_codec_decode_hdr(arduino_codec_test_buf, 12, 
+                                         &hdr) == 12);
+
+    /* a buffer one byte short fails to encode, it does not overrun */
+    for (cut = 0; cut < len; cut++) {
+        memset(arduino_codec_test_buf, 0xa5, sizeof(arduino_codec_test_buf));
+        hdr.entry_id = 21;
+        hdr.cnt = ARDUINO_CODEC_TEST_CNT;
+        hdr.stamp = UINT32_MAX;
+        hdr.period = UINT32_MAX;
+        rc = arduino_codec_encode(&hdr, arduino_codec_test_samples, 
+                                  arduino_codec_test_buf, cut);
+        TEST_ASSERT(rc == -1);
+        TEST_ASSERT(arduino_codec_test_buf[cut] == 0xa5);
+    }
+}
+
+TEST_CASE(arduino_codec_test_cnt_max)
+{
+    struct arduino_codec_hdr hdr;
+    int16_t samples[ARDUINO_CODEC_TEST_CNT];
+    uint8_t buf[16];
+    int len;
+    int rc;
+
+    len = arduino_codec_test_block();
+    TEST_ASSERT_FATAL(len > 0);
+
+    rc = arduino_codec_decode(arduino_codec_test_buf, len, &hdr, samples, 
+                              ARDUINO_CODEC_TEST_CNT - 1);
+    TEST_ASSERT(rc == -1);
+    rc = arduino_codec_decode(arduino_codec_test_buf, len, &hdr, samples, 
+                              0);
+    TEST_ASSERT(rc == -1);
+
+    /* an empty block needs no room at all */
+    hdr.entry_id = 0;
+    hdr.cnt = 0;
+    hdr.stamp = 0;
+    hdr.period = 0;
+    len = arduino_codec_encode(&hdr, NULL, buf, sizeof(buf));
+    TEST_ASSERT(len == 8);
+    TEST_ASSERT(arduino_codec_decode(buf, len, &hdr, NULL, 0) == len);
+    TEST_ASSERT(hdr.cnt == 0);
+
+    /* a count past the 16 bits of the header */
+    memset(buf, 0, sizeof(buf));
+    buf[0] = ARDUINO_CODEC_VERSION;
+    buf[7] = 0x80;
+    buf[8] = 0x80;
+    buf[9] = 0x04;
+    TEST_ASSERT(arduino_codec_decode_hdr(buf, 10, &hdr) == -1);
+
+    /* a varint longer than 32 bits */
+    memset(buf, 0x80, sizeof(buf));
+    buf[0] = ARDUINO_CODEC_VERSION;
+    buf[11] = 0x01;
+    TEST_ASSERT(arduino_codec_decode_hdr(buf, sizeof(buf), &hdr) == -1);
+}
+
+TEST_CASE(arduino_codec_test_summary)
+{
+    struct arduino_codec_summary in;
+    struct arduino_codec_summary out;
+    uint8_t buf[ARDUINO_CODEC_SUMMARY_MAX];
+    int len;
+    int cut;
+
+    memset(&in, 0, sizeof(in));
+    in.entry_id = 21;
+    in.stamp = UINT32_MAX;
+    in.window = UINT32_MAX;
+    in.cnt = UINT32_MAX;
+    in.min = INT32_MIN;
+    in.max = INT32_MAX;
+    in.mean = 0;
+    len = arduino_codec_encode_summary(&in, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(len > 0);
+
+    memset(&out, 0, sizeof(out));
+    TEST_ASSERT(arduino_codec_decode_summary(buf, len, &out) == len);
+    TEST_ASSERT(memcmp(&in, &out, sizeof(in)) == 0);
+
+    for (cut = 0; cut < len; cut++) {
+        TEST_ASSERT(arduino_codec_decode_summary(buf, cut, &out) == -1);
+        TEST_ASSERT(arduino_codec_encode_summary(&in, buf, cut) == -1);
+    }
+
+    in.mean = INT32_MIN;
+    in.max = INT32_MIN;
+    TEST_ASSERT(arduino_codec_encode_summary(&in, buf, sizeof(buf)) > 0);
+    in.min = INT32_MAX;
+    TEST_ASSERT(arduino_codec_encode_summary(&in, buf, sizeof(buf)) == -1);
+}
+
+TEST_CASE(arduino_codec_test_snapshot)
+{
+    struct arduino_codec_snapshot in;
+    struct arduino_codec_snapshot out;
+    uint8_t buf[ARDUINO_CODEC_SNAPSHOT_MAX];
+    int len;
+    int cut;
+    int i;
+
+    /* the widest a snapshot of the 22 pins gets */
+    memset(&in, 0, sizeof(in));
+    in.flags = ARDUINO_CODEC_SNAP_ONE_PASS;
+    in.stamp = UINT32_MAX;
+    in.gpio_mask = 0x3fffff & ~(0x3fUL << 16);
+    in.gpio_levels = in.gpio_mask;
+    in.adc_mask = 0x3fUL << 16;
+    in.adc_delta = INT32_MIN;
+    for (i = 0; i < ARDUINO_CODEC_SNAPSHOT_ADC; i++) {
+        in.adc[i] = UINT16_MAX;
+    }
+    len = arduino_codec_encode_snapshot(&in, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(len > 0);
+
+    memset(&out, 0, sizeof(out));
+    TEST_ASSERT(arduino_codec_decode_snapshot(buf, len, &out) == len);
+    TEST_ASSERT(memcmp(&in, &out, sizeof(in)) == 0);
+
+    for (cut = 0; cut < len; cut++) {
+        TEST_ASSERT(arduino_codec_decode_snapshot(buf, cut, &out) == -1);
+        TEST_ASSERT(arduino_codec_encode_snapshot(&in, buf, cut) == -1);
+    }
+
+    /* more analog pins than the snapshot has values for */
+    in.adc_mask = 0x7fUL << 15;
+    TEST_ASSERT(arduino_codec_encode_snapshot(&in, buf, sizeof(buf)) == -1);
+    memset(buf, 0, sizeof(buf));
+    buf[0] = ARDUINO_CODEC_SNAPSHOT;
+    buf[7] = 0x7f;
+    TEST_ASSERT(arduino_codec_decode_snapshot(buf, sizeof(buf), &out) == -1);
+}
+
+TEST_SUITE(arduino_codec_test_all)
+{
+    arduino_codec_test_extremes();
+    arduino_codec_test_truncated();
+    arduino_codec_test_cnt_max();
+    arduino_codec_test_summary();
+    arduino_codec_test_snapshot();
+}
+
+#ifdef MYNEWT_SELFTEST
+
+int
+main(int argc, char **argv)
+{
+    tu_config.tc_print_results = 1;
+    tu_init();
+
+    arduino_codec_test_all();
+
+    return tu_any_failed;
+}
+
+#endif